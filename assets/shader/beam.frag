@@ -0,0 +1,145 @@
+#version 450
+
+// Beam prepass: one fragment per BEAM_TILE_SIZE x BEAM_TILE_SIZE tile of the raymarch pass.
+//
+// The ray through the tile center is traced through the bricks of level 0 as a cone that contains the
+// rays of every pixel in the tile. A pixel ray at camera depth z is at most z * tileRadius away from the
+// center ray point at the same depth, where tileRadius is the half diagonal of the tile in tangent space,
+// and that point is at least z along the center ray. So every brick the cone can touch while the center
+// ray crosses a brick lies in the brick box around that segment, widened by t * tileRadius.
+// The first occupied box ends the beam. Its distance along the center ray, shortened by the factor a ray
+// of the tile can be shorter than the center ray at the same depth, is written as the start distance
+// of all rays in the tile. Rays that miss level 0 before it simply skip the level.
+// The cone is traced through the level widened by MAX_CONE_RADIUS, a tile ray can enter the level
+// before its center ray does.
+//
+// Features, each compiled in as 0 or 1 by ShaderVariants:
+//   STATS    count beam steps into TraversalStatsBuffer
+#ifndef BRICK_SIZE
+#define BRICK_SIZE 8
+#endif
+#ifndef MAX_CLIP_LEVELS
+#define MAX_CLIP_LEVELS 8
+#endif
+#ifndef BEAM_TILE_SIZE
+#define BEAM_TILE_SIZE 8
+#endif
+#ifndef MAX_STEPS
+#define MAX_STEPS 200
+#endif
+
+#include "common/frame_constants.glsl"
+#include "common/brick_grid.glsl"
+
+layout(location = 0) out float outStart;
+
+// brick steps, voxel steps, pixels, beam steps
+layout(std430, binding = 6) buffer TraversalStatsBuffer {
+    uint traversalStats[];
+};
+
+// wider cones are stopped instead of testing more bricks per step, they only happen far away
+const float MAX_CONE_RADIUS = 1.0; // in bricks
+
+uint beamSteps = 0u;
+
+bool isBoxEmpty(ivec3 boxMin, ivec3 boxMax) {
+    for (int z = boxMin.z; z <= boxMax.z; z++) {
+        for (int y = boxMin.y; y <= boxMax.y; y++) {
+            for (int x = boxMin.x; x <= boxMax.x; x++) {
+                if (getBrickIndex(ivec3(x, y, z)) != 0xFFFFFFFFu) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ro and rd in bricks, t in world units from tStart. Returns the distance up to which the cone is empty.
+float traceBeam(vec3 ro, vec3 rd, float tStart, float maxDist, float coneSlope, float brickWorldSize) {
+    ivec3 brick = ivec3(floor(ro));
+    ivec3 stp = ivec3(sign(rd));
+
+    const float BIG = 1e30;
+
+    vec3 tMax;
+    vec3 tDelta;
+
+    if (stp.x > 0) { tMax.x = (float(brick.x) + 1.0 - ro.x) / rd.x; tDelta.x = 1.0 / rd.x; }
+    else if (stp.x < 0) { tMax.x = (ro.x - float(brick.x)) / (-rd.x); tDelta.x = 1.0 / (-rd.x); }
+    else { tMax.x = BIG; tDelta.x = BIG; }
+
+    if (stp.y > 0) { tMax.y = (float(brick.y) + 1.0 - ro.y) / rd.y; tDelta.y = 1.0 / rd.y; }
+    else if (stp.y < 0) { tMax.y = (ro.y - float(brick.y)) / (-rd.y); tDelta.y = 1.0 / (-rd.y); }
+    else { tMax.y = BIG; tDelta.y = BIG; }
+
+    if (stp.z > 0) { tMax.z = (float(brick.z) + 1.0 - ro.z) / rd.z; tDelta.z = 1.0 / rd.z; }
+    else if (stp.z < 0) { tMax.z = (ro.z - float(brick.z)) / (-rd.z); tDelta.z = 1.0 / (-rd.z); }
+    else { tMax.z = BIG; tDelta.z = BIG; }
+
+    float tEnter = 0.0;
+    for (int i = 0; i < MAX_STEPS; i++) {
+        beamSteps++;
+        if (tEnter >= maxDist) break;
+
+        // the part of the center ray inside this brick, widened by the cone at its far end
+        float tExit = min(tMax.x, min(tMax.y, tMax.z));
+        float radius = (tStart + tExit) * coneSlope / brickWorldSize;
+        if (radius > MAX_CONE_RADIUS) break;
+
+        vec3 entry = ro + rd * tEnter;
+        vec3 exit = ro + rd * tExit;
+        ivec3 boxMin = ivec3(floor(min(entry, exit) - radius));
+        ivec3 boxMax = ivec3(floor(max(entry, exit) + radius));
+        if (!isBoxEmpty(boxMin, boxMax)) break;
+
+        vec3 oldTMax = tMax;
+        bvec3 doStep = lessThanEqual(tMax, vec3(tExit + 1e-6));
+        if (doStep.x) { brick.x += stp.x; tMax.x += tDelta.x; }
+        if (doStep.y) { brick.y += stp.y; tMax.y += tDelta.y; }
+        if (doStep.z) { brick.z += stp.z; tMax.z += tDelta.z; }
+        tEnter = tExit;
+
+        if (all(equal(tMax, oldTMax))) break;
+    }
+
+    return tStart + min(tEnter, maxDist);
+}
+
+void main() {
+    // center of the tile in pixels of the raymarch pass
+    vec2 center = (floor(gl_FragCoord.xy) + 0.5) * float(BEAM_TILE_SIZE);
+    vec2 ndc = center / resolution * 2.0 - 1.0;
+
+    vec4 rayStartH = invViewProj * vec4(ndc, 0.0, 1.0);
+    vec4 rayEndH   = invViewProj * vec4(ndc, 1.0, 1.0);
+
+    vec3 roW = cameraPos;
+    vec3 rdW = normalize((rayEndH.xyz / max(rayEndH.w, 1e-6)) - (rayStartH.xyz / max(rayStartH.w, 1e-6)));
+
+    // half diagonal of the tile plus a pixel of margin, in tangent space
+    float coneSlope = (float(BEAM_TILE_SIZE) + 1.0) * 0.7072 * pixelAngle;
+
+    clipLevel = 0;
+    float levelScale = voxelScale;
+    float brickWorldSize = levelScale * float(BRICK_SIZE);
+
+    // beyond one brick around the level the cone cannot reach into it
+    float start = 0.0;
+    float tEnter, tExit;
+    vec3 margin = vec3(MAX_CONE_RADIUS * brickWorldSize);
+    vec3 levelMin = vec3(clipOrigins[0] * BRICK_SIZE) * levelScale;
+    vec3 levelMax = levelMin + vec3(gridSize * BRICK_SIZE) * levelScale;
+    if (intersectAABB(roW, rdW, levelMin - margin, levelMax + margin, tEnter, tExit)) {
+        float tStart = max(tEnter, 0.0);
+        vec3 roB = (roW + rdW * tStart) / brickWorldSize;
+        vec3 rdB = rdW / brickWorldSize;
+
+        // a ray of the tile reaches the same depth up to a factor of (1 - coneSlope) before the center ray
+        start = traceBeam(roB, rdB, tStart, tExit - tStart, coneSlope, brickWorldSize) * max(1.0 - coneSlope, 0.0);
+    }
+
+#if STATS
+    atomicAdd(traversalStats[3], beamSteps);
+#endif
+    outStart = start;
+}
@@ -0,0 +1,87 @@
+// Brick map lookups shared by the raymarch and beam programs.
+// BRICK_SIZE and MAX_CLIP_LEVELS have to be defined before this is included. A program that defines
+// OCCUPANCY_BITS also has to declare bool isCellOccupied(uint cell) covering every cell of the brick map,
+// empty bricks are then never looked up in the brick map.
+
+uniform ivec3 gridSize; // bricks per clip level
+
+// A plain brick map is a single level with its origin at 0.
+// Level l has voxels 2^l times the size of level 0 and is stored toroidally in the z-slab l of the grid.
+uniform int clipLevels;
+uniform ivec3 clipOrigins[MAX_CLIP_LEVELS]; // lowest brick of each level, in bricks of that level
+uniform ivec3 clipOffsets[MAX_CLIP_LEVELS]; // clipOrigins modulo gridSize
+
+layout(std430, binding = 0) buffer BrickMapBuffer {
+    uint brickMap[];
+};
+
+int clipLevel = 0;         // level being traced, all brick and voxel coordinates are in its units
+
+bool intersectAABB(vec3 ro, vec3 rd, vec3 boxMin, vec3 boxMax, out float tEnter, out float tExit) {
+    const float INF = 1e30;
+    const float EPS = 1e-12;
+
+    vec3 t1, t2;
+
+    // X axis
+    if (abs(rd.x) > EPS) {
+        float inv = 1.0 / rd.x;
+        t1.x = (boxMin.x - ro.x) * inv;
+        t2.x = (boxMax.x - ro.x) * inv;
+    } else {
+        if (ro.x < boxMin.x || ro.x > boxMax.x) return false; // Parallel and outside slab
+        t1.x = -INF; t2.x = INF; // Parallel and inside slab
+    }
+
+    // Y axis
+    if (abs(rd.y) > EPS) {
+        float inv = 1.0 / rd.y;
+        t1.y = (boxMin.y - ro.y) * inv;
+        t2.y = (boxMax.y - ro.y) * inv;
+    } else {
+        if (ro.y < boxMin.y || ro.y > boxMax.y) return false;
+        t1.y = -INF; t2.y = INF;
+    }
+
+    // Z axis
+    if (abs(rd.z) > EPS) {
+        float inv = 1.0 / rd.z;
+        t1.z = (boxMin.z - ro.z) * inv;
+        t2.z = (boxMax.z - ro.z) * inv;
+    } else {
+        if (ro.z < boxMin.z || ro.z > boxMax.z) return false;
+        t1.z = -INF; t2.z = INF;
+    }
+
+    vec3 tMin = min(t1, t2);
+    vec3 tMax = max(t1, t2);
+
+    tEnter = max(max(tMin.x, tMin.y), tMin.z);
+    tExit  = min(min(tMax.x, tMax.y), tMax.z);
+
+    return tExit >= max(tEnter, 0.0);
+}
+
+bool inClipWindow(ivec3 brickPos) {
+    ivec3 local = brickPos - clipOrigins[clipLevel];
+    return all(greaterThanEqual(local, ivec3(0))) && all(lessThan(local, gridSize));
+}
+
+// Index into brickMap of a brick inside the clip window.
+uint getCellIndex(ivec3 brickPos) {
+    ivec3 cell = (brickPos - clipOrigins[clipLevel] + clipOffsets[clipLevel]) % gridSize;
+    cell.z += clipLevel * gridSize.z;
+    return uint(cell.x + cell.y * gridSize.x + cell.z * gridSize.x * gridSize.y);
+}
+
+uint getBrickIndex(ivec3 brickPos) {
+    if (!inClipWindow(brickPos))
+        return 0xFFFFFFFFu;
+
+    uint index = getCellIndex(brickPos);
+#ifdef OCCUPANCY_BITS
+    if (!isCellOccupied(index))
+        return 0xFFFFFFFFu;
+#endif
+    return brickMap[index];
+}
@@ -0,0 +1,62 @@
+// Shadows of voxel faces kept from frame to frame, filled lazily by the passes that light hits.
+// The engine side is FaceLightCache, which also invalidates cells around edits (face_light_invalidate.comp).
+// Include after common/raymarch.glsl.
+
+// valid bits of the faces of a cell, followed by as many lit bits
+#define FACE_LIGHT_WORDS (BRICK_SIZE * BRICK_SIZE * BRICK_SIZE * 6 / 32)
+
+layout(std430, binding = 8) coherent buffer FaceLightSlotBuffer {
+    uint faceLightSlotCount;    // slots handed out
+    uint faceLightSlots[];      // slot + 1 of each brick map cell, 0 for none
+};
+
+layout(std430, binding = 9) coherent buffer FaceLightBuffer {
+    uint faceLightBits[];
+};
+
+uniform uint faceLightCapacity;
+
+// Slot of a cell, the first invocation to shade one of its faces takes a free one. -1 once all are taken.
+// The cache is per cell rather than per brick, deduplicated bricks share their voxels but not their shadows.
+int getFaceLightSlot(uint cell) {
+    uint slot = faceLightSlots[cell];
+    if (slot != 0u) return int(slot) - 1;
+    if (faceLightSlotCount >= faceLightCapacity) return -1;
+
+    slot = atomicAdd(faceLightSlotCount, 1u);
+    if (slot >= faceLightCapacity) return -1;
+
+    // another invocation may have claimed the cell meanwhile, the slot taken here is then lost until the next clear
+    uint previous = atomicCompSwap(faceLightSlots[cell], 0u, slot + 1u);
+    return previous == 0u ? int(slot) : int(previous) - 1;
+}
+
+// Light of the face a level 0 hit is on, 1 lit and 0 in shadow. The face is traced once from its center
+// and then read from the cache. -1 for hits that are not cached: clip levels above 0, LOD hits and faces
+// beyond SHADOW_DISTANCE.
+float getCachedLight(HitInfo hit, vec3 normal) {
+    if (clipLevel != 0 || hit.lod != 0) return -1.0;
+
+    vec3 center = (vec3(hit.voxelPos) + 0.5 + normal * 0.5) * levelScale;
+    if (length(center - cameraPos) >= SHADOW_DISTANCE) return -1.0;
+
+    ivec3 brickPos = floorDiv(hit.voxelPos, BRICK_SIZE);
+    if (!inClipWindow(brickPos)) return -1.0;
+    int slot = getFaceLightSlot(getCellIndex(brickPos));
+    if (slot < 0) return -1.0;
+
+    int axis = abs(normal.x) > 0.5 ? 0 : (abs(normal.y) > 0.5 ? 1 : 2);
+    uint face = getVoxelIndex(hit.voxelPos - brickPos * BRICK_SIZE) * 6u + uint(axis * 2) + (normal[axis] < 0.0 ? 1u : 0u);
+    uint word = uint(slot) * uint(2 * FACE_LIGHT_WORDS) + face / 32u;
+    uint bit = 1u << (face % 32u);
+
+    if ((faceLightBits[word] & bit) != 0u)
+        return (faceLightBits[word + uint(FACE_LIGHT_WORDS)] & bit) != 0u ? 1.0 : 0.0;
+
+    // the lit bit has to be visible before the valid bit, lit bits are zero after a clear or an invalidation
+    bool shadowed = isShadowed(center, normal);
+    if (!shadowed) atomicOr(faceLightBits[word + uint(FACE_LIGHT_WORDS)], bit);
+    memoryBarrierBuffer();
+    atomicOr(faceLightBits[word], bit);
+    return shadowed ? 0.0 : 1.0;
+}
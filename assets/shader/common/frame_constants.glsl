@@ -0,0 +1,15 @@
+// per-frame constants, must match FrameConstants in src/Rendering/FrameConstants.h
+layout(std140, binding = 0) uniform FrameConstants {
+    mat4 invViewProj;
+    vec3 cameraPos;
+    float time;
+    vec3 lightPos;
+    float voxelScale;
+    vec3 lightColor;
+    float lightIntensity;
+    vec2 resolution;
+    float pixelAngle; // world-space size of a pixel at unit distance
+    uint frameIndex; // counts up every frame, picks the pixels that skip reprojection
+    mat4 prevViewProj; // of the frame in the history target
+    vec2 prevResolution; // render size of that frame, 0 without a history
+};
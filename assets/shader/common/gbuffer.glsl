@@ -0,0 +1,38 @@
+// G-buffer the deferred raymarcher leaves in the scene target, read by the passes after it.
+// Include after common/raymarch.glsl.
+
+layout(r32f, binding = 1) uniform readonly image2D sceneDistance;
+layout(rgba32f, binding = 2) uniform readonly image2D sceneVoxel;
+layout(rgba16f, binding = 3) uniform readonly image2D sceneSurface; // face normal, material in w
+
+// Rebuilds the hit of a pixel, false where the ray missed. Leaves clipLevel and levelScale at the level
+// of the hit, as they would be right after the trace.
+bool loadHit(ivec2 pixel, out HitInfo hit, out uint material) {
+    float hitDistance = imageLoad(sceneDistance, pixel).r;
+    if (hitDistance <= 0.0) return false;
+
+    vec4 voxel = imageLoad(sceneVoxel, pixel);
+    vec4 surface = imageLoad(sceneSurface, pixel);
+
+    clipLevel = int(voxel.w) / 4;
+    levelScale = voxelScale * float(1 << clipLevel);
+
+    hit.hit = true;
+    hit.position = cameraPos + getPixelRay(vec2(pixel) + 0.5) * hitDistance;
+    hit.voxelPos = ivec3(voxel.xyz);
+    hit.normal = surface.xyz;
+    hit.lod = int(voxel.w) % 4;
+    material = uint(surface.w);
+    return true;
+}
+
+// The shadow pass traces one pixel out of every shadowScale x shadowScale block of the scene
+uniform int shadowScale;
+
+ivec2 getShadowSample(ivec2 shadowPixel) {
+    return min(shadowPixel * shadowScale + shadowScale / 2, ivec2(resolution) - 1);
+}
+
+ivec2 getShadowSize() {
+    return (ivec2(resolution) + shadowScale - 1) / shadowScale;
+}
@@ -0,0 +1,661 @@
+// Brick map traversal and shading, shared by the fragment (raymarch.frag) and compute (raymarch.comp)
+// raymarchers. Both define the features below as 0 or 1 before including it.
+//
+// Features:
+//   SHADOWS  trace a shadow ray from every hit
+//   LOD      trace distant bricks at their coarser LOD levels
+//   STATS    count traversal steps into TraversalStatsBuffer
+//   BEAM     start level 0 where the beam prepass (beam.frag) found the first brick of the pixel's tile
+//   TEMPORAL start just before the surface the previous frame saw where this pixel's ray ends
+//   DEFERRED only trace and write the G-buffer, lighting.comp shades it in a second pass
+// BRICK_SIZE, MAX_CLIP_LEVELS and BEAM_TILE_SIZE are defined by the application to match the engine.
+
+#ifndef BRICK_SIZE
+#define BRICK_SIZE 8
+#endif
+#ifndef MAX_CLIP_LEVELS
+#define MAX_CLIP_LEVELS 8
+#endif
+#ifndef BEAM_TILE_SIZE
+#define BEAM_TILE_SIZE 8
+#endif
+#ifndef MAX_STEPS
+#define MAX_STEPS 200
+#endif
+
+// beyond these distances the hit gets no shadow ray, a face normal and a cheaper specular term
+#ifndef SHADOW_DISTANCE
+#define SHADOW_DISTANCE 300.0
+#endif
+#ifndef SMOOTH_NORMAL_DISTANCE
+#define SMOOTH_NORMAL_DISTANCE 100.0
+#endif
+#ifndef SPECULAR_DISTANCE
+#define SPECULAR_DISTANCE 400.0
+#endif
+
+#include "frame_constants.glsl"
+#include "pbr.glsl"
+#include "brick_grid.glsl"
+
+#if BEAM
+uniform sampler2D beamDistances; // one texel per tile
+#endif
+
+#if TEMPORAL
+// scene target of the previous frame, see prevViewProj and prevResolution
+uniform sampler2D historyDistance;
+uniform sampler2D historyVoxel;     // hit voxel as written by raymarch()
+#endif
+
+vec4 background = vec4(0.1, 0.1, 0.8, 1.0);
+
+struct Brick {
+    uint64_t bitmask[(BRICK_SIZE * BRICK_SIZE * BRICK_SIZE) / 64];
+    uint materialOffset;
+};
+
+struct BrickLOD {
+    uint64_t level1;      // 4^3 occupancy
+    uint level2;          // 2^3 occupancy
+    uint materials2[2];   // one byte per voxel
+    uint materials1[16];
+};
+
+layout(std430, binding = 1) buffer BrickBuffer {
+    Brick bricks[];
+};
+
+layout(std430, binding = 2) buffer MaterialBuffer {
+    uint materials[];
+};
+
+layout(std430, binding = 5) buffer BrickLODBuffer {
+    BrickLOD brickLODs[];
+};
+
+// brick steps, voxel steps, pixels, beam steps, reprojected pixels, retraced pixels
+layout(std430, binding = 6) buffer TraversalStatsBuffer {
+    uint traversalStats[];
+};
+
+const float MAX_DIST = 1000.0;
+const int BRICK_LOD_LEVELS = 2;
+
+uint brickSteps = 0u;
+uint voxelSteps = 0u;
+bool reprojected = false;
+bool retraced = false;
+
+float levelScale = 1.0;    // world size of one voxel of clipLevel
+
+struct HitInfo {
+    bool hit;
+    vec3 position;
+    ivec3 voxelPos;
+    vec3 normal; // surface normal at hit
+    int lod;     // voxelPos is in voxels of this level
+};
+
+uint getVoxelIndex(ivec3 localPos) {
+    return localPos.x + localPos.y * BRICK_SIZE + localPos.z * BRICK_SIZE * BRICK_SIZE;
+}
+
+bool isVoxelSolid(uint brickIndex, uint voxelIndex) {
+    Brick brick = bricks[brickIndex];
+    uint64_t word = brick.bitmask[voxelIndex / 64];
+    return ((word >> (voxelIndex % 64)) & 1UL) != 0UL;
+}
+
+// integer division and modulo are undefined for negative operands in GLSL
+ivec3 floorDiv(ivec3 a, int b) {
+    return ivec3(floor(vec3(a) / float(b)));
+}
+
+bool isVoxelSolidGlobal(ivec3 globalVoxelPos) {
+    ivec3 brickCoord = floorDiv(globalVoxelPos, BRICK_SIZE);
+    ivec3 localPos   = globalVoxelPos - brickCoord * BRICK_SIZE;
+
+    uint brickIndex = getBrickIndex(brickCoord);
+    if (brickIndex == 0xFFFFFFFFu)
+        return false;
+    
+    uint voxelIndex = getVoxelIndex(localPos);
+    return isVoxelSolid(brickIndex, voxelIndex);
+}
+
+uint getMaterialIndex(uint brickIndex, uint voxelIndex) {
+    Brick brick = bricks[brickIndex];
+    uint count = 0;
+
+    for (int i = 0; i <= voxelIndex / 64; i++) {
+        uint64_t word = brick.bitmask[i];
+
+        // Mask out bits after the voxel index in the relevant word
+        if (i == voxelIndex / 64) {
+            uint64_t mask = (1UL << (voxelIndex % 64)) - 1;
+            word &= mask;
+        }
+
+        // Count the set bits in the word
+        uvec2 unpacked = unpackUint2x32(word);
+        count += bitCount(unpacked.x) + bitCount(unpacked.y);
+    }
+
+    return brick.materialOffset + count;
+}
+
+bool isVoxelSolidLOD(uint brickIndex, int lod, ivec3 voxel) {
+    if (lod == 0) return isVoxelSolid(brickIndex, getVoxelIndex(voxel));
+
+    int size = BRICK_SIZE >> lod;
+    uint index = uint(voxel.x + voxel.y * size + voxel.z * size * size);
+    if (lod == 1) return ((brickLODs[brickIndex].level1 >> index) & 1UL) != 0UL;
+    return ((brickLODs[brickIndex].level2 >> index) & 1u) != 0u;
+}
+
+uint getLODMaterial(uint brickIndex, int lod, ivec3 voxel) {
+    int size = BRICK_SIZE >> lod;
+    uint index = uint(voxel.x + voxel.y * size + voxel.z * size * size);
+    uint word = lod == 1 ? brickLODs[brickIndex].materials1[index / 4u] : brickLODs[brickIndex].materials2[index / 4u];
+    return (word >> ((index % 4u) * 8u)) & 0xFFu;
+}
+
+// coarsest level whose voxels still cover at most one pixel at the given distance
+int selectLOD(float dist) {
+#if !LOD
+    return 0;
+#endif
+    if (dist < 0.0) return 0;
+
+    float voxelsPerPixel = dist * pixelAngle / levelScale;
+    return clamp(int(floor(log2(max(voxelsPerPixel, 1.0)))), 0, BRICK_LOD_LEVELS);
+}
+
+void writeStats() {
+#if STATS
+    atomicAdd(traversalStats[0], brickSteps);
+    atomicAdd(traversalStats[1], voxelSteps);
+    atomicAdd(traversalStats[2], 1u);
+    if (reprojected) atomicAdd(traversalStats[4], 1u);
+    if (retraced) atomicAdd(traversalStats[5], 1u);
+#endif
+}
+
+vec3 estimateNormal(ivec3 voxelPos) {
+    vec3 normal = vec3(0.0);
+    
+    // Check adjacent voxels for normal estimation
+    bool solidX1 = isVoxelSolidGlobal(voxelPos + ivec3(1, 0, 0));
+    bool solidX0 = isVoxelSolidGlobal(voxelPos + ivec3(-1, 0, 0));
+    bool solidY1 = isVoxelSolidGlobal(voxelPos + ivec3(0, 1, 0));
+    bool solidY0 = isVoxelSolidGlobal(voxelPos + ivec3(0, -1, 0));
+    bool solidZ1 = isVoxelSolidGlobal(voxelPos + ivec3(0, 0, 1));
+    bool solidZ0 = isVoxelSolidGlobal(voxelPos + ivec3(0, 0, -1));
+    
+    normal.x = float(solidX0) - float(solidX1);
+    normal.y = float(solidY0) - float(solidY1);
+    normal.z = float(solidZ0) - float(solidZ1);
+
+    return normalize(normal);
+}
+
+// ro and rd in voxels of the given level. With anyHit only hit is set, for rays that only need to know
+// whether something is in the way.
+HitInfo traceBrick(vec3 ro, vec3 rd, vec3 originalRo, uint brickIndex, float totalDist, ivec3 brickPos, float maxDist, int lod, bool anyHit) {
+    int size = BRICK_SIZE >> lod;
+    ro = clamp(ro, vec3(1e-6), vec3(float(size) - 1e-6));
+    ivec3 voxel = ivec3(floor(ro));
+    ivec3 stp = ivec3(sign(rd));
+
+    const float BIG = 1e30;
+
+    // Standard Amanatides & Woo tMax/tDelta in world-distance units
+    vec3 tMax;
+    vec3 tDelta;
+
+    // X
+    if (stp.x > 0) {
+        tMax.x = (float(voxel.x) + 1.0 - ro.x) / rd.x;
+        tDelta.x = 1.0 / rd.x;
+    } else if (stp.x < 0) {
+        tMax.x = (ro.x - float(voxel.x)) / (-rd.x);
+        tDelta.x = 1.0 / (-rd.x);
+    } else {
+        tMax.x = BIG; tDelta.x = BIG;
+    }
+    // Y
+    if (stp.y > 0) {
+        tMax.y = (float(voxel.y) + 1.0 - ro.y) / rd.y;
+        tDelta.y = 1.0 / rd.y;
+    } else if (stp.y < 0) {
+        tMax.y = (ro.y - float(voxel.y)) / (-rd.y);
+        tDelta.y = 1.0 / (-rd.y);
+    } else {
+        tMax.y = BIG; tDelta.y = BIG;
+    }
+    // Z
+    if (stp.z > 0) {
+        tMax.z = (float(voxel.z) + 1.0 - ro.z) / rd.z;
+        tDelta.z = 1.0 / rd.z;
+    } else if (stp.z < 0) {
+        tMax.z = (ro.z - float(voxel.z)) / (-rd.z);
+        tDelta.z = 1.0 / (-rd.z);
+    } else {
+        tMax.z = BIG; tDelta.z = BIG;
+    }
+
+    float thisTotalDist = totalDist;
+
+    int iterations = 0;
+    const int MAX_BRICK_ITERATIONS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE; // Worst case
+    
+    while (voxel.x <= size - 1 && voxel.x >= 0 && voxel.y <= size - 1 && voxel.y >= 0 && voxel.z <= size - 1 && voxel.z >= 0) {
+        iterations++;
+        voxelSteps++;
+        if (iterations > MAX_BRICK_ITERATIONS) break; // Safety break
+
+        if (thisTotalDist > maxDist) break;
+
+        if (isVoxelSolidLOD(brickIndex, lod, voxel)) {
+            if (anyHit) return HitInfo(true, vec3(0), ivec3(0), vec3(0), lod);
+
+            // Exact boundary hit and normal
+            vec3 voxelMin = vec3(voxel);
+            vec3 voxelMax = vec3(voxel) + 1.0;
+
+            float tEntryX = rd.x != 0.0 ? ((stp.x > 0 ? voxelMin.x : voxelMax.x) - ro.x) / rd.x : -1e30;
+            float tEntryY = rd.y != 0.0 ? ((stp.y > 0 ? voxelMin.y : voxelMax.y) - ro.y) / rd.y : -1e30;
+            float tEntryZ = rd.z != 0.0 ? ((stp.z > 0 ? voxelMin.z : voxelMax.z) - ro.z) / rd.z : -1e30;
+            float tEntry = max(tEntryX, max(tEntryY, tEntryZ));
+
+            vec3 n = vec3(0.0);
+            if (tEntry == tEntryX) n = vec3(-sign(rd.x), 0.0, 0.0);
+            else if (tEntry == tEntryY) n = vec3(0.0, -sign(rd.y), 0.0);
+            else n = vec3(0.0, 0.0, -sign(rd.z));
+
+            vec3 brickLocalHit = ro + rd * tEntry;
+            vec3 worldHitPos = vec3(brickPos) * float(BRICK_SIZE) * levelScale + brickLocalHit * float(1 << lod) * levelScale;
+            
+            return HitInfo(true, worldHitPos, voxel + brickPos * size, n, lod);
+        }
+
+        ivec3 oldVoxel = voxel;
+
+        float minT = min(tMax.x, min(tMax.y, tMax.z));
+        bvec3 stepAxes = lessThanEqual(tMax, vec3(minT + 1e-6));
+        if (stepAxes.x) { voxel.x += stp.x; tMax.x += tDelta.x; }
+        if (stepAxes.y) { voxel.y += stp.y; tMax.y += tDelta.y; }
+        if (stepAxes.z) { voxel.z += stp.z; tMax.z += tDelta.z; }
+        thisTotalDist = totalDist + minT;
+
+        if (voxel == oldVoxel) break;
+    }
+    
+    return HitInfo(false, vec3(0), ivec3(0), vec3(0), 0);
+}
+
+// lodDist is the distance from the camera to ro, negative to always trace full resolution
+HitInfo traverseWorld(vec3 ro, vec3 rd, float maxDist, float lodDist, bool anyHit) {
+    ivec3 brick = ivec3(floor(ro));
+    ivec3 stp = ivec3(sign(rd));
+
+    const float BIG = 1e30;
+
+    // Standard Amanatides & Woo for bricks
+    vec3 tMax;
+    vec3 tDelta;
+
+    if (stp.x > 0) { tMax.x = (float(brick.x) + 1.0 - ro.x) / rd.x; tDelta.x = 1.0 / rd.x; }
+    else if (stp.x < 0) { tMax.x = (ro.x - float(brick.x)) / (-rd.x); tDelta.x = 1.0 / (-rd.x); }
+    else { tMax.x = BIG; tDelta.x = BIG; }
+
+    if (stp.y > 0) { tMax.y = (float(brick.y) + 1.0 - ro.y) / rd.y; tDelta.y = 1.0 / rd.y; }
+    else if (stp.y < 0) { tMax.y = (ro.y - float(brick.y)) / (-rd.y); tDelta.y = 1.0 / (-rd.y); }
+    else { tMax.y = BIG; tDelta.y = BIG; }
+
+    if (stp.z > 0) { tMax.z = (float(brick.z) + 1.0 - ro.z) / rd.z; tDelta.z = 1.0 / rd.z; }
+    else if (stp.z < 0) { tMax.z = (ro.z - float(brick.z)) / (-rd.z); tDelta.z = 1.0 / (-rd.z); }
+    else { tMax.z = BIG; tDelta.z = BIG; }
+    
+    float totalDist = 0.0;
+    for (int i = 0; i < MAX_STEPS; i++) {
+        brickSteps++;
+        uint brickIndex = getBrickIndex(brick);
+        if (!inClipWindow(brick)) break;
+        if (totalDist >= maxDist) break;
+
+        if (brickIndex != 0xFFFFFFFFu) {
+            // Robust brick entry via AABB
+            float bEnter, bExit;
+            vec3 bMin = vec3(brick);
+            vec3 bMax = bMin + 1.0;
+            if (intersectAABB(ro, rd, bMin, bMax, bEnter, bExit)) {
+                float tStart = max(bEnter, 0.0);
+                vec3 hitPos = ro + rd * tStart;
+                vec3 uv3d = hitPos - bMin; // [0,1]
+                uv3d = clamp(uv3d, vec3(1e-6), vec3(1.0) - vec3(1e-6));
+
+                int lod = lodDist < 0.0 ? 0 : selectLOD(lodDist + tStart);
+                float size = float(BRICK_SIZE >> lod);
+                HitInfo hit = traceBrick(uv3d * size, rd * size, ro, brickIndex, totalDist, brick, maxDist, lod, anyHit);
+                if (hit.hit) return hit;
+            }
+        }
+
+        // Advance to next brick face; step across all tied axes
+        vec3 oldTMax = tMax;
+        float minT = min(tMax.x, min(tMax.y, tMax.z));
+        bvec3 doStep = lessThanEqual(tMax, vec3(minT + 1e-6));
+        if (doStep.x) { brick.x += stp.x; tMax.x += tDelta.x; }
+        if (doStep.y) { brick.y += stp.y; tMax.y += tDelta.y; }
+        if (doStep.z) { brick.z += stp.z; tMax.z += tDelta.z; }
+        totalDist = minT;
+
+        if (all(equal(tMax, oldTMax))) break;
+    }
+    
+    return HitInfo(false, vec3(0), ivec3(0), vec3(0), 0);
+}
+
+HitInfo traceWorld(vec3 ro, vec3 rd, float maxDist, float lodDist) {
+    return traverseWorld(ro, rd, maxDist, lodDist, false);
+}
+
+// Whether anything solid is within maxDist, skipping the hit position and normal of traceWorld()
+bool traceAnyHit(vec3 ro, vec3 rd, float maxDist) {
+    return traverseWorld(ro, rd, maxDist, -1.0, true).hit;
+}
+
+// Traces the levels from the innermost outwards, level 0 from levelZeroStart and the others from start on.
+HitInfo traceLevels(vec3 roW, vec3 rdW, float levelZeroStart, float start) {
+    HitInfo hit = HitInfo(false, vec3(0), ivec3(0), vec3(0), 0);
+    vec3 epsilonVec = vec3(1e-3);
+
+    // levels are nested boxes, so each one only has to be traced from where the ray left the one inside it
+    float tInnerExit = 0.0;
+    for (int level = 0; level < clipLevels; level++) {
+        clipLevel = level;
+        levelScale = voxelScale * float(1 << level);
+
+        float tEnter, tExit;
+        vec3 levelMin = vec3(clipOrigins[level] * BRICK_SIZE) * levelScale;
+        vec3 levelMax = levelMin + vec3(gridSize * BRICK_SIZE) * levelScale;
+        if (!intersectAABB(roW, rdW, levelMin + epsilonVec, levelMax - epsilonVec, tEnter, tExit)) continue;
+
+        float tStart = max(max(tEnter, 0.0), tInnerExit);
+        tStart = max(tStart, level == 0 ? levelZeroStart : start);
+        tInnerExit = max(tInnerExit, tExit);
+        if (tStart >= tExit) continue;
+
+        // Convert to brick space for traversal, t stays in world units
+        float brickWorldSize = levelScale * float(BRICK_SIZE);
+        vec3 roB = (roW + rdW * tStart) / brickWorldSize;
+        vec3 rdB = rdW / brickWorldSize;
+
+        hit = traceWorld(roB, rdB, tExit - tStart, tStart);
+        if (hit.hit) break;
+    }
+    return hit;
+}
+
+#if TEMPORAL
+// voxels between the reprojected surface and where the traversal starts
+const float REPROJECTION_MARGIN = 2.0;
+// spread of the surface distances around the previous pixel, relative to the nearest, that counts as an edge
+const float DEPTH_DISCONTINUITY = 0.05;
+// voxels a surface seen further along the screen motion may be off this ray and still be taken as covering it
+const float OCCLUDER_TOLERANCE = 8.0;
+
+// Every pixel is traced in full once every 16 frames, in a 4x4 ordered pattern, so that surfaces the reprojection
+// skipped are found even when the camera stops. Through the history they then spread to the pixels around.
+const uint REFRESH_ORDER[16] = uint[16](0u, 8u, 2u, 10u, 12u, 4u, 14u, 6u, 3u, 11u, 1u, 9u, 15u, 7u, 13u, 5u);
+
+bool isRefreshPixel(vec2 pixel) {
+    ivec2 cell = ivec2(pixel) & 3;
+    return REFRESH_ORDER[cell.x + cell.y * 4] == frameIndex % 16u;
+}
+
+// pixel of the previous frame that saw the given world position
+bool findHistoryPixel(vec3 position, out ivec2 pixel) {
+    vec4 clip = prevViewProj * vec4(position, 1.0);
+    if (clip.w <= 0.0) return false;
+
+    pixel = ivec2(floor((clip.xy / clip.w * 0.5 + 0.5) * prevResolution));
+    return all(greaterThanEqual(pixel, ivec2(0))) && all(lessThan(pixel, ivec2(prevResolution)));
+}
+
+// xyz is the voxel in voxels of its LOD, w is clip level * 4 + LOD
+float getVoxelWorldSize(vec4 voxel) {
+    int level = int(voxel.w) / 4;
+    int lod = int(voxel.w) % 4;
+    return voxelScale * float(1 << (level + lod));
+}
+
+vec3 getVoxelCenter(vec4 voxel) {
+    return (voxel.xyz + 0.5) * getVoxelWorldSize(voxel);
+}
+
+bool isHistoryVoxelSolid(vec4 voxel) {
+    int level = int(voxel.w) / 4;
+    int lod = int(voxel.w) % 4;
+    if (level >= clipLevels) return false;
+
+    int size = BRICK_SIZE >> lod;
+    ivec3 voxelPos = ivec3(voxel.xyz);
+    ivec3 brick = floorDiv(voxelPos, size);
+
+    int tracedLevel = clipLevel;
+    clipLevel = level;
+    uint brickIndex = getBrickIndex(brick);
+    bool solid = brickIndex != 0xFFFFFFFFu && isVoxelSolidLOD(brickIndex, lod, voxelPos - brick * size);
+    clipLevel = tracedLevel;
+    return solid;
+}
+
+// Distance along the ray at which the surface the previous frame saw in this direction is at most
+// REPROJECTION_MARGIN voxels away, 0 if there is no such surface or it is gone.
+//
+// Where the ray ends is not known yet, so the previous hit distance of the same pixel is the first guess.
+// Reprojecting the guess gives the previous pixel and its voxel, whose center is a better guess.
+// The nearest of the surfaces around that pixel is used, something that was just outside the previous
+// pixel may now be in front of it, and so are nearer surfaces that moved over it. Where those surfaces
+// lie at very different distances the previous pixel is on an edge, and a surface hidden behind the
+// nearer side may come into view, so the ray is traced in full. What these checks miss is caught by the
+// refresh pixels.
+float reprojectStart(vec3 ro, vec3 rd, vec2 pixel) {
+    if (prevResolution.x <= 0.0 || isRefreshPixel(pixel)) return 0.0;
+
+    float t = texelFetch(historyDistance, ivec2(pixel * prevResolution / resolution), 0).r;
+    if (t <= 0.0) return 0.0;
+
+    ivec2 center;
+    vec4 voxel;
+    for (int i = 0; i < 2; i++) {
+        if (!findHistoryPixel(ro + rd * t, center)) return 0.0;
+        if (texelFetch(historyDistance, center, 0).r <= 0.0) return 0.0;
+
+        voxel = texelFetch(historyVoxel, center, 0);
+        t = dot(getVoxelCenter(voxel) - ro, rd);
+    }
+
+    // the voxel has to be on this ray and still be there
+    vec3 voxelCenter = getVoxelCenter(voxel);
+    if (t <= 0.0 || length(ro + rd * t - voxelCenter) > getVoxelWorldSize(voxel)) return 0.0;
+    if (!isHistoryVoxelSolid(voxel)) return 0.0;
+
+    float start = t;
+    float farthest = t;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            ivec2 neighbor = clamp(center + ivec2(x, y), ivec2(0), ivec2(prevResolution) - 1);
+            // nothing can be in front where the previous frame saw the sky
+            if (texelFetch(historyDistance, neighbor, 0).r <= 0.0) continue;
+
+            float distance = dot(getVoxelCenter(texelFetch(historyVoxel, neighbor, 0)) - ro, rd);
+            start = min(start, distance);
+            farthest = max(farthest, distance);
+        }
+    }
+
+    // Nearer surfaces move further on screen. Whatever now covers the surface was, in the previous frame, further
+    // along the line from where this pixel was to the surface's previous pixel: twice as far along it for a
+    // surface at half the distance. Surfaces up to four times nearer are looked for.
+    vec2 motion = vec2(center) - pixel * prevResolution / resolution;
+    for (int i = 1; i <= 3 && dot(motion, motion) >= 1.0; i++) {
+        ivec2 ahead = ivec2(vec2(center) + motion * float(i));
+        if (any(lessThan(ahead, ivec2(0))) || any(greaterThanEqual(ahead, ivec2(prevResolution)))) break;
+        if (texelFetch(historyDistance, ahead, 0).r <= 0.0) continue;
+
+        // only what lies on this ray can cover the surface
+        vec4 aheadVoxel = texelFetch(historyVoxel, ahead, 0);
+        float distance = dot(getVoxelCenter(aheadVoxel) - ro, rd);
+        if (length(ro + rd * distance - getVoxelCenter(aheadVoxel)) <= OCCLUDER_TOLERANCE * getVoxelWorldSize(aheadVoxel))
+            start = min(start, distance);
+    }
+
+    if (farthest - start > DEPTH_DISCONTINUITY * max(start, 0.0) + REPROJECTION_MARGIN * getVoxelWorldSize(voxel)) return 0.0;
+    return max(start - REPROJECTION_MARGIN * getVoxelWorldSize(voxel), 0.0);
+}
+#endif
+
+// World-space direction of the ray through a pixel, given in window coordinates like gl_FragCoord.xy.
+vec3 getPixelRay(vec2 pixel) {
+    vec2 uv = pixel / resolution;
+    vec2 ndc = uv * 2.0 - 1.0;
+
+    vec4 rayStartH = invViewProj * vec4(ndc, 0.0, 1.0);
+    vec4 rayEndH   = invViewProj * vec4(ndc, 1.0, 1.0);
+    return normalize((rayEndH.xyz / max(rayEndH.w, 1e-6)) - (rayStartH.xyz / max(rayStartH.w, 1e-6)));
+}
+
+// Traces the ray through a pixel from the camera, clipLevel and levelScale are left at the level of the hit.
+HitInfo tracePixel(vec2 pixel) {
+    vec3 roW = cameraPos;
+    vec3 rdW = getPixelRay(pixel);
+
+    float start = 0.0;
+#if TEMPORAL
+    start = reprojectStart(roW, rdW, pixel);
+    reprojected = start > 0.0;
+#endif
+    float beamStart = 0.0;
+#if BEAM
+    beamStart = texelFetch(beamDistances, ivec2(pixel) / BEAM_TILE_SIZE, 0).r;
+#endif
+
+    HitInfo hit = traceLevels(roW, rdW, max(start, beamStart), start);
+#if TEMPORAL
+    // the surface may have moved past the start, only a full trace is sure to find what is in front
+    if (!hit.hit && reprojected) {
+        retraced = true;
+        hit = traceLevels(roW, rdW, beamStart, 0.0);
+    }
+#endif
+    return hit;
+}
+
+// hit voxel in voxels of its LOD with clip level * 4 + LOD in w, the voxel ID of the G-buffer
+vec4 encodeHitVoxel(HitInfo hit) {
+    return vec4(vec3(hit.voxelPos), float(clipLevel * 4 + hit.lod));
+}
+
+uint getHitMaterial(HitInfo hit) {
+    int lodSize = BRICK_SIZE >> hit.lod;
+    ivec3 hitBrick = floorDiv(hit.voxelPos, lodSize);
+    ivec3 localVoxel = hit.voxelPos - hitBrick * lodSize;
+    uint brickIndex = getBrickIndex(hitBrick);
+    return hit.lod == 0
+        ? materials[getMaterialIndex(brickIndex, getVoxelIndex(localVoxel))]
+        : getLODMaterial(brickIndex, hit.lod, localVoxel);
+}
+
+// Whether the light is blocked from a hit within SHADOW_DISTANCE of the camera.
+// clipLevel and levelScale have to be those of its level.
+bool isShadowed(vec3 position, vec3 normal) {
+    float distToCamera = length(position - cameraPos);
+    if (distToCamera >= SHADOW_DISTANCE) return false;
+
+    // Keep modest bias; this is not trying to hide seams.
+    vec3 lightDir = normalize(lightPos - position);
+    float biasN = max(0.5 * levelScale, 0.01 * distToCamera);
+    float biasL = 0.5 * levelScale;
+    vec3 shadowRoW = position + normal * biasN + lightDir * biasL;
+    float maxShadowDistW = length(lightPos - position);
+    vec3 shadowRoB = shadowRoW / (levelScale * float(BRICK_SIZE));
+    vec3 lightDirB = lightDir / (levelScale * float(BRICK_SIZE));
+    return traceAnyHit(shadowRoB, lightDirB, maxShadowDistW);
+}
+
+// Lights a hit, clipLevel and levelScale have to be those of its level.
+// lit is the fraction of the light that reaches it, 0 in shadow.
+vec4 shade(HitInfo hit, uint material, float lit) {
+    vec3 lightDir = normalize(lightPos - hit.position);
+    vec3 normal = normalize(hit.normal);
+    float distToCamera = length(hit.position - cameraPos);
+
+    if (distToCamera > SMOOTH_NORMAL_DISTANCE && hit.lod == 0) normal = estimateNormal(hit.voxelPos);
+
+    MaterialInfo mat = materialInfos[int(material)];
+    vec4 baseColor = mat.albedo;
+
+    // PBR lighting
+    vec3 V = normalize(cameraPos - hit.position);
+    vec3 H = normalize(lightDir + V);
+    float NdotL = max(dot(normal, lightDir), 0.0);
+    float NdotV = max(dot(normal, V), 0.0);
+    float HdotV = max(dot(H, V), 0.0);
+    vec3 F0 = mix(vec3(0.04), baseColor.rgb, mat.metallic);
+
+    vec3 specular = vec3(0.0);
+    if (distToCamera < SPECULAR_DISTANCE) {
+        float NDF = distributionGGX(normal, H, mat.roughness);
+        float G = geometrySmith(normal, V, lightDir, mat.roughness);
+        vec3 F = fresnelSchlick(HdotV, F0);
+        vec3 numerator = NDF * G * F;
+        float denominator = 4.0 * NdotV * NdotL + 0.0001;
+        specular = numerator / denominator;
+    } else {
+        specular = F0 * pow(max(dot(normal, H), 0.0), 16.0);
+    }
+
+    vec3 kS = specular;
+    vec3 kD = (vec3(1.0) - kS) * (1.0 - mat.metallic);
+    vec3 ambient = baseColor.rgb * 0.1;
+    vec3 diffuse = kD * baseColor.rgb / PI;
+    vec3 lighting = (diffuse + specular) * lightColor * NdotL * lightIntensity;
+    vec3 finalColor = ambient + lighting * lit;
+    return vec4(finalColor, baseColor.a);
+}
+
+// Traces and shades the ray through a pixel, given in window coordinates like gl_FragCoord.xy.
+// Returns false if it hit nothing, color, hitDistance and hitVoxel are only written on a hit.
+bool raymarch(vec2 pixel, out vec4 color, out float hitDistance, out vec4 hitVoxel) {
+    HitInfo hit = tracePixel(pixel);
+    if (hit.hit) {
+        float lit = 1.0;
+#if SHADOWS
+        lit = isShadowed(hit.position, normalize(hit.normal)) ? 0.0 : 1.0;
+#endif
+        color = shade(hit, getHitMaterial(hit), lit);
+        hitDistance = length(hit.position - cameraPos);
+        hitVoxel = encodeHitVoxel(hit);
+    }
+
+    // the steps of the shadow ray are counted too
+    writeStats();
+    return hit.hit;
+}
+
+// Only traces the ray through a pixel and writes what lighting.comp needs to shade it later.
+// hitSurface is the face normal with the material index in w.
+bool raymarchVisibility(vec2 pixel, out float hitDistance, out vec4 hitVoxel, out vec4 hitSurface) {
+    HitInfo hit = tracePixel(pixel);
+    writeStats();
+    if (!hit.hit) return false;
+
+    hitDistance = length(hit.position - cameraPos);
+    hitVoxel = encodeHitVoxel(hit);
+    hitSurface = vec4(hit.normal, float(getHitMaterial(hit)));
+    return true;
+}
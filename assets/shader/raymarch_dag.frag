@@ -0,0 +1,178 @@
+#version 450
+
+// Features, each compiled in as 0 or 1 by ShaderVariants:
+//   SHADOWS  trace a shadow ray from every hit
+#ifndef BRICK_SIZE
+#define BRICK_SIZE 8
+#endif
+#ifndef MAX_STEPS
+#define MAX_STEPS 512
+#endif
+#ifndef SHADOW_DISTANCE
+#define SHADOW_DISTANCE 300.0
+#endif
+
+#include "common/frame_constants.glsl"
+#include "common/pbr.glsl"
+
+layout(location = 0) out vec4 outColor;
+// hit distance for the upscale pass, dropped when drawing straight to the window
+layout(location = 1) out float outDistance;
+
+uniform ivec3 gridSize;
+uniform int dagDepth;
+
+// interior node: child mask in the low 8 bits followed by one offset per child
+// leaf: two words holding the materials of a 2x2x2 block
+layout(std430, binding = 4) buffer DAGBuffer {
+    uint dagNodes[];
+};
+
+
+struct HitInfo {
+    bool hit;
+    vec3 position;
+    ivec3 voxelPos;
+    vec3 normal;
+    uint material;
+};
+
+bool intersectAABB(vec3 ro, vec3 rd, vec3 boxMin, vec3 boxMax, out float tEnter, out float tExit) {
+    vec3 invRd = 1.0 / rd;
+    vec3 t1 = (boxMin - ro) * invRd;
+    vec3 t2 = (boxMax - ro) * invRd;
+
+    vec3 tMin = min(t1, t2);
+    vec3 tMax = max(t1, t2);
+
+    tEnter = max(max(tMin.x, tMin.y), tMin.z);
+    tExit  = min(min(tMax.x, tMax.y), tMax.z);
+
+    return tExit >= max(tEnter, 0.0);
+}
+
+// Descends from the root to the deepest node containing p.
+// Returns the voxel material (0 = air) and the edge length of the empty or solid cell that contains p.
+uint lookupDAG(ivec3 p, out int cellSize) {
+    uint node = 0u;
+    int size = 1 << dagDepth;
+
+    for (int level = 0; level < dagDepth - 1; level++) {
+        size >>= 1;
+        int shift = dagDepth - level - 1;
+        uint mask = dagNodes[node] & 0xFFu;
+        uint slot = uint(((p.x >> shift) & 1) | (((p.y >> shift) & 1) << 1) | (((p.z >> shift) & 1) << 2));
+
+        if ((mask & (1u << slot)) == 0u) {
+            cellSize = size;
+            return 0u;
+        }
+
+        node = dagNodes[node + 1u + uint(bitCount(mask & ((1u << slot) - 1u)))];
+    }
+
+    uint slot = uint((p.x & 1) | ((p.y & 1) << 1) | ((p.z & 1) << 2));
+    cellSize = 1;
+    return (dagNodes[node + slot / 4u] >> ((slot % 4u) * 8u)) & 0xFFu;
+}
+
+// ro and rd in voxel units, ro inside the grid
+HitInfo traceDAG(vec3 ro, vec3 rd, float maxDist) {
+    ivec3 extent = gridSize * BRICK_SIZE;
+    vec3 invRd = 1.0 / rd;
+    vec3 stp = sign(rd);
+
+    float t = 0.0;
+    vec3 normal = vec3(0.0);
+
+    for (int i = 0; i < MAX_STEPS; i++) {
+        if (t > maxDist) break;
+
+        vec3 p = ro + rd * t;
+        ivec3 voxel = ivec3(floor(p + stp * 1e-4));
+        if (any(lessThan(voxel, ivec3(0))) || any(greaterThanEqual(voxel, extent))) break;
+
+        int cellSize;
+        uint material = lookupDAG(voxel, cellSize);
+        if (material != 0u) {
+            return HitInfo(true, p * voxelScale, voxel, normal, material);
+        }
+
+        // skip the whole empty cell
+        vec3 cellMin = vec3((voxel / cellSize) * cellSize);
+        vec3 cellMax = cellMin + float(cellSize);
+        vec3 tExit = ((mix(cellMin, cellMax, step(0.0, rd))) - ro) * invRd;
+
+        float tNext = min(tExit.x, min(tExit.y, tExit.z));
+        if (tNext == tExit.x) normal = vec3(-stp.x, 0.0, 0.0);
+        else if (tNext == tExit.y) normal = vec3(0.0, -stp.y, 0.0);
+        else normal = vec3(0.0, 0.0, -stp.z);
+
+        t = max(tNext, t + 1e-4);
+    }
+
+    return HitInfo(false, vec3(0), ivec3(0), vec3(0), 0u);
+}
+
+void main() {
+    vec2 uv = gl_FragCoord.xy / resolution;
+    vec2 ndc = uv * 2.0 - 1.0;
+
+    vec4 rayStartH = invViewProj * vec4(ndc, 0.0, 1.0);
+    vec4 rayEndH   = invViewProj * vec4(ndc, 1.0, 1.0);
+
+    vec3 roW = cameraPos;
+    vec3 rdW = normalize((rayEndH.xyz / max(rayEndH.w, 1e-6)) - (rayStartH.xyz / max(rayStartH.w, 1e-6)));
+
+    float tEnter, tExit;
+    vec3 worldSize = vec3(gridSize * BRICK_SIZE) * voxelScale;
+    if (!intersectAABB(roW, rdW, vec3(1e-3), worldSize - vec3(1e-3), tEnter, tExit)) {
+        discard;
+    }
+
+    vec3 roV = (roW + rdW * max(tEnter, 0.0)) / voxelScale;
+    float maxDistV = (tExit - max(tEnter, 0.0)) / voxelScale;
+
+    HitInfo hit = traceDAG(roV, rdW, maxDistV);
+    if (!hit.hit) {
+        discard;
+    }
+
+    vec3 lightDir = normalize(lightPos - hit.position);
+    vec3 normal = hit.normal;
+    if (normal == vec3(0.0)) normal = -rdW;
+
+    bool inShadow = false;
+    float distToCamera = length(hit.position - cameraPos);
+#if SHADOWS
+    if (distToCamera < SHADOW_DISTANCE) {
+        vec3 shadowRoV = hit.position / voxelScale + normal * 0.5 + lightDir * 0.5;
+        float maxShadowDistV = length(lightPos - hit.position) / voxelScale;
+        inShadow = traceDAG(shadowRoV, lightDir, maxShadowDistV).hit;
+    }
+#endif
+
+    MaterialInfo mat = materialInfos[int(hit.material)];
+    vec4 baseColor = mat.albedo;
+
+    vec3 V = normalize(cameraPos - hit.position);
+    vec3 H = normalize(lightDir + V);
+    float NdotL = max(dot(normal, lightDir), 0.0);
+    float NdotV = max(dot(normal, V), 0.0);
+    float HdotV = max(dot(H, V), 0.0);
+    vec3 F0 = mix(vec3(0.04), baseColor.rgb, mat.metallic);
+
+    float NDF = distributionGGX(normal, H, mat.roughness);
+    float G = geometrySmith(normal, V, lightDir, mat.roughness);
+    vec3 F = fresnelSchlick(HdotV, F0);
+    vec3 specular = (NDF * G * F) / (4.0 * NdotV * NdotL + 0.0001);
+
+    vec3 kD = (vec3(1.0) - specular) * (1.0 - mat.metallic);
+    vec3 finalColor = baseColor.rgb * 0.1;
+    if (!inShadow) {
+        vec3 diffuse = kD * baseColor.rgb / PI;
+        finalColor += (diffuse + specular) * lightColor * NdotL * lightIntensity;
+    }
+    outColor = vec4(finalColor, baseColor.a);
+    outDistance = distToCamera;
+}
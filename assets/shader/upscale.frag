@@ -0,0 +1,57 @@
+#version 450
+
+// Upscales the scene rendered into the lower left sourceSize pixels of the scene target to the output.
+//
+// Bilinear filtering would blur every silhouette, mixing the terrain with the sky or a near hill with
+// the one behind it. The four source pixels around an output pixel are weighted bilinearly, but pixels
+// whose hit distance differs from the nearest one are faded out. Within a surface this is bilinear,
+// across an edge it keeps the side the output pixel is on.
+
+layout(location = 0) out vec4 outColor;
+
+uniform sampler2D sceneColor;
+uniform sampler2D sceneDistance; // distance to the hit, 0 where the ray missed
+uniform vec2 sourceSize;
+uniform vec2 outputSize;
+
+const float MISS_DISTANCE = 1e6;
+// how fast a relative difference in hit distance fades a pixel out
+const float EDGE_SHARPNESS = 16.0;
+
+float loadDistance(ivec2 pixel) {
+    float dist = texelFetch(sceneDistance, pixel, 0).r;
+    return dist > 0.0 ? dist : MISS_DISTANCE;
+}
+
+void main() {
+    vec2 position = gl_FragCoord.xy * (sourceSize / outputSize) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+    ivec2 maxPixel = ivec2(sourceSize) - 1;
+
+    const ivec2 offsets[4] = ivec2[](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(1, 1));
+    float bilinear[4] = float[](
+        (1.0 - f.x) * (1.0 - f.y),
+        f.x * (1.0 - f.y),
+        (1.0 - f.x) * f.y,
+        f.x * f.y
+    );
+
+    // the nearest source pixel decides which surface the output pixel is on
+    ivec2 nearest = clamp(ivec2(floor(position + 0.5)), ivec2(0), maxPixel);
+    float reference = loadDistance(nearest);
+
+    vec4 color = vec4(0.0);
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 pixel = clamp(base + offsets[i], ivec2(0), maxPixel);
+        float difference = abs(loadDistance(pixel) - reference) / reference;
+        float weight = bilinear[i] * exp(-EDGE_SHARPNESS * difference);
+
+        color += texelFetch(sceneColor, pixel, 0) * weight;
+        totalWeight += weight;
+    }
+
+    // the nearest pixel is always among the four with a weight of at least 1/4
+    outColor = color / max(totalWeight, 1e-6);
+}
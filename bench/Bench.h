@@ -0,0 +1,303 @@
+#ifndef VXE_BENCH_H
+#define VXE_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vxe::bench {
+    /// @brief Timings of one benchmark case, one sample per repetition.
+    struct CaseResult {
+        std::string name;
+        size_t operations;          // work items per repetition, for per-operation numbers
+        std::vector<double> samples; // nanoseconds per repetition, sorted
+
+        double percentile(double p) const {
+            if (samples.empty()) return 0.0;
+            double rank = p * (samples.size() - 1);
+            size_t low = (size_t) std::floor(rank);
+            size_t high = std::min(low + 1, samples.size() - 1);
+            return samples[low] + (samples[high] - samples[low]) * (rank - low);
+        }
+
+        double median() const { return percentile(0.5); }
+        double nsPerOperation() const { return median() / std::max<size_t>(operations, 1); }
+    };
+
+    /// @brief Parsed JSON, just enough to read back a report.
+    struct JSONValue {
+        enum Type { NONE, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT } type = NONE;
+        double number = 0.0;
+        std::string text;
+        std::vector<JSONValue> items;               // array elements or object values
+        std::vector<std::string> keys;              // object keys, parallel to items
+
+        const JSONValue* find(const std::string& key) const {
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (keys[i] == key) return &items[i];
+            }
+            return nullptr;
+        }
+    };
+
+    /// @brief Recursive descent JSON parser. Rejects malformed input instead of guessing.
+    struct JSONReader {
+        const std::string& text;
+        size_t position = 0;
+
+        bool parse(JSONValue& value) {
+            if (!parseValue(value)) return false;
+            skipSpace();
+            return position == text.size();
+        }
+
+        void skipSpace() {
+            while (position < text.size() && std::isspace((unsigned char) text[position])) position++;
+        }
+
+        bool consume(char c) {
+            skipSpace();
+            if (position >= text.size() || text[position] != c) return false;
+            position++;
+            return true;
+        }
+
+        bool consumeWord(const char* word) {
+            size_t length = std::strlen(word);
+            if (text.compare(position, length, word) != 0) return false;
+            position += length;
+            return true;
+        }
+
+        bool parseValue(JSONValue& value) {
+            skipSpace();
+            if (position >= text.size()) return false;
+
+            char c = text[position];
+            if (c == '{') return parseObject(value);
+            if (c == '[') return parseArray(value);
+            if (c == '"') { value.type = JSONValue::STRING; return parseString(value.text); }
+            if (consumeWord("true")) { value.type = JSONValue::BOOLEAN; value.number = 1.0; return true; }
+            if (consumeWord("false")) { value.type = JSONValue::BOOLEAN; return true; }
+            if (consumeWord("null")) { value.type = JSONValue::NONE; return true; }
+
+            const char* begin = text.c_str() + position;
+            char* end = nullptr;
+            value.number = std::strtod(begin, &end);
+            if (end == begin) return false;
+            value.type = JSONValue::NUMBER;
+            position += end - begin;
+            return true;
+        }
+
+        bool parseString(std::string& out) {
+            if (!consume('"')) return false;
+            while (position < text.size() && text[position] != '"') {
+                char c = text[position++];
+                if (c == '\\') {
+                    if (position >= text.size()) return false;
+                    char escaped = text[position++];
+                    switch (escaped) {
+                        case 'n': c = '\n'; break;
+                        case 't': c = '\t'; break;
+                        case 'r': c = '\r'; break;
+                        case 'b': c = '\b'; break;
+                        case 'f': c = '\f'; break;
+                        // case names are ASCII, other code points are kept as the escape
+                        case 'u': out += "\\u"; continue;
+                        default: c = escaped; break;
+                    }
+                }
+                out += c;
+            }
+            return consume('"');
+        }
+
+        bool parseArray(JSONValue& value) {
+            value.type = JSONValue::ARRAY;
+            consume('[');
+            if (consume(']')) return true;
+
+            do {
+                value.items.emplace_back();
+                if (!parseValue(value.items.back())) return false;
+            } while (consume(','));
+
+            return consume(']');
+        }
+
+        bool parseObject(JSONValue& value) {
+            value.type = JSONValue::OBJECT;
+            consume('{');
+            if (consume('}')) return true;
+
+            do {
+                value.keys.emplace_back();
+                value.items.emplace_back();
+                skipSpace();
+                if (!parseString(value.keys.back()) || !consume(':') || !parseValue(value.items.back())) return false;
+            } while (consume(','));
+
+            return consume('}');
+        }
+    };
+
+    /// @brief Runs benchmark cases and reports them as JSON.
+    ///
+    /// Options:
+    ///   --filter <text>      only run cases whose name contains text
+    ///   --repetitions <n>    override the repetition count of every case
+    ///   --out <file>         write the JSON report to file instead of stdout
+    ///   --baseline <file>    compare medians against an earlier report
+    ///   --threshold <ratio>  slowdown that counts as a regression in baseline mode (default 0.10)
+    class Runner {
+        public:
+            Runner(int argc, char** argv) {
+                for (int i = 1; i < argc; i++) {
+                    std::string arg = argv[i];
+                    bool hasValue = i + 1 < argc;
+
+                    if (arg == "--filter" && hasValue) m_filter = argv[++i];
+                    else if (arg == "--repetitions" && hasValue) m_repetitions = std::atoi(argv[++i]);
+                    else if (arg == "--out" && hasValue) m_outPath = argv[++i];
+                    else if (arg == "--baseline" && hasValue) m_baselinePath = argv[++i];
+                    else if (arg == "--threshold" && hasValue) m_threshold = std::atof(argv[++i]);
+                    else std::fprintf(stderr, "ignoring unknown argument '%s'\n", arg.c_str());
+                }
+            }
+
+            /// @brief Times body repetitions times, calling the untimed setup before every repetition.
+            void run(const std::string& name, int repetitions, size_t operations,
+                const std::function<void()>& setup, const std::function<void()>& body) {
+                if (!m_filter.empty() && name.find(m_filter) == std::string::npos) return;
+                if (m_repetitions > 0) repetitions = m_repetitions;
+
+                CaseResult result{name, operations, {}};
+                for (int i = 0; i < repetitions; i++) {
+                    if (setup) setup();
+
+                    auto start = std::chrono::steady_clock::now();
+                    body();
+                    auto end = std::chrono::steady_clock::now();
+
+                    result.samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+                }
+
+                std::sort(result.samples.begin(), result.samples.end());
+                std::fprintf(stderr, "%-32s median %12.0f ns  (%.2f ns/op)\n", name.c_str(), result.median(), result.nsPerOperation());
+                m_results.push_back(std::move(result));
+            }
+
+            /// @brief Writes the report and compares against the baseline if one was given.
+            /// @return the process exit code, non-zero if a case regressed past the threshold.
+            int finish() {
+                std::string json = toJSON();
+                if (m_outPath.empty()) {
+                    std::printf("%s", json.c_str());
+                } else {
+                    std::ofstream out(m_outPath);
+                    out << json;
+                }
+
+                if (m_baselinePath.empty()) return 0;
+                return compareBaseline();
+            }
+
+        private:
+            std::string m_filter;
+            int m_repetitions = 0;
+            std::string m_outPath;
+            std::string m_baselinePath;
+            double m_threshold = 0.10;
+            std::vector<CaseResult> m_results;
+
+            std::string toJSON() const {
+                std::ostringstream out;
+                out << "{\n  \"cases\": [\n";
+                for (size_t i = 0; i < m_results.size(); i++) {
+                    const CaseResult& r = m_results[i];
+                    out << "    {\"name\": " << quote(r.name)
+                        << ", \"repetitions\": " << r.samples.size()
+                        << ", \"operations\": " << r.operations
+                        << ", \"median_ns\": " << (uint64_t) r.median()
+                        << ", \"p10_ns\": " << (uint64_t) r.percentile(0.1)
+                        << ", \"p90_ns\": " << (uint64_t) r.percentile(0.9)
+                        << ", \"p99_ns\": " << (uint64_t) r.percentile(0.99)
+                        << ", \"min_ns\": " << (uint64_t) r.samples.front()
+                        << ", \"max_ns\": " << (uint64_t) r.samples.back()
+                        << ", \"ns_per_op\": " << r.nsPerOperation()
+                        << "}" << (i + 1 < m_results.size() ? "," : "") << "\n";
+                }
+                out << "  ]\n}\n";
+                return out.str();
+            }
+
+            static std::string quote(const std::string& text) {
+                std::string quoted = "\"";
+                for (char c : text) {
+                    if (c == '"' || c == '\\') quoted += '\\';
+                    quoted += c;
+                }
+                return quoted + "\"";
+            }
+
+            // reads back the median of every case from a report, the layout may differ from toJSON() as
+            // long as it is JSON with a "cases" array of objects holding "name" and "median_ns"
+            static std::unordered_map<std::string, double> readMedians(const std::string& path) {
+                std::unordered_map<std::string, double> medians;
+                std::ifstream in(path);
+                std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+                JSONReader reader{text};
+                JSONValue report;
+                if (!reader.parse(report) || report.find("cases") == nullptr) return medians;
+
+                for (const JSONValue& c : report.find("cases")->items) {
+                    const JSONValue* name = c.find("name");
+                    const JSONValue* median = c.find("median_ns");
+                    if (name && median && name->type == JSONValue::STRING && median->type == JSONValue::NUMBER)
+                        medians[name->text] = median->number;
+                }
+
+                return medians;
+            }
+
+            int compareBaseline() const {
+                auto baseline = readMedians(m_baselinePath);
+                if (baseline.empty()) {
+                    std::fprintf(stderr, "could not read baseline '%s'\n", m_baselinePath.c_str());
+                    return 2;
+                }
+
+                int regressions = 0;
+                std::fprintf(stderr, "\n%-32s %14s %14s %9s\n", "case", "baseline [ns]", "current [ns]", "change");
+                for (const auto& r : m_results) {
+                    auto it = baseline.find(r.name);
+                    if (it == baseline.end()) {
+                        std::fprintf(stderr, "%-32s %14s %14.0f %9s\n", r.name.c_str(), "-", r.median(), "new");
+                        continue;
+                    }
+
+                    double change = r.median() / it->second - 1.0;
+                    bool regressed = change > m_threshold;
+                    regressions += regressed;
+                    std::fprintf(stderr, "%-32s %14.0f %14.0f %+8.1f%%%s\n", r.name.c_str(), it->second, r.median(), change * 100.0, regressed ? "  REGRESSION" : "");
+                }
+
+                return regressions > 0 ? 1 : 0;
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,116 @@
+// Headless comparison of the grid backends: generation time, memory footprint and random access.
+// Usage: GridBench [bricksX bricksY bricksZ] [lookups]
+
+#include "vxe/DataStructures/BrickMap.h"
+#include "vxe/DataStructures/RLEColumnGrid.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct BenchResult {
+    std::string name;
+    double generationMs;
+    size_t bytes;
+    double lookupNs;
+    double conversionMs;
+    uint64_t checksum;
+};
+
+static BenchResult runBench(const std::string& name, vxe::GridType type, const glm::ivec3& dimensions, const std::vector<glm::ivec3>& lookups) {
+    BenchResult result{name};
+    auto grid = vxe::Grid::create(type, dimensions);
+
+    auto start = Clock::now();
+    for (int z = 0; z < dimensions.z; z++) {
+        for (int y = 0; y < dimensions.y; y++) {
+            for (int x = 0; x < dimensions.x; x++) {
+                grid->generateChunk(glm::ivec3(x, y, z));
+            }
+        }
+    }
+    result.generationMs = millisecondsSince(start);
+    result.bytes = grid->getSizeInBytes();
+
+    // sum the materials so the lookups cannot be optimized away and both grids can be compared
+    uint64_t checksum = 0;
+    start = Clock::now();
+    for (const auto& position : lookups) {
+        checksum = checksum * 31 + static_cast<uint64_t>(grid->getVoxel(position));
+    }
+    result.lookupNs = millisecondsSince(start) * 1e6 / lookups.size();
+    result.checksum = checksum;
+
+    // the part of uploadToGPU() that runs on the CPU: producing dense bricks
+    vxe::Material voxels[vxe::VOXELS_PER_BRICK];
+    size_t solidBricks = 0;
+    start = Clock::now();
+    for (int z = 0; z < dimensions.z; z++) {
+        for (int y = 0; y < dimensions.y; y++) {
+            for (int x = 0; x < dimensions.x; x++) {
+                bool solid = false;
+                if (type == vxe::GridType::BRICK_MAP)
+                    solid = static_cast<vxe::BrickMap*>(grid.get())->readBrick(glm::ivec3(x, y, z), voxels);
+                else
+                    solid = static_cast<vxe::RLEColumnGrid*>(grid.get())->readBrick(glm::ivec3(x, y, z), voxels);
+                solidBricks += solid;
+            }
+        }
+    }
+    result.conversionMs = millisecondsSince(start);
+
+    if (type == vxe::GridType::RLE_COLUMNS)
+        std::printf("%s: %zu runs, %zu solid bricks\n", name.c_str(), static_cast<vxe::RLEColumnGrid*>(grid.get())->getRunCount(), solidBricks);
+    else
+        std::printf("%s: %zu bricks, %zu solid bricks\n", name.c_str(), grid->getSize(), solidBricks);
+
+    return result;
+}
+
+int main(int argc, char** argv) {
+    glm::ivec3 dimensions(32, 8, 32);
+    size_t lookupCount = 1 << 22;
+
+    if (argc >= 4)
+        dimensions = glm::ivec3(std::atoi(argv[1]), std::atoi(argv[2]), std::atoi(argv[3]));
+    if (argc >= 5)
+        lookupCount = std::strtoull(argv[4], nullptr, 10);
+
+    std::mt19937 rng(1234);
+    glm::ivec3 extent = dimensions * glm::ivec3(vxe::BRICK_SIZE);
+    std::uniform_int_distribution<int> dx(0, extent.x - 1), dy(0, extent.y - 1), dz(0, extent.z - 1);
+
+    std::vector<glm::ivec3> lookups(lookupCount);
+    for (auto& position : lookups) {
+        position = glm::ivec3(dx(rng), dy(rng), dz(rng));
+    }
+
+    std::printf("grid %dx%dx%d bricks (%dx%dx%d voxels), %zu random lookups\n\n",
+        dimensions.x, dimensions.y, dimensions.z, extent.x, extent.y, extent.z, lookupCount);
+
+    std::vector<BenchResult> results;
+    results.push_back(runBench("BrickMap", vxe::GridType::BRICK_MAP, dimensions, lookups));
+    results.push_back(runBench("RLEColumns", vxe::GridType::RLE_COLUMNS, dimensions, lookups));
+
+    std::printf("\n%-12s %14s %14s %14s %16s\n", "grid", "generate [ms]", "memory [KiB]", "lookup [ns]", "to bricks [ms]");
+    for (const auto& result : results) {
+        std::printf("%-12s %14.2f %14.1f %14.2f %16.2f\n",
+            result.name.c_str(), result.generationMs, result.bytes / 1024.0, result.lookupNs, result.conversionMs);
+    }
+
+    if (results[0].checksum != results[1].checksum) {
+        std::fprintf(stderr, "\nlookup checksums differ, the grids do not hold the same world\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+// Headless benchmark suite for the voxel data structures, no window or GL context required.
+// Prints a JSON report with per-case medians and percentiles, see bench/Bench.h for the options.
+//
+//   VoxelBench --out baseline.json
+//   VoxelBench --baseline baseline.json
+
+#include "Bench.h"
+
+#include "vxe/DataStructures/BrickMap.h"
+#include "vxe/DataStructures/RLEColumnGrid.h"
+#include "vxe/Events/Events.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+
+using namespace vxe;
+
+// same world as the app
+static const glm::ivec3 DEFAULT_WORLD(64, 32, 64);
+static const glm::ivec3 SMALL_WORLD(16, 8, 16);
+
+static void generateWorld(Grid& grid, const glm::ivec3& dimensions) {
+    for (int z = 0; z < dimensions.z; z++) {
+        for (int y = 0; y < dimensions.y; y++) {
+            for (int x = 0; x < dimensions.x; x++) {
+                grid.generateChunk(glm::ivec3(x, y, z));
+            }
+        }
+    }
+}
+
+static std::vector<glm::ivec3> randomPositions(size_t count, const glm::ivec3& extent, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dx(0, extent.x - 1), dy(0, extent.y - 1), dz(0, extent.z - 1);
+
+    std::vector<glm::ivec3> positions(count);
+    for (auto& position : positions) {
+        position = glm::ivec3(dx(rng), dy(rng), dz(rng));
+    }
+    return positions;
+}
+
+static void editCases(bench::Runner& runner) {
+    const glm::ivec3 extent = SMALL_WORLD * glm::ivec3(BRICK_SIZE);
+    std::unique_ptr<BrickMap> grid;
+
+    runner.run("brickmap/setVoxel_sequential", 10, 32 * 32 * 32,
+        [&] { grid = std::make_unique<BrickMap>(SMALL_WORLD); },
+        [&] {
+            for (int z = 0; z < 32; z++)
+                for (int y = 0; y < 32; y++)
+                    for (int x = 0; x < 32; x++)
+                        grid->setVoxel(glm::ivec3(x, y, z), Material::STONE);
+        });
+
+    auto positions = randomPositions(32768, extent, 1);
+    runner.run("brickmap/setVoxel_random", 10, positions.size(),
+        [&] { grid = std::make_unique<BrickMap>(SMALL_WORLD); generateWorld(*grid, SMALL_WORLD); },
+        [&] {
+            for (size_t i = 0; i < positions.size(); i++)
+                grid->setVoxel(positions[i], static_cast<Material>(i % 3));
+        });
+
+    const glm::ivec3 fillPosition(4, 0, 4), fillExtents(96, 48, 96);
+    runner.run("brickmap/fillRegion", 10, fillExtents.x * fillExtents.y * fillExtents.z,
+        [&] { grid = std::make_unique<BrickMap>(SMALL_WORLD); generateWorld(*grid, SMALL_WORLD); },
+        [&] { grid->fillRegion(fillPosition, fillExtents, Material::STONE); });
+}
+
+static void generationCases(bench::Runner& runner) {
+    const size_t bricks = DEFAULT_WORLD.x * DEFAULT_WORLD.y * DEFAULT_WORLD.z;
+    std::unique_ptr<Grid> grid;
+
+    runner.run("brickmap/generateChunk_world", 3, bricks,
+        [&] { grid = std::make_unique<BrickMap>(DEFAULT_WORLD); },
+        [&] { generateWorld(*grid, DEFAULT_WORLD); });
+
+    runner.run("brickmap/generateChunk_world_dedup", 3, bricks,
+        [&] { auto brickMap = std::make_unique<BrickMap>(DEFAULT_WORLD); brickMap->setDeduplicationEnabled(true); grid = std::move(brickMap); },
+        [&] { generateWorld(*grid, DEFAULT_WORLD); });
+
+    runner.run("rle/generateChunk_world", 3, bricks,
+        [&] { grid = std::make_unique<RLEColumnGrid>(DEFAULT_WORLD); },
+        [&] { generateWorld(*grid, DEFAULT_WORLD); });
+}
+
+static void worldCases(bench::Runner& runner) {
+    const glm::ivec3 extent = DEFAULT_WORLD * glm::ivec3(BRICK_SIZE);
+
+    BrickMap world(DEFAULT_WORLD);
+    generateWorld(world, DEFAULT_WORLD);
+    RLEColumnGrid rleWorld(DEFAULT_WORLD);
+    generateWorld(rleWorld, DEFAULT_WORLD);
+
+    auto positions = randomPositions(1 << 20, extent, 2);
+    volatile uint32_t sink = 0;
+
+    runner.run("brickmap/getVoxel_random", 10, positions.size(), nullptr, [&] {
+        uint32_t sum = 0;
+        for (const auto& position : positions) sum += static_cast<uint32_t>(world.getVoxel(position));
+        sink = sum;
+    });
+
+    runner.run("rle/getVoxel_random", 10, positions.size(), nullptr, [&] {
+        uint32_t sum = 0;
+        for (const auto& position : positions) sum += static_cast<uint32_t>(rleWorld.getVoxel(position));
+        sink = sum;
+    });
+
+    // regenerating a brick that already exists invalidates all material offsets, the lookup rebuilds them
+    runner.run("brickmap/rebuildOffsets", 10, world.getSize(),
+        [&] { world.generateChunk(glm::ivec3(0)); },
+        [&] { sink = static_cast<uint32_t>(world.getVoxel(glm::ivec3(0))); });
+
+    // everything uploadToGPU() does except the driver call: refreshing dirty LODs and copying the buffers
+    std::vector<uint8_t> staging;
+    auto edits = randomPositions(64, extent, 3);
+    runner.run("brickmap/uploadSerialize", 10, world.getGPUGrid().getSizeInBytes(),
+        [&] { for (const auto& edit : edits) world.setVoxel(edit, Material::STONE); },
+        [&] {
+            GPUGrid gpuGrid = world.getGPUGrid();
+            staging.resize(gpuGrid.getSizeInBytes());
+
+            size_t offset = 0;
+            for (const auto& buffer : gpuGrid.buffers) {
+                std::memcpy(staging.data() + offset, buffer.data, buffer.size);
+                offset += buffer.size;
+            }
+        });
+
+    // camera-like rays: from above the terrain, looking down at shallow to steep angles
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> px(0.0f, extent.x), pz(0.0f, extent.z), py(extent.y * 0.3f, extent.y - 1.0f);
+    std::uniform_real_distribution<float> horizontal(-1.0f, 1.0f), down(-1.0f, -0.05f);
+
+    std::vector<std::pair<glm::vec3, glm::vec3>> rays(65536);
+    for (auto& ray : rays) {
+        ray.first = glm::vec3(px(rng), py(rng), pz(rng));
+        ray.second = glm::vec3(horizontal(rng), down(rng), horizontal(rng));
+    }
+
+    runner.run("brickmap/raycast", 10, rays.size(), nullptr, [&] {
+        uint32_t hits = 0;
+        for (const auto& ray : rays) hits += world.raycast(ray.first, ray.second, 1024.0f).hit;
+        sink = hits;
+    });
+}
+
+struct MouseListener {
+    float sum = 0.0f;
+
+    bool onMouseMove(MouseMovedEvent& e) {
+        sum += e.getX();
+        return false;
+    }
+};
+
+// events per second = 1e9 / ns_per_op
+static void eventCases(bench::Runner& runner) {
+    const size_t events = 1 << 20;
+    MouseListener listener;
+
+    runner.run("events/dispatch_unobserved", 10, events, nullptr, [&] {
+        for (size_t i = 0; i < events; i++) VXE_DISPATCH(MouseMovedEvent, (float) i, 0.0f);
+    });
+
+    VXE_SUBSCRIBE_MEMBER(MouseMovedEvent, &listener, &MouseListener::onMouseMove);
+    runner.run("events/dispatch_member", 10, events, nullptr, [&] {
+        for (size_t i = 0; i < events; i++) VXE_DISPATCH(MouseMovedEvent, (float) i, 0.0f);
+    });
+
+    VXE_EVENT_MANAGER.unsubscribe<MouseMovedEvent>();
+    VXE_SUBSCRIBE(MouseMovedEvent, [&](MouseMovedEvent& e) { return listener.onMouseMove(e); });
+    runner.run("events/dispatch_callback", 10, events, nullptr, [&] {
+        for (size_t i = 0; i < events; i++) VXE_DISPATCH(MouseMovedEvent, (float) i, 0.0f);
+    });
+
+    VXE_EVENT_MANAGER.clear();
+
+    // queueing in batches that fit into the ring, then draining on the same thread
+    EventQueue queue(1024);
+    runner.run("events/queue_single", 10, events, nullptr, [&] {
+        for (size_t batch = 0; batch < events; batch += 512) {
+            for (size_t i = 0; i < 512; i++) queue.push<MouseMovedEvent>((float) i, 0.0f);
+            queue.drain([&](Event& e) { listener.onMouseMove(static_cast<MouseMovedEvent&>(e)); });
+        }
+    });
+
+    // four worker threads queueing while the main thread keeps draining
+    const int producers = 4;
+    runner.run("events/queue_4_producers", 5, events, nullptr, [&] {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&] {
+                for (size_t i = 0; i < events / producers; i++) queue.push<MouseMovedEvent>((float) i, 0.0f);
+            });
+        }
+
+        size_t handled = 0;
+        while (handled < events) {
+            handled += queue.drain([&](Event& e) { listener.onMouseMove(static_cast<MouseMovedEvent&>(e)); });
+        }
+        for (auto& thread : threads) thread.join();
+    });
+
+    EventQueueMetrics metrics = queue.getMetrics();
+    std::fprintf(stderr, "event queue: %.1f ns/enqueue (max %llu ns), high-water mark %zu/%zu, %llu of %llu overflowed\n",
+        metrics.averageEnqueueNs, (unsigned long long) metrics.maxEnqueueNs, metrics.highWaterMark, metrics.capacity,
+        (unsigned long long) metrics.overflowed, (unsigned long long) metrics.enqueued);
+}
+
+int main(int argc, char** argv) {
+    bench::Runner runner(argc, argv);
+
+    editCases(runner);
+    generationCases(runner);
+    worldCases(runner);
+    eventCases(runner);
+
+    return runner.finish();
+}
@@ -1,31 +1,43 @@
 #include "App.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <filesystem>
+#include <stdexcept>
+#include <utility>
 
 #include <spdlog/spdlog.h>
+#include <string>
 #include <imgui.h>
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 
 #include <glm/gtc/type_ptr.hpp>
 
-#include "platform/rss.h"
 #include <FastNoiseLite.h>
 #include <GLFW/glfw3.h>
 
 // #include "vxe/DataStructures/BrickMap.h"
 
+// seconds since startup, getTime() is not available without a GLFW window
+static double getTime() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 std::vector<vxe::MaterialInfo> materialInfos = {
     { glm::vec4(0.0f, 0.0f, 0.0f, 0.0f), 0.0f, 0.0f },     // AIR
     { glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), 0.0f, 0.2f },     // GRASS
     { glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), 0.2f, 0.7f }      // STONE
 };
 
-App::App(int width, int height, const char* title)
-    : m_width(width), m_height(height), m_title(title) {}
+App::App(int width, int height, const char* title, bool headless)
+    : m_width(width), m_height(height), m_title(title), m_headless(headless) {}
 
 bool App::init() {
-    m_window = vxe::Window::Create({m_title, (uint32_t) m_width, (uint32_t) m_height});
+    m_window = vxe::Window::Create({m_title, (uint32_t) m_width, (uint32_t) m_height, m_headless});
 
     m_renderer = std::make_unique<vxe::Renderer>();
     m_renderer->init(m_window.get());
@@ -37,26 +49,75 @@ bool App::init() {
 
     VXE_SUBSCRIBE_MEMBER(vxe::WindowResizeEvent, this, &App::onResize);
     VXE_SUBSCRIBE_MEMBER(vxe::KeyPressedEvent, this, &App::onKeyPressed);
-    VXE_SUBSCRIBE_MEMBER(vxe::MouseMovedEvent, this, &App::onMouseMove);
     VXE_SUBSCRIBE_MEMBER(vxe::MouseScrolledEvent, this, &App::onMouseScroll);
     VXE_SUBSCRIBE_MEMBER(vxe::WindowCloseEvent, this, &App::onWindowClose);
+    VXE_SUBSCRIBE_MEMBER(vxe::GridChangedEvent, this, &App::onGridChanged);
 
     // Init ImGui
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO();
-    io.ConfigFlags |= ImGuiConfigFlags_NavNoCaptureKeyboard;
-
-    ImGui_ImplGlfw_InitForOpenGL(static_cast<GLFWwindow*>(m_window->getNativeWindow()), true);
-    ImGui_ImplOpenGL3_Init();
-    spdlog::info("Initialized ImGui");
+    if (!m_headless) {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.ConfigFlags |= ImGuiConfigFlags_NavNoCaptureKeyboard;
+
+        ImGui_ImplGlfw_InitForOpenGL(static_cast<GLFWwindow*>(m_window->getNativeWindow()), true);
+        ImGui_ImplOpenGL3_Init();
+        spdlog::info("Initialized ImGui");
+    }
 
     std::filesystem::path shaderDir = std::filesystem::current_path() / "assets" / "shader";
-    m_program = vxe::Shader::create();
-    m_program->vertex((shaderDir / "raymarch.vert").string());
-    m_program->fragment((shaderDir / "raymarch.frag").string());
-    m_program->compile();
-    m_program->bind();
+    // variants are built in buildShaderVariants(), the deferred visibility pass leaves shadows to the lighting pass
+    m_programs = std::make_unique<vxe::ShaderVariants>((shaderDir / "raymarch.vert").string(), (shaderDir / "raymarch.frag").string(),
+        std::vector<std::string>{ "SHADOWS", "LOD", "STATS", "BEAM", "TEMPORAL", "DEFERRED" });
+    m_programs->ignoreWhen("SHADOWS", "DEFERRED");
+    m_programs->define("BRICK_SIZE", std::to_string(vxe::BRICK_SIZE));
+    m_programs->define("MAX_CLIP_LEVELS", std::to_string(vxe::BrickClipmap::MAX_LEVELS));
+    m_programs->define("BEAM_TILE_SIZE", std::to_string(vxe::BeamPrepass::TILE_SIZE));
+    // same features and bits as the fragment raymarcher
+    m_computePrograms = std::make_unique<vxe::ShaderVariants>((shaderDir / "raymarch.comp").string(),
+        std::vector<std::string>{ "SHADOWS", "LOD", "STATS", "BEAM", "TEMPORAL", "DEFERRED" });
+    m_computePrograms->ignoreWhen("SHADOWS", "DEFERRED");
+    m_computePrograms->define("BRICK_SIZE", std::to_string(vxe::BRICK_SIZE));
+    m_computePrograms->define("MAX_CLIP_LEVELS", std::to_string(vxe::BrickClipmap::MAX_LEVELS));
+    m_computePrograms->define("BEAM_TILE_SIZE", std::to_string(vxe::BeamPrepass::TILE_SIZE));
+
+    m_occupancyProgram = vxe::Shader::create();
+    m_occupancyProgram->compute((shaderDir / "occupancy.comp").string());
+    m_occupancyProgram->compile();
+
+    m_lightingPrograms = std::make_unique<vxe::ShaderVariants>((shaderDir / "lighting.comp").string(),
+        std::vector<std::string>{ "SHADOWS", "SHADOW_PASS", "LIGHT_CACHE" });
+    m_lightingPrograms->ignoreUnless("SHADOW_PASS", "SHADOWS");
+    m_lightingPrograms->ignoreUnless("LIGHT_CACHE", "SHADOWS");
+    m_lightingPrograms->define("BRICK_SIZE", std::to_string(vxe::BRICK_SIZE));
+    m_lightingPrograms->define("MAX_CLIP_LEVELS", std::to_string(vxe::BrickClipmap::MAX_LEVELS));
+
+    m_shadowProgram = vxe::Shader::create();
+    m_shadowProgram->compute((shaderDir / "shadow.comp").string());
+    m_shadowProgram->define("BRICK_SIZE", std::to_string(vxe::BRICK_SIZE));
+    m_shadowProgram->define("MAX_CLIP_LEVELS", std::to_string(vxe::BrickClipmap::MAX_LEVELS));
+    m_shadowProgram->compile();
+
+    m_lightCacheInvalidateProgram = vxe::Shader::create();
+    m_lightCacheInvalidateProgram->compute((shaderDir / "face_light_invalidate.comp").string());
+    m_lightCacheInvalidateProgram->define("BRICK_SIZE", std::to_string(vxe::BRICK_SIZE));
+    m_lightCacheInvalidateProgram->compile();
+
+    m_beamPrograms = std::make_unique<vxe::ShaderVariants>((shaderDir / "raymarch.vert").string(), (shaderDir / "beam.frag").string(),
+        std::vector<std::string>{ "STATS" });
+    m_beamPrograms->define("BRICK_SIZE", std::to_string(vxe::BRICK_SIZE));
+    m_beamPrograms->define("MAX_CLIP_LEVELS", std::to_string(vxe::BrickClipmap::MAX_LEVELS));
+    m_beamPrograms->define("BEAM_TILE_SIZE", std::to_string(vxe::BeamPrepass::TILE_SIZE));
+
+    m_dagPrograms = std::make_unique<vxe::ShaderVariants>((shaderDir / "raymarch.vert").string(), (shaderDir / "raymarch_dag.frag").string(),
+        std::vector<std::string>{ "SHADOWS" });
+    m_dagPrograms->define("BRICK_SIZE", std::to_string(vxe::BRICK_SIZE));
+
+    m_upscaleProgram = vxe::Shader::create();
+    m_upscaleProgram->vertex((shaderDir / "raymarch.vert").string());
+    m_upscaleProgram->fragment((shaderDir / "upscale.frag").string());
+    m_upscaleProgram->compile();
+    m_renderer->setUpscaleShader(m_upscaleProgram.get());
 
     m_camera = std::make_unique<Camera>(glm::vec3(80.0f, 70.0f, 70.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f);
     m_projection = glm::perspective(glm::radians(m_camera->zoom), (float) m_width / (float) m_height, 0.1f, 100.0f);
@@ -64,91 +125,479 @@ bool App::init() {
     glm::ivec3 gridSize(64, 32, 64);
 
     m_grid = std::make_unique<vxe::VoxelGrid>(vxe::GridType::BRICK_MAP, gridSize);
+    vxe::BrickMap* brickMap = static_cast<vxe::BrickMap*>(m_grid->getGrid());
+    brickMap->setDeduplicationEnabled(true);
 
     spdlog::info("Starting to generate terrain...");
     
-    double startTime = glfwGetTime();
-
-    for (int z = 0; z < gridSize.z; z++) {
-        for (int y = 0; y < gridSize.y; y++) {
-            for (int x = 0; x < gridSize.x; x++) {
-                m_grid->getGrid()->generateChunk(glm::ivec3(x, y, z));
+    double startTime = getTime();
+
+    {
+        VXE_PROFILE_SCOPE("generateTerrain");
+        for (int z = 0; z < gridSize.z; z++) {
+            for (int y = 0; y < gridSize.y; y++) {
+                for (int x = 0; x < gridSize.x; x++) {
+                    m_grid->getGrid()->generateChunk(glm::ivec3(x, y, z));
+                }
             }
         }
     }
 
-    double took = glfwGetTime() - startTime;
+    double took = getTime() - startTime;
 
     spdlog::info("Finished terrain generation. (size: {:.2f} MiB) (time taken: {:.2f}s)", m_grid->getGrid()->getSizeInBytes() / 1024.0 / 1024.0, took);
 
+    vxe::BrickDedupStats dedupStats = brickMap->getDedupStats();
+    spdlog::info("Brick deduplication: {} cells share {} bricks (ratio: {:.2f}) (saved: {:.2f} MiB)",
+        dedupStats.logicalBricks, dedupStats.physicalBricks, dedupStats.getRatio(), dedupStats.bytesSaved / 1024.0 / 1024.0);
+
     m_grid->getGrid()->uploadToGPU();
+
+    startTime = getTime();
+    auto dag = [&] {
+        VXE_PROFILE_SCOPE("SparseVoxelDAG::fromBrickMap");
+        return vxe::SparseVoxelDAG::fromBrickMap(*brickMap);
+    }();
+    dag->uploadToGPU();
+    took = getTime() - startTime;
+
+    spdlog::info("Built sparse voxel DAG. (nodes: {}) (size: {:.2f} MiB, GPU: {:.2f} MiB) (time taken: {:.2f}s)",
+        dag->getSize(), dag->getSizeInBytes() / 1024.0 / 1024.0, dag->getGPUSizeInBytes() / 1024.0 / 1024.0, took);
+
+    m_dagPrograms->setOnBuild([depth = dag->getDepth(), gridSize](vxe::Shader& program) {
+        program.bind();
+        program.setUniform("dagDepth", depth);
+        program.setUniform("gridSize", gridSize);
+    });
+    m_dagGrid = std::make_unique<vxe::VoxelGrid>(std::move(dag));
+
+    // same terrain as the fixed grid, but following the camera with three coarser levels around it
+    startTime = getTime();
+    auto clipmap = std::make_unique<vxe::BrickClipmap>(glm::ivec3(48, 16, 48), 4, gridSize.y * vxe::BRICK_SIZE);
+    clipmap->update(m_camera->position);
+    clipmap->uploadToGPU();
+    took = getTime() - startTime;
+
+    spdlog::info("Built brick clipmap. (levels: {}) (size: {:.2f} MiB) (time taken: {:.2f}s)",
+        clipmap->getLevelCount(), clipmap->getSizeInBytes() / 1024.0 / 1024.0, took);
+    m_clipmapGrid = std::make_unique<vxe::VoxelGrid>(std::move(clipmap));
+
     m_materialInfosSSBO = vxe::ShaderStorageBuffer::create(3);
     m_materialInfosSSBO->setData(materialInfos.data(), materialInfos.size() * sizeof(vxe::MaterialInfo));
+    m_traversalStatsSSBO = vxe::ShaderStorageBuffer::create(6);
+    m_traversalStatsSSBO->setData(traversalStats, sizeof(traversalStats));
+    m_occupancySSBO = vxe::ShaderStorageBuffer::create(7);
+
+    m_frameConstantsUBO = vxe::UniformBuffer::create(FrameConstants::BINDING, sizeof(FrameConstants));
+    m_pixelQuery = vxe::PixelQuery::create();
+
+    // built last, the DAG variants need the depth of the DAG built above
+    buildShaderVariants();
+
+    // warm when every program came from the binary cache of an earlier run
+    bool warmStart = m_upscaleProgram->isFromBinaryCache() && m_occupancyProgram->isFromBinaryCache() && m_shadowProgram->isFromBinaryCache()
+        && m_lightCacheInvalidateProgram->isFromBinaryCache();
+    double shaderMs = m_upscaleProgram->getCompileTimeMs() + m_occupancyProgram->getCompileTimeMs() + m_shadowProgram->getCompileTimeMs()
+        + m_lightCacheInvalidateProgram->getCompileTimeMs();
+    for (const vxe::ShaderVariants* variants : { m_programs.get(), m_computePrograms.get(), m_lightingPrograms.get(), m_beamPrograms.get(), m_dagPrograms.get() }) {
+        // sets the start does not use have nothing built to measure
+        if (variants->getBuiltCount() == 0) continue;
+        warmStart = warmStart && variants->isFromBinaryCache();
+        shaderMs += variants->getCompileTimeMs();
+    }
+    spdlog::info("Shaders ready in {:.1f} ms ({} start).", shaderMs, warmStart ? "warm" : "cold");
+
+    return true;
+}
+
+void App::recordFrames(const std::string& directory) {
+    m_recorder = std::make_unique<vxe::FrameRecorder>(directory);
+    m_renderer->setFrameRecorder(m_recorder.get());
+}
+
+void App::setRenderScale(float scale) {
+    m_renderScale.setRange(scale, scale);
+    m_renderScale.setEnabled(false);
+}
+
+void App::setTargetFrameTime(float ms) {
+    m_renderScale.setTargetFrameTime(ms);
+    m_renderScale.setEnabled(true);
+}
+
+void App::setGridUniforms(vxe::Shader* program, vxe::VoxelGrid* grid) {
+    // the fixed grid is a clipmap with a single level at the origin
+    if (useClipmap) {
+        auto clipmap = static_cast<vxe::BrickClipmap*>(grid->getGrid());
+
+        glm::ivec3 origins[vxe::BrickClipmap::MAX_LEVELS], offsets[vxe::BrickClipmap::MAX_LEVELS];
+        for (int level = 0; level < clipmap->getLevelCount(); level++) {
+            origins[level] = clipmap->getClipOrigin(level);
+            offsets[level] = clipmap->getClipOffset(level);
+        }
+
+        program->setUniform("gridSize", clipmap->getLevelDimensions());
+        program->setUniform("clipLevels", clipmap->getLevelCount());
+        program->setUniform("clipOrigins", origins, clipmap->getLevelCount());
+        program->setUniform("clipOffsets", offsets, clipmap->getLevelCount());
+    } else {
+        auto brickMap = static_cast<vxe::BrickMap*>(grid->getGrid());
+
+        const glm::ivec3 origin(0);
+        program->setUniform("gridSize", brickMap->getDimensions());
+        program->setUniform("clipLevels", 1);
+        program->setUniform("clipOrigins", &origin, 1);
+        program->setUniform("clipOffsets", &origin, 1);
+    }
+}
+
+void App::setSceneUniforms(vxe::Shader* program, vxe::VoxelGrid* grid, uint32_t features) {
+    // the DAG programs get theirs when they are built
+    if (useDAG) return;
+
+    setGridUniforms(program, grid);
+    if (features & BEAM)
+        program->setUniform("beamDistances", (int) BEAM_TEXTURE_UNIT);
+    if (features & TEMPORAL) {
+        program->setUniform("historyDistance", (int) HISTORY_DISTANCE_UNIT);
+        program->setUniform("historyVoxel", (int) HISTORY_VOXEL_UNIT);
+    }
+}
+
+void App::applySceneUniforms(void* context, vxe::Shader& program) {
+    auto uniforms = static_cast<SceneUniforms*>(context);
+    uniforms->app->setSceneUniforms(&program, uniforms->grid, uniforms->features);
+}
+
+vxe::BrickMap* App::getBrickMap(vxe::VoxelGrid* grid) const {
+    if (useDAG) return nullptr;
+
+    // the clipmap's levels are slabs of one brick map
+    return useClipmap
+        ? static_cast<vxe::BrickClipmap*>(grid->getGrid())->getBrickMap()
+        : static_cast<vxe::BrickMap*>(grid->getGrid());
+}
 
-    glm::mat4 invVP = glm::inverse(m_projection * m_camera->getViewMatrix());
-    m_program->setUniform("invViewProj", invVP);
-    m_program->setUniform("cameraPos", m_camera->position);
-    m_program->setUniform("resolution", glm::vec2(m_width, m_height));
+std::array<const vxe::ShaderStorageBuffer*, 6> App::getSceneBuffers(vxe::VoxelGrid* grid) const {
+    std::array<const vxe::ShaderStorageBuffer*, 6> buffers = {};
+    if (vxe::BrickMap* brickMap = getBrickMap(grid)) {
+        auto gridBuffers = brickMap->getStorageBuffers();
+        std::copy(gridBuffers.begin(), gridBuffers.end(), buffers.begin());
+    }
+    buffers[4] = m_materialInfosSSBO.get();
+    if (collectStats && !useDAG)
+        buffers[5] = m_traversalStatsSSBO.get();
+    return buffers;
+}
+
+void App::bindSceneBuffers(vxe::VoxelGrid* grid) {
+    for (const vxe::ShaderStorageBuffer* buffer : getSceneBuffers(grid)) {
+        if (buffer)
+            m_renderer->getAPI()->bindStorageBuffer(buffer);
+    }
+}
+
+void App::buildOccupancy(vxe::VoxelGrid* grid) {
+    VXE_PROFILE_GPU_SCOPE("occupancy");
+
+    // the bits follow the storage order of the brick map, for the clipmap its levels one after another
+    vxe::BrickMap* brickMap = getBrickMap(grid);
+    glm::ivec3 dimensions = brickMap->getDimensions();
+    uint32_t cells = (uint32_t) dimensions.x * dimensions.y * dimensions.z;
+    uint32_t words = (cells + 31) / 32;
+
+    if (m_occupancySSBO->getSize() < words * sizeof(uint32_t))
+        m_occupancySSBO->setData(nullptr, words * sizeof(uint32_t));
+
+    // rebuilt every frame, it costs one read per cell and the clipmap changes whenever the camera moves
+    vxe::RenderAPI* api = m_renderer->getAPI();
+    api->bindProgram(m_occupancyProgram.get());
+    bindSceneBuffers(grid);
+    api->bindStorageBuffer(m_occupancySSBO.get());
+    m_occupancyProgram->setUniform("cellCount", cells);
+    api->dispatchCompute((words + 63) / 64, 1);
+    api->memoryBarrier(vxe::BARRIER_SHADER_STORAGE);
+}
+
+void App::dispatchRaymarch(glm::uvec2 size) {
+    VXE_PROFILE_GPU_SCOPE("raymarch (compute)");
+
+    vxe::Framebuffer* scene = m_renderer->getSceneTarget();
+    scene->bindColorAttachmentImage(0, 0, vxe::ImageAccess::WriteOnly);
+    scene->bindColorAttachmentImage(1, 1, vxe::ImageAccess::WriteOnly);
+    scene->bindColorAttachmentImage(2, 2, vxe::ImageAccess::WriteOnly);
+    scene->bindColorAttachmentImage(3, 3, vxe::ImageAccess::WriteOnly);
+
+    glm::uvec2 groups = (size + COMPUTE_TILE_SIZE - 1u) / COMPUTE_TILE_SIZE;
+    m_renderer->getAPI()->dispatchCompute(groups.x, groups.y);
+    // the upscale samples the images, the lighting pass and the picking read them, the traversal stats are read back
+    m_renderer->getAPI()->memoryBarrier(vxe::BARRIER_TEXTURE_FETCH | vxe::BARRIER_SHADER_IMAGE | vxe::BARRIER_FRAMEBUFFER
+        | vxe::BARRIER_BUFFER_UPDATE);
+}
+
+void App::traceShadows(vxe::VoxelGrid* grid, glm::uvec2 size) {
+    VXE_PROFILE_GPU_SCOPE("shadows");
+
+    // allocated for the output size like the scene target, scaled frames only use its lower left corner
+    glm::uvec2 output = (m_renderer->getOutputSize() + (uint32_t) shadowScale - 1u) / (uint32_t) shadowScale;
+    if (!m_shadowTarget)
+        m_shadowTarget = vxe::Framebuffer::create(output.x, output.y, { vxe::TextureFormat::R32F });
+    m_shadowTarget->resize(output.x, output.y);
+
+    m_renderer->getAPI()->bindProgram(m_shadowProgram.get());
+    bindSceneBuffers(grid);
+    setGridUniforms(m_shadowProgram.get(), grid);
+    m_shadowProgram->setUniform("shadowScale", shadowScale);
+
+    vxe::Framebuffer* scene = m_renderer->getSceneTarget();
+    m_shadowTarget->bindColorAttachmentImage(0, 0, vxe::ImageAccess::WriteOnly);
+    scene->bindColorAttachmentImage(1, 1, vxe::ImageAccess::ReadOnly);
+    scene->bindColorAttachmentImage(2, 2, vxe::ImageAccess::ReadOnly);
+    scene->bindColorAttachmentImage(3, 3, vxe::ImageAccess::ReadOnly);
+
+    glm::uvec2 samples = (size + (uint32_t) shadowScale - 1u) / (uint32_t) shadowScale;
+    glm::uvec2 groups = (samples + COMPUTE_TILE_SIZE - 1u) / COMPUTE_TILE_SIZE;
+    m_renderer->getAPI()->dispatchCompute(groups.x, groups.y);
+    m_renderer->getAPI()->memoryBarrier(vxe::BARRIER_SHADER_IMAGE);
+}
+
+void App::shadeDeferred(vxe::VoxelGrid* grid, glm::uvec2 size) {
+    uint32_t lighting = getLightingFeatures();
+    bool lightCache = (lighting & LIGHTING_LIGHT_CACHE) != 0;
+    bool shadowPass = (lighting & LIGHTING_SHADOW_PASS) != 0;
+    if (shadowPass)
+        traceShadows(grid, size);
+    if (lightCache) {
+        m_lightCache.setScene(static_cast<vxe::BrickMap*>(grid->getGrid())->getDimensions(), lightPos, voxelScale);
+        m_lightCache.update(m_renderer->getAPI(), m_lightCacheInvalidateProgram.get());
+    }
+
+    VXE_PROFILE_GPU_SCOPE("lighting");
+
+    vxe::Shader* program = m_lightingPrograms->get(lighting);
+    m_renderer->getAPI()->bindProgram(program);
+    bindSceneBuffers(grid);
+    setGridUniforms(program, grid);
+    if (lightCache)
+        program->setUniform("faceLightCapacity", m_lightCache.getCapacity());
+
+    vxe::Framebuffer* scene = m_renderer->getSceneTarget();
+    scene->bindColorAttachmentImage(0, 0, vxe::ImageAccess::WriteOnly);
+    scene->bindColorAttachmentImage(1, 1, vxe::ImageAccess::ReadOnly);
+    scene->bindColorAttachmentImage(2, 2, vxe::ImageAccess::ReadOnly);
+    scene->bindColorAttachmentImage(3, 3, vxe::ImageAccess::ReadOnly);
+    if (shadowPass) {
+        m_shadowTarget->bindColorAttachmentImage(0, SHADOW_IMAGE_UNIT, vxe::ImageAccess::ReadOnly);
+        program->setUniform("shadowScale", shadowScale);
+    }
 
-    m_program->setUniform("brickSize", (unsigned int) 8);
-    m_program->setUniform("gridSize", gridSize);
-    m_program->setUniform("voxelScale", 1.0f);
+    glm::uvec2 groups = (size + COMPUTE_TILE_SIZE - 1u) / COMPUTE_TILE_SIZE;
+    m_renderer->getAPI()->dispatchCompute(groups.x, groups.y);
+    m_renderer->getAPI()->memoryBarrier(vxe::BARRIER_TEXTURE_FETCH | vxe::BARRIER_FRAMEBUFFER | (lightCache ? vxe::BARRIER_SHADER_STORAGE : 0));
+}
+
+void App::pickVoxel(glm::uvec2 renderSize) {
+    // the newest finished readback wins, they are a frame or two old
+    std::vector<glm::vec4> values;
+    while (m_pixelQuery->read(values)) {
+        // color, distance, voxel and surface, see Renderer::getSceneTarget()
+        m_picked.hit = values.size() >= 4 && values[1].x > 0.0f;
+        if (!m_picked.hit) continue;
+
+        m_picked.distance = values[1].x;
+        m_picked.voxel = glm::ivec3(values[2]);
+        m_picked.level = (int) values[2].w / 4;
+        m_picked.lod = (int) values[2].w % 4;
+        m_picked.material = (uint32_t) values[3].w;
+    }
+
+    vxe::Framebuffer* scene = m_renderer->getSceneTarget();
+    if (!scene) return;
+
+    glm::vec2 output = glm::vec2(m_renderer->getOutputSize());
+    glm::vec2 cursor = cursorEnabled ? m_window->getInput().getFrame().mousePosition : output * 0.5f;
+    // the window has its origin at the top, the scene target at the bottom
+    glm::vec2 pixel = glm::vec2(cursor.x, output.y - cursor.y) * glm::vec2(renderSize) / output;
+    glm::uvec2 clamped = glm::min(glm::uvec2(glm::max(pixel, glm::vec2(0.0f))), renderSize - 1u);
+    m_pixelQuery->request(scene, clamped.x, clamped.y);
+}
+
+void App::buildShaderVariants() {
+    // A variant that does not build should stop the start, not the frame a feature is switched on in. The
+    // debug window can switch to any of them, without it only the features the app starts with are built.
+    if (!m_headless) {
+        for (vxe::ShaderVariants* variants : { m_programs.get(), m_computePrograms.get(), m_lightingPrograms.get(), m_beamPrograms.get(), m_dagPrograms.get() }) {
+            for (uint32_t mask = 0; mask < variants->getVariantCount(); mask++) {
+                variants->get(mask);
+            }
+        }
+        return;
+    }
+
+    uint32_t features = getFeatures();
+    if (useDAG)
+        m_dagPrograms->get(features & SHADOWS);
+    else if (useCompute)
+        m_computePrograms->get(features);
+    else
+        m_programs->get(features);
+    if (features & BEAM)
+        m_beamPrograms->get(collectStats ? 1 : 0);
+    if (features & DEFERRED)
+        m_lightingPrograms->get(getLightingFeatures());
+}
+
+uint32_t App::getFeatures() const {
+    return (useShadows ? SHADOWS : 0) | (useLOD ? LOD : 0) | (collectStats ? STATS : 0) | (useBeam && !useDAG ? BEAM : 0)
+        | (useTemporal && !useDAG ? TEMPORAL : 0) | (useDeferred && !useDAG ? DEFERRED : 0);
+}
+
+uint32_t App::getLightingFeatures() const {
+    // the clipmap scrolls its cells with the camera, so only the fixed brick map is cached
+    bool lightCache = useShadows && useLightCache && !useClipmap;
+    bool shadowPass = useShadows && shadowScale > 0 && !lightCache;
+    return (useShadows ? LIGHTING_SHADOWS : 0) | (shadowPass ? LIGHTING_SHADOW_PASS : 0) | (lightCache ? LIGHTING_LIGHT_CACHE : 0);
+}
 
+bool App::setGrid(const std::string& name) {
+    if (name != "brickmap" && name != "dag" && name != "clipmap") {
+        spdlog::error("Unknown grid '{}', expected brickmap, dag or clipmap.", name);
+        return false;
+    }
+
+    useDAG = name == "dag";
+    useClipmap = name == "clipmap";
     return true;
 }
 
+void App::runBenchmark(const std::string& reportPath, uint32_t frames, uint32_t warmupFrames, float viewDistance) {
+    // same world every run, the terrain generator has a fixed seed
+    glm::ivec3 dimensions = static_cast<vxe::BrickMap*>(m_grid->getGrid())->getDimensions();
+    glm::vec3 worldSize = glm::vec3(dimensions * glm::ivec3(vxe::BRICK_SIZE));
+
+    // the orbit stays above the highest terrain and looks down at the middle of the world
+    CameraPath path = viewDistance > 0.0f
+        ? CameraPath::orbit(glm::vec3(0.5f, 0.1f, 0.5f) * worldSize, viewDistance, 0.3f * worldSize.y)
+        : CameraPath::flythrough(worldSize);
+    m_benchmark = std::make_unique<FlythroughBenchmark>(std::move(path), frames, warmupFrames);
+    m_benchmarkViewDistance = viewDistance;
+    m_benchmarkReport = reportPath;
+    m_window->setVSync(false);
+    // the same frames have to be rendered at the same size every run, see setTargetFrameTime() to measure the controller
+    m_renderScale.setEnabled(false);
+
+    spdlog::info("Running flythrough benchmark: {} frames after {} warmup frames at {}x{}.", frames, warmupFrames, m_width, m_height);
+}
+
 void App::terminate() {
+    // the last readbacks need the GL context, which goes away with the window
+    if (m_recorder) {
+        m_renderer->setFrameRecorder(nullptr);
+        m_recorder->finish();
+    }
+
     // Clean up ImGui
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (!m_headless) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     // Smart pointers will automatically clean up all allocated objects
     // No manual delete calls needed
 }
 
 void App::run() {
-    float voxelScale = 1.0f;
-
-    glm::vec3 lightPos(80.0f, 70.0f, 80.0f);
-    glm::vec3 lightColor(1.0f);
-    float lightIntensity = 1.0f;
+    uint64_t frames = 0;
 
     while (running) {
-        float currentFrame = glfwGetTime();
+        float currentFrame = getTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        ImGui::Begin("Debug Info");
-        ImGui::Text("%.4f ms/frame", 1000.0f / ImGui::GetIO().Framerate);
-        ImGui::Text("FPS: %.2f", ImGui::GetIO().Framerate);
-        ImGui::Text("Camere pos: (%.2f, %.2f, %.2f)", m_camera->position.x, m_camera->position.y, m_camera->position.z);
-        ImGui::Text("Memory (MiB): %.4f", (float) getCurrentRSS() / (1024.0 * 1024.0));
-        ImGui::SliderFloat("Voxel Scale", &voxelScale, 0.0, 2.0);
-        ImGui::InputFloat3("Light Pos", glm::value_ptr(lightPos));
-        ImGui::InputFloat3("Light Color", glm::value_ptr(lightColor));
-        ImGui::InputFloat("Light Intensity", &lightIntensity, 0.01, 0.1);
-        ImGui::End();
-
-        if (viewportResized) {
-            m_program->setUniform("resolution", glm::vec2(m_width, m_height));
-            viewportResized = false;
+        // the GPU times the scale is based on are a few frames old, the controller knows what scale they had
+        vxe::Profiler& profiler = vxe::Profiler::getInstance();
+        uint64_t measuredFrame;
+        double gpuMs;
+        if (profiler.getLastGPUFrameTime(measuredFrame, gpuMs))
+            m_renderScale.addMeasurement(measuredFrame, gpuMs);
+        m_renderer->setRenderScale(m_renderScale.beginFrame(profiler.getFrameIndex()));
+        glm::uvec2 renderSize = m_renderer->getRenderSize();
+
+        // the UI would be part of the measured frame times
+        bool showUI = !m_headless && !m_benchmark;
+        if (showUI) {
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+            drawDebugWindow();
         }
 
-        glm::mat4 invVP = glm::inverse(m_projection * m_camera->getViewMatrix());
-        m_program->setUniform("time", (float) glfwGetTime());
-        m_program->setUniform("invViewProj", invVP);
-        m_program->setUniform("cameraPos", m_camera->position);
-        m_program->setUniform("voxelScale", voxelScale);
-        m_program->setUniform("lightPos", lightPos);
-        m_program->setUniform("lightColor", lightColor);
-        m_program->setUniform("lightIntensity", lightIntensity);
+        uint32_t features = getFeatures();
+        bool compute = useCompute && !useDAG;
+        vxe::Shader* program = useDAG ? m_dagPrograms->get(features & SHADOWS) : compute ? m_computePrograms->get(features) : m_programs->get(features);
+        vxe::Shader* beamProgram = (features & BEAM) ? m_beamPrograms->get(collectStats ? 1 : 0) : nullptr;
+        vxe::VoxelGrid* grid = getActiveGrid();
+
+        if (m_benchmark)
+            m_benchmark->update(*m_camera);
+
+        // the previous frame is only kept while it is used, the first frame after enabling traces everything
+        m_renderer->setKeepHistory((features & TEMPORAL) != 0);
+        vxe::Framebuffer* history = (features & TEMPORAL) ? m_renderer->getHistoryTarget() : nullptr;
+        glm::mat4 viewProj = m_projection * m_camera->getViewMatrix();
+
+        FrameConstants constants;
+        constants.invViewProj = glm::inverse(viewProj);
+        constants.cameraPos = m_camera->position;
+        constants.time = m_benchmark ? m_benchmark->getTime() : (float) getTime();
+        constants.lightPos = lightPos;
+        constants.voxelScale = voxelScale;
+        constants.lightColor = lightColor;
+        constants.lightIntensity = lightIntensity;
+        constants.resolution = glm::vec2(renderSize);
+        // size of one pixel at unit distance, used to pick the brick LOD
+        constants.pixelAngle = 2.0f * std::tan(glm::radians(m_camera->zoom) / 2.0f) / (float) renderSize.y;
+        constants.frameIndex = (uint32_t) frames;
+        constants.prevViewProj = m_prevViewProj;
+        constants.prevResolution = history ? glm::vec2(m_renderer->getHistorySize()) : glm::vec2(0.0f);
+        m_prevViewProj = viewProj;
+        m_frameConstantsUBO->setData(&constants, sizeof(constants));
+
+        if (!useDAG) {
+            if (collectStats) {
+                uint32_t zero[6] = {0};
+                m_traversalStatsSSBO->setData(zero, sizeof(zero));
+            }
 
-        processInput();
+            if (useClipmap) {
+                auto clipmap = static_cast<vxe::BrickClipmap*>(grid->getGrid());
+                clipmap->update(m_camera->position / voxelScale);
+                clipmap->uploadToGPU();
+            }
+
+            if (compute)
+                buildOccupancy(grid);
+        }
+
+        // edits only record what they touched, listeners hear about it once per frame
+        m_grid->getGrid()->flushChanges();
+        m_dagGrid->getGrid()->flushChanges();
+        m_clipmapGrid->getGrid()->flushChanges();
+
+        if (!m_benchmark)
+            processInput();
+
+        // the compute raymarcher writes the scene target as images, the deferred one shades it in another pass
+        m_renderer->setOffscreenScene(compute || (features & DEFERRED));
+
+        // the prepass has to finish its tiles before the full resolution pass reads them
+        if (beamProgram) {
+            m_renderer->getAPI()->bindProgram(beamProgram);
+            bindSceneBuffers(grid);
+            setGridUniforms(beamProgram, grid);
+            m_beamPrepass.execute(m_renderer->getAPI(), grid, renderSize);
+        }
 
         m_renderer->beginFrame();
 
@@ -157,29 +606,262 @@ void App::run() {
         //     spdlog::error("OpenGL error: {}", error);
         // }
 
-        m_program->bind();
-        // m_brickMapSSBO->bindBase();
-        // m_brickSSBO->bindBase();
-        // m_materialSSBO->bindBase();
-        m_materialInfosSSBO->bindBase();
-        m_renderer->submit(m_grid.get());
+        if (beamProgram)
+            m_beamPrepass.bindStartDistances(BEAM_TEXTURE_UNIT);
+        // the units are set even without a history, prevResolution tells the shader not to read it
+        if (history) {
+            history->bindColorAttachment(1, HISTORY_DISTANCE_UNIT);
+            history->bindColorAttachment(2, HISTORY_VOXEL_UNIT);
+        }
+        if (compute) {
+            m_renderer->getAPI()->bindProgram(program);
+            bindSceneBuffers(grid);
+            m_renderer->getAPI()->bindStorageBuffer(m_occupancySSBO.get());
+            setSceneUniforms(program, grid, features);
+            dispatchRaymarch(renderSize);
+        } else {
+            // the queue binds what the command lists and skips what is still bound from the passes before
+            vxe::RenderCommand command;
+            command.object = grid;
+            command.program = program;
+            for (const vxe::ShaderStorageBuffer* buffer : getSceneBuffers(grid)) {
+                command.addStorageBuffer(buffer);
+            }
+            // the context has to live until the queue is drawn, so it is a member
+            m_sceneUniforms = { this, grid, features };
+            command.setUniforms = &App::applySceneUniforms;
+            command.uniformContext = &m_sceneUniforms;
+            m_renderer->submit(std::move(command));
+        }
+        if (features & DEFERRED) {
+            m_renderer->drawScene();
+            shadeDeferred(grid, renderSize);
+        }
 
         // error = glGetError();
         // if (error != GL_NO_ERROR) {
         //     spdlog::error("OpenGL error: {}", error);
         // }
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        // the UI is drawn at full resolution, on top of the upscaled scene
+        m_renderer->flush();
+        if (showUI && !useDAG)
+            pickVoxel(renderSize);
+
+        // the counters are only complete once the scene was drawn
+        if (collectStats && !useDAG) {
+            m_traversalStatsSSBO->getData(traversalStats, sizeof(traversalStats));
+            if (m_benchmark) {
+                FlythroughBenchmark::TraversalStats stats;
+                stats.brickSteps = traversalStats[0];
+                stats.voxelSteps = traversalStats[1];
+                stats.pixels = traversalStats[2];
+                stats.beamSteps = traversalStats[3];
+                stats.reprojectedPixels = traversalStats[4];
+                stats.retracedPixels = traversalStats[5];
+                m_benchmark->addTraversalStats(stats);
+            }
+        }
+
+        if (showUI) {
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         m_renderer->endFrame();
         m_window->onUpdate();
+
+        frames++;
+        if (m_frameLimit > 0 && frames >= m_frameLimit)
+            running = false;
+
+        if (m_benchmark && m_benchmark->endFrame()) {
+            FlythroughBenchmark::Info info{ useDAG ? "dag" : useClipmap ? "clipmap" : "brickmap", {}, (uint32_t) m_width, (uint32_t) m_height, m_headless,
+                m_renderScale.isEnabled() ? m_renderScale.getMaxScale() : m_renderScale.getScale(), m_renderScale.isEnabled() };
+            const vxe::ShaderVariants& variants = useDAG ? *m_dagPrograms : *m_programs;
+            for (const char* feature : { "SHADOWS", "LOD", "STATS", "BEAM", "TEMPORAL", "DEFERRED" }) {
+                if (features & variants.getFeatureBit(feature)) info.features.push_back(feature);
+            }
+            if (compute)
+                info.features.push_back("COMPUTE");
+            bool lightCache = (features & DEFERRED) && useShadows && useLightCache && !useClipmap;
+            if (lightCache)
+                info.features.push_back("LIGHT_CACHE");
+            else if ((features & DEFERRED) && useShadows && shadowScale > 0)
+                info.features.push_back("SHADOW_PASS_" + std::to_string(shadowScale));
+            info.viewDistance = m_benchmarkViewDistance;
+            m_benchmark->writeReport(m_benchmarkReport, info);
+            running = false;
+        }
     }
 
     terminate();
 }
 
+vxe::VoxelGrid* App::getActiveGrid() const {
+    return useDAG ? m_dagGrid.get() : useClipmap ? m_clipmapGrid.get() : m_grid.get();
+}
+
+void App::drawDebugWindow() {
+    ImGui::Begin("Debug Info");
+    ImGui::Text("%.4f ms/frame", 1000.0f / ImGui::GetIO().Framerate);
+    ImGui::Text("FPS: %.2f", ImGui::GetIO().Framerate);
+    ImGui::Text("Camere pos: (%.2f, %.2f, %.2f)", m_camera->position.x, m_camera->position.y, m_camera->position.z);
+    ImGui::SliderFloat("Voxel Scale", &voxelScale, 0.0, 2.0);
+    ImGui::Checkbox("Sparse Voxel DAG", &useDAG);
+    ImGui::Checkbox("Clipmap", &useClipmap);
+    ImGui::Checkbox("Shadows", &useShadows);
+    if (useDeferred && useShadows) {
+        ImGui::Checkbox("Face Light Cache", &useLightCache);
+        if (useLightCache && !useClipmap)
+            ImGui::Text("Light cache: %.2f MiB", m_lightCache.getSizeInBytes() / 1024.0 / 1024.0);
+        else
+            ImGui::SliderInt("Shadow Pass Scale", &shadowScale, 0, MAX_SHADOW_SCALE, shadowScale == 0 ? "per pixel" : "1/%d");
+    }
+    ImGui::Checkbox("Brick LOD", &useLOD);
+    ImGui::Checkbox("Beam Prepass", &useBeam);
+    ImGui::Checkbox("Temporal Reprojection", &useTemporal);
+    ImGui::Checkbox("Compute Raymarch", &useCompute);
+    ImGui::Checkbox("Deferred Shading", &useDeferred);
+    ImGui::Checkbox("Traversal Stats", &collectStats);
+    if (collectStats && traversalStats[2] > 0) {
+        ImGui::Text("Brick steps/pixel: %.2f", (float) traversalStats[0] / traversalStats[2]);
+        ImGui::Text("Voxel steps/pixel: %.2f", (float) traversalStats[1] / traversalStats[2]);
+        if (useBeam)
+            ImGui::Text("Beam steps/pixel: %.3f", (float) traversalStats[3] / traversalStats[2]);
+        if (useTemporal)
+            ImGui::Text("Reprojected: %.1f%% (retraced: %.1f%%)",
+                100.0f * traversalStats[4] / traversalStats[2], 100.0f * traversalStats[5] / traversalStats[2]);
+    }
+    if (!useDAG && m_picked.hit) {
+        // in voxels of the finest level
+        glm::ivec3 voxel = m_picked.voxel * (1 << (m_picked.level + m_picked.lod));
+        ImGui::Text("Picked voxel: (%d, %d, %d) level %d LOD %d, %.1f away", voxel.x, voxel.y, voxel.z,
+            m_picked.level, m_picked.lod, m_picked.distance);
+        if (useDeferred)
+            ImGui::Text("Picked material: %u", m_picked.material);
+    }
+    ImGui::InputFloat3("Light Pos", glm::value_ptr(lightPos));
+    ImGui::InputFloat3("Light Color", glm::value_ptr(lightColor));
+    ImGui::InputFloat("Light Intensity", &lightIntensity, 0.01, 0.1);
+
+    bool dynamicResolution = m_renderScale.isEnabled();
+    if (ImGui::Checkbox("Dynamic Resolution", &dynamicResolution))
+        m_renderScale.setEnabled(dynamicResolution);
+    float targetMs = m_renderScale.getTargetFrameTime();
+    if (ImGui::SliderFloat("GPU Budget [ms]", &targetMs, 2.0f, 33.3f))
+        m_renderScale.setTargetFrameTime(targetMs);
+    glm::uvec2 renderSize = m_renderer->getRenderSize();
+    ImGui::Text("Render scale: %.0f%% (%ux%u), %.2f ms GPU at full resolution",
+        m_renderer->getRenderScale() * 100.0f, renderSize.x, renderSize.y, m_renderScale.getFullResolutionMs());
+
+    const vxe::RenderQueueStats& queueStats = m_renderer->getQueueStats();
+    ImGui::Text("Draw commands: %u (binds: %u programs, %u buffers, %u redundant skipped)",
+        queueStats.commands, queueStats.programBinds, queueStats.bufferBinds, queueStats.skippedBinds);
+
+    drawMemoryStats(getActiveGrid()->getGrid());
+    drawProfiler();
+    ImGui::End();
+}
+
+void App::drawMemoryStats(vxe::Grid* grid) {
+    // walking the grid is too slow to do every frame
+    float now = getTime();
+    if (grid != m_memoryStatsGrid || now - m_memoryStatsTime > 0.5f) {
+        m_memoryStats = grid->getMemoryStats();
+        m_memoryStatsGrid = grid;
+        m_memoryStatsTime = now;
+    }
+
+    const double MiB = 1024.0 * 1024.0;
+    ImGui::Text("Grid memory (MiB): %.2f used, %.2f reserved, %.2f GPU",
+        m_memoryStats.getUsedBytes() / MiB, m_memoryStats.getReservedBytes() / MiB, m_memoryStats.getGPUBytes() / MiB);
+    ImGui::Text("Bytes/solid voxel: %.3f CPU, %.3f GPU (%zu voxels)",
+        m_memoryStats.getCPUBytesPerSolidVoxel(), m_memoryStats.getGPUBytesPerSolidVoxel(), m_memoryStats.solidVoxels);
+
+    if (!ImGui::CollapsingHeader("Memory")) return;
+
+    if (ImGui::BeginTable("Memory", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Container");
+        ImGui::TableSetupColumn("used [KiB]");
+        ImGui::TableSetupColumn("reserved [KiB]");
+        ImGui::TableHeadersRow();
+
+        for (const auto* usages : { &m_memoryStats.cpu, &m_memoryStats.gpu }) {
+            for (const auto& usage : *usages) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s%s", usages == &m_memoryStats.gpu ? "[GPU] " : "", usage.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", usage.usedBytes / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", usage.reservedBytes / 1024.0);
+            }
+        }
+        ImGui::EndTable();
+    }
+}
+
+void App::drawProfiler() {
+    if (!ImGui::CollapsingHeader("Profiler")) return;
+
+    vxe::Profiler& profiler = vxe::Profiler::getInstance();
+    bool enabled = profiler.isEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled))
+        profiler.setEnabled(enabled);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Export trace"))
+        profiler.exportChromeTrace("profile.json");
+
+    vxe::EventQueueMetrics queueMetrics = VXE_EVENT_MANAGER.getQueueMetrics();
+    ImGui::Text("Event queue: %.0f ns/enqueue (max %.1f us), high-water %zu/%zu, %llu overflowed",
+        queueMetrics.averageEnqueueNs, queueMetrics.maxEnqueueNs / 1000.0, queueMetrics.highWaterMark, queueMetrics.capacity,
+        (unsigned long long) queueMetrics.overflowed);
+
+    vxe::InputState& input = m_window->getInput();
+    const vxe::InputLatencyStats& latency = input.getLatencyStats();
+    ImGui::Text("Input to present: %.2f ms (avg %.2f, max %.2f)", latency.lastMs, latency.averageMs, latency.maxMs);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Reset"))
+        input.resetLatencyStats();
+
+    std::vector<float> frameTimes = profiler.getFrameTimes();
+    if (!frameTimes.empty()) {
+        float maxTime = *std::max_element(frameTimes.begin(), frameTimes.end());
+        ImGui::PlotLines("Frame [ms]", frameTimes.data(), (int) frameTimes.size(), 0, nullptr, 0.0f, maxTime * 1.2f, ImVec2(0, 60));
+    }
+
+    if (ImGui::BeginTable("Zones", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("avg [ms]");
+        ImGui::TableSetupColumn("max [ms]");
+        ImGui::TableSetupColumn("calls");
+        ImGui::TableHeadersRow();
+
+        for (const auto& zone : profiler.getZoneStats()) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Indent(zone.depth * 10.0f + 1.0f);
+            ImGui::Text("%s%s", zone.gpu ? "[GPU] " : "", zone.name);
+            ImGui::Unindent(zone.depth * 10.0f + 1.0f);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.averageMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.maxMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", zone.callsPerFrame);
+        }
+        ImGui::EndTable();
+    }
+}
+
 void App::processInput() {
+    // one camera update per frame with everything the mouse moved since the last one
+    const vxe::InputFrame& input = m_window->getInput().getFrame();
+    if (!cursorEnabled && input.mouseMoved)
+        m_camera->processMouseMovement(-input.mouseDelta.x, -input.mouseDelta.y);
+
     if (m_window->isKeyDown(vxe::Key::W))
         m_camera->processKeyboard(Camera::FORWARD, deltaTime);
     if (m_window->isKeyDown(vxe::Key::S))
@@ -195,9 +877,11 @@ void App::processInput() {
 }
 
 bool App::onResize(vxe::WindowResizeEvent& e) {
+    if (m_benchmark)
+        spdlog::warn("Window resized to {}x{} during the benchmark, the results are not comparable.", e.getWidth(), e.getHeight());
+
     m_renderer->getAPI()->setViewport(0, 0, e.getWidth(), e.getHeight());
     m_projection = glm::perspective(glm::radians(m_camera->zoom), (float) e.getWidth() / (float) e.getHeight(), 0.1f, 100.0f);
-    viewportResized = true;
 
     m_width = e.getWidth();
     m_height = e.getHeight();
@@ -223,19 +907,10 @@ bool App::onKeyReleased(vxe::KeyReleasedEvent& e) {
     return false;
 }
 
-bool App::onMouseMove(vxe::MouseMovedEvent& e) {
-
-    if (cursorEnabled) return false;
-    double xOffset = lastX - e.getX();
-    double yOffset = lastY - e.getY();
-    lastX = e.getX();
-    lastY = e.getY();
-
-    m_camera->processMouseMovement(xOffset, yOffset);
-    return true;
-}
-
 bool App::onMouseScroll(vxe::MouseScrolledEvent& e) {
+    // the field of view is part of the benchmark setup
+    if (m_benchmark) return false;
+
     m_camera->processMouseScroll(e.getYOffset());
     return true;
 }
@@ -245,9 +920,94 @@ bool App::onWindowClose(vxe::WindowCloseEvent& e) {
     return true;
 }
 
+bool App::onGridChanged(vxe::GridChangedEvent& e) {
+    // the other grids are not cached, and other listeners want the event too
+    if (e.getGrid() == m_grid->getGrid())
+        m_lightCache.invalidate(e);
+    return false;
+}
+
 
-vxe::Application* vxe::createApplication() {
-    App* app = new App(800, 600, "test");
+// VoxelApp [--width <n>] [--height <n>] [--headless] [--grid brickmap|dag|clipmap] [--capture <dir>] [--frames <n>]
+//          [--benchmark <report.json>] [--benchmark-frames <n>] [--warmup <n>] [--render-scale <s>] [--target-ms <ms>]
+//          [--stats] [--no-beam] [--compute] [--temporal] [--deferred] [--shadow-scale <n>] [--light-cache]
+//
+//   --headless           render offscreen through EGL, without a window or UI
+//   --capture <dir>      write every frame to <dir> as a PPM image
+//   --frames <n>         quit after n frames
+//   --benchmark <file>   fly along the benchmark path and write frame time statistics to file
+//   --render-scale <s>   render at a fixed fraction of the output size
+//   --target-ms <ms>     adjust the render scale to keep the GPU frame time within ms
+//   --stats              count traversal steps, the benchmark reports them per pixel
+//   --no-beam            start every ray at the grid instead of where the beam prepass allows
+//   --lod                trace bricks whose voxels are smaller than a pixel at their coarser levels
+//   --view-distance <d>  with --benchmark, circle the world center d voxels away instead of the flythrough
+//   --compute            raymarch in a compute shader instead of a fragment shader
+//   --temporal           start rays just before the surface the previous frame saw in their direction
+//   --deferred           trace into a G-buffer and shade it in a separate lighting pass
+//   --shadow-scale <n>   with --deferred, trace shadows for one of every n x n pixels (default 2), 0 for every pixel
+//   --light-cache        with --deferred, keep the shadows of brick map faces until an edit near them or a light change
+vxe::Application* vxe::createApplication(int argc, char** argv) {
+    int width = 800, height = 600;
+    bool headless = false;
+    std::string grid, captureDir, benchmarkReport;
+    uint64_t frames = 0;
+    uint32_t benchmarkFrames = 600, warmupFrames = 60;
+    float renderScale = 0.0f, targetMs = 0.0f, viewDistance = 0.0f;
+    bool stats = false, beam = true, lod = false, compute = false, temporal = false, deferred = false, lightCache = false;
+    int shadowScale = 2;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--width" && hasValue) width = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue) height = std::atoi(argv[++i]);
+        else if (arg == "--headless") headless = true;
+        else if (arg == "--grid" && hasValue) grid = argv[++i];
+        else if (arg == "--capture" && hasValue) captureDir = argv[++i];
+        else if (arg == "--frames" && hasValue) frames = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--benchmark" && hasValue) benchmarkReport = argv[++i];
+        else if (arg == "--benchmark-frames" && hasValue) benchmarkFrames = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && hasValue) warmupFrames = std::atoi(argv[++i]);
+        else if (arg == "--render-scale" && hasValue) renderScale = std::atof(argv[++i]);
+        else if (arg == "--target-ms" && hasValue) targetMs = std::atof(argv[++i]);
+        else if (arg == "--stats") stats = true;
+        else if (arg == "--no-beam") beam = false;
+        else if (arg == "--lod") lod = true;
+        else if (arg == "--view-distance" && hasValue) viewDistance = std::atof(argv[++i]);
+        else if (arg == "--compute") compute = true;
+        else if (arg == "--temporal") temporal = true;
+        else if (arg == "--deferred") deferred = true;
+        else if (arg == "--shadow-scale" && hasValue) shadowScale = std::atoi(argv[++i]);
+        else if (arg == "--light-cache") lightCache = true;
+        else spdlog::warn("Ignoring unknown argument '{}'.", arg);
+    }
+
+    App* app = new App(std::max(width, 1), std::max(height, 1), "test", headless);
+    // a benchmark of the wrong grid would look like a valid result, so an unknown name stops here
+    if (!grid.empty() && !app->setGrid(grid)) {
+        delete app;
+        throw std::runtime_error("Unknown grid!");
+    }
+    // set before init(), which builds the shader variants of these settings
+    app->setTraversalStats(stats);
+    app->setBeamPrepass(beam);
+    app->setBrickLOD(lod);
+    app->setComputeRaymarch(compute);
+    app->setTemporalReprojection(temporal);
+    app->setDeferredShading(deferred);
+    app->setShadowScale(shadowScale);
+    app->setLightCache(lightCache);
     app->init();
+    if (!captureDir.empty())
+        app->recordFrames(captureDir);
+    if (!benchmarkReport.empty())
+        app->runBenchmark(benchmarkReport, benchmarkFrames, warmupFrames, viewDistance);
+    if (renderScale > 0.0f)
+        app->setRenderScale(renderScale);
+    if (targetMs > 0.0f)
+        app->setTargetFrameTime(targetMs);
+    app->setFrameLimit(frames);
     return app;
-}
\ No newline at end of file
+}
@@ -1,18 +1,54 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <array>
 #include <memory>
 
+#include "FlythroughBenchmark.h"
 #include "Rendering/Camera.h"
+#include "Rendering/FrameConstants.h"
 
 #include <vxe.h>
 
 /// @brief The main App which contains most of the logic.
 class App : public vxe::Application {
     public:
-        App(int width, int height, const char* title);
+        App(int width, int height, const char* title, bool headless = false);
         bool init();
         void terminate();
 
+        /// @brief Writes every frame as a PPM image into directory, call after init().
+        void recordFrames(const std::string& directory);
+        /// @brief Stops the main loop after the given number of frames, 0 runs until the window closes.
+        void setFrameLimit(uint64_t frames) { m_frameLimit = frames; }
+        /// @brief Selects the grid that is rendered: "brickmap", "dag" or "clipmap".
+        bool setGrid(const std::string& name);
+        /// @brief Flies along the benchmark path instead of taking input and quits with a report at its end.
+        /// @param viewDistance if above 0, circles the world center at that distance instead of the flythrough
+        void runBenchmark(const std::string& reportPath, uint32_t frames, uint32_t warmupFrames, float viewDistance = 0.0f);
+        /// @brief Renders at a fixed fraction of the output size.
+        void setRenderScale(float scale);
+        /// @brief Adjusts the render scale to keep the GPU frame time within ms.
+        void setTargetFrameTime(float ms);
+        /// @brief Counts the traversal steps of every frame, which reads them back each frame.
+        void setTraversalStats(bool enabled) { collectStats = enabled; }
+        void setBeamPrepass(bool enabled) { useBeam = enabled; }
+        /// @brief Traces bricks whose voxels are smaller than a pixel at their coarser levels, see BrickLOD.
+        /// Off by default, on llvmpipe it did not make frames measurably faster at any view distance.
+        void setBrickLOD(bool enabled) { useLOD = enabled; }
+        /// @brief Traces the brick map and clipmap in a compute shader, the DAG always uses the fragment shader.
+        void setComputeRaymarch(bool enabled) { useCompute = enabled; }
+        /// @brief Starts the brick map and clipmap rays at the previous frame's hits, falling back to a full trace.
+        void setTemporalReprojection(bool enabled) { useTemporal = enabled; }
+        /// @brief Traces the brick map and clipmap into a G-buffer first and shades it in a separate pass.
+        void setDeferredShading(bool enabled) { useDeferred = enabled; }
+        /// @brief Traces the shadows of deferred shading for one of every scale x scale pixels and upsamples them,
+        /// 0 traces one shadow ray per pixel in the lighting pass.
+        void setShadowScale(int scale) { shadowScale = std::clamp(scale, 0, MAX_SHADOW_SCALE); }
+        /// @brief Keeps the shadows of deferred shading per voxel face of the brick map, a face is only traced
+        /// again after an edit near it or when the light moves. Replaces the shadow pass where it applies.
+        void setLightCache(bool enabled) { useLightCache = enabled; }
+
         void run() override;
     
     private:
@@ -23,32 +59,132 @@ class App : public vxe::Application {
 
         std::unique_ptr<Camera> m_camera;
         glm::mat4x4 m_projection;
+        glm::mat4x4 m_prevViewProj{1.0f};
 
         std::unique_ptr<vxe::Renderer> m_renderer;
 
-        std::unique_ptr<vxe::Shader> m_program;
+        // variant bits of the raymarch programs, in the order the features are passed to ShaderVariants
+        enum RaymarchFeature : uint32_t { SHADOWS = 1, LOD = 2, STATS = 4, BEAM = 8, TEMPORAL = 16, DEFERRED = 32 };
+        static constexpr unsigned int BEAM_TEXTURE_UNIT = 0;
+        static constexpr unsigned int HISTORY_DISTANCE_UNIT = 1;
+        static constexpr unsigned int HISTORY_VOXEL_UNIT = 2;
+        static constexpr uint32_t COMPUTE_TILE_SIZE = 8; // work group size of raymarch.comp
+        // variant bits of the lighting programs
+        enum LightingFeature : uint32_t { LIGHTING_SHADOWS = 1, LIGHTING_SHADOW_PASS = 2, LIGHTING_LIGHT_CACHE = 4 };
+        static constexpr unsigned int SHADOW_IMAGE_UNIT = 4;
+        static constexpr int MAX_SHADOW_SCALE = 4;
+
+        std::unique_ptr<vxe::ShaderVariants> m_programs;
+        std::unique_ptr<vxe::ShaderVariants> m_computePrograms;
+        std::unique_ptr<vxe::Shader> m_occupancyProgram;
+        std::unique_ptr<vxe::ShaderVariants> m_lightingPrograms;
+        std::unique_ptr<vxe::Shader> m_shadowProgram;
+        std::unique_ptr<vxe::Framebuffer> m_shadowTarget; // visibility of the shadow pass samples
+        std::unique_ptr<vxe::Shader> m_lightCacheInvalidateProgram;
+        vxe::FaceLightCache m_lightCache;
+        std::unique_ptr<vxe::ShaderVariants> m_beamPrograms;
+        std::unique_ptr<vxe::ShaderVariants> m_dagPrograms;
+        std::unique_ptr<vxe::Shader> m_upscaleProgram;
+        vxe::RenderScaleController m_renderScale;
+        vxe::BeamPrepass m_beamPrepass;
+
+        // what the scene command sets its uniforms from, see applySceneUniforms()
+        struct SceneUniforms {
+            App* app = nullptr;
+            vxe::VoxelGrid* grid = nullptr;
+            uint32_t features = 0;
+        } m_sceneUniforms;
+
+        // what the scene target shows under the cursor, or in the center while it is captured
+        struct PickedVoxel {
+            bool hit = false;
+            glm::ivec3 voxel{0};    // in voxels of its clip level and LOD
+            int level = 0, lod = 0;
+            float distance = 0.0f;
+            uint32_t material = 0;  // only written by the deferred raymarcher
+        };
+        std::unique_ptr<vxe::PixelQuery> m_pixelQuery;
+        PickedVoxel m_picked;
 
         // std::unique_ptr<vxe::ShaderStorageBuffer> m_brickMapSSBO;
         // std::unique_ptr<vxe::ShaderStorageBuffer> m_brickSSBO;
         // std::unique_ptr<vxe::ShaderStorageBuffer> m_materialSSBO;
         std::unique_ptr<vxe::ShaderStorageBuffer> m_materialInfosSSBO;
+        std::unique_ptr<vxe::ShaderStorageBuffer> m_traversalStatsSSBO;
+        std::unique_ptr<vxe::ShaderStorageBuffer> m_occupancySSBO; // one bit per brick map cell
+        std::unique_ptr<vxe::UniformBuffer> m_frameConstantsUBO;
         std::unique_ptr<vxe::VoxelGrid> m_grid;
+        std::unique_ptr<vxe::VoxelGrid> m_dagGrid;
+        std::unique_ptr<vxe::VoxelGrid> m_clipmapGrid;
+
+        // offscreen without UI, set from the command line (see createApplication)
+        bool m_headless = false;
+        uint64_t m_frameLimit = 0;
+        std::unique_ptr<vxe::FrameRecorder> m_recorder;
+
+        std::unique_ptr<FlythroughBenchmark> m_benchmark;
+        std::string m_benchmarkReport;
+        float m_benchmarkViewDistance = 0.0f;
+
+        float voxelScale = 1.0f;
+        glm::vec3 lightPos = glm::vec3(80.0f, 70.0f, 80.0f);
+        glm::vec3 lightColor = glm::vec3(1.0f);
+        float lightIntensity = 1.0f;
 
-        bool viewportResized = false;
         float deltaTime = 0.0f;
         float lastFrame = 0.0f;
         bool pressingESC = false;
-        double lastX = 400;
-        double lastY = 400;
         bool cursorEnabled = false;
+        bool useDAG = false;
+        bool useClipmap = false;
+        bool useShadows = true;
+        bool useLOD = false;
+        bool useBeam = true;
+        bool useCompute = false;
+        bool useTemporal = false;
+        bool useDeferred = false;
+        int shadowScale = 2;
+        bool useLightCache = false;
+        bool collectStats = false;
+        uint32_t traversalStats[6] = {0}; // brick steps, voxel steps, pixels, beam steps, reprojected pixels, retraced pixels
+
+        vxe::MemoryStats m_memoryStats;
+        vxe::Grid* m_memoryStatsGrid = nullptr;
+        float m_memoryStatsTime = 0.0f;
 
         bool running = true;
 
         void processInput();
+        vxe::VoxelGrid* getActiveGrid() const;
+        /// @brief Builds the shader variants the app starts with, or all of them when the debug window is shown.
+        void buildShaderVariants();
+        /// @brief RaymarchFeature bits of the current settings.
+        uint32_t getFeatures() const;
+        /// @brief LightingFeature bits of the deferred lighting pass with the current settings.
+        uint32_t getLightingFeatures() const;
+        void setGridUniforms(vxe::Shader* program, vxe::VoxelGrid* grid);
+        /// @brief Grid and texture unit uniforms of the scene programs, the program has to be bound.
+        void setSceneUniforms(vxe::Shader* program, vxe::VoxelGrid* grid, uint32_t features);
+        /// @brief setSceneUniforms() as a RenderCommand::setUniforms, context is a SceneUniforms.
+        static void applySceneUniforms(void* context, vxe::Shader& program);
+        /// @brief The brick map behind grid, null for the DAG.
+        vxe::BrickMap* getBrickMap(vxe::VoxelGrid* grid) const;
+        /// @brief Storage buffers the raymarch programs read for grid, null where one is not used.
+        std::array<const vxe::ShaderStorageBuffer*, 6> getSceneBuffers(vxe::VoxelGrid* grid) const;
+        /// @brief Binds getSceneBuffers() for passes drawn outside the render queue.
+        void bindSceneBuffers(vxe::VoxelGrid* grid);
+        void buildOccupancy(vxe::VoxelGrid* grid);
+        void dispatchRaymarch(glm::uvec2 size);
+        void traceShadows(vxe::VoxelGrid* grid, glm::uvec2 size);
+        void shadeDeferred(vxe::VoxelGrid* grid, glm::uvec2 size);
+        void pickVoxel(glm::uvec2 renderSize);
+        void drawDebugWindow();
+        void drawMemoryStats(vxe::Grid* grid);
+        void drawProfiler();
         bool onResize(vxe::WindowResizeEvent& e);
         bool onKeyPressed(vxe::KeyPressedEvent& e);
         bool onKeyReleased(vxe::KeyReleasedEvent& e);
-        bool onMouseMove(vxe::MouseMovedEvent& e);
         bool onMouseScroll(vxe::MouseScrolledEvent& e);
         bool onWindowClose(vxe::WindowCloseEvent& e);
+        bool onGridChanged(vxe::GridChangedEvent& e);
 };
\ No newline at end of file
@@ -119,7 +119,12 @@ vxe::GPUGrid vxe::BrickMap::getGPUGrid() {
 }
 
 size_t vxe::BrickMap::getSizeInBytes() {
-    int brickSize = bricks.size() * sizeof(Brick);
-    int indexSize = indexTable.size() * (sizeof(glm::ivec3) + sizeof(int));
-    return brickSize + indexSize + sizeof(BrickMap);
+    size_t size = bricks.capacity() * sizeof(Brick);
+    size += indexData.capacity() * sizeof(uint32_t);
+    size += voxelData.capacity() * sizeof(uint32_t);
+
+    // one heap node per entry plus the bucket array
+    size += indexTable.size() * (sizeof(std::pair<const glm::ivec3, int>) + sizeof(void*));
+    size += indexTable.bucket_count() * sizeof(void*);
+    return size;
 }
\ No newline at end of file
@@ -7,13 +7,29 @@
 
 #include "vxe/Rendering/Renderer.h"
 #include "vxe/Rendering/Renderable.h"
+#include "vxe/Rendering/RenderCommand.h"
 #include "vxe/Rendering/VoxelGrid.h"
+#include "vxe/Rendering/ShaderVariants.h"
+#include "vxe/Rendering/FrameRecorder.h"
+#include "vxe/Rendering/RenderScaleController.h"
+#include "vxe/Rendering/BeamPrepass.h"
+#include "vxe/Rendering/FaceLightCache.h"
 
+#include "vxe/Rendering/graphics/Framebuffer.h"
+#include "vxe/Rendering/graphics/PixelQuery.h"
 #include "vxe/Rendering/graphics/ShaderStorageBuffer.h"
+#include "vxe/Rendering/graphics/UniformBuffer.h"
+
+#include "vxe/DataStructures/BrickMap.h"
+#include "vxe/DataStructures/SparseVoxelDAG.h"
+#include "vxe/DataStructures/RLEColumnGrid.h"
+#include "vxe/DataStructures/BrickClipmap.h"
 
 #include "vxe/Events/Events.h"
 
 #include "vxe/Core/Window.h"
 #include "vxe/Core/KeyCodes.h"
+#include "vxe/Core/Input.h"
+#include "vxe/Core/Profiler.h"
 
 #endif
\ No newline at end of file
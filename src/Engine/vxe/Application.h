@@ -21,8 +21,8 @@ namespace vxe {
             virtual void onRender() {}
     };
 
-    // defined by client
-    Application* createApplication();
+    // defined by client, gets the command line of the executable
+    Application* createApplication(int argc, char** argv);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "Input.h"
+
+#include "Profiler.h"
+
+#include <algorithm>
+
+namespace vxe {
+    void InputState::stamp() {
+        uint64_t now = Profiler::getInstance().now();
+        if (m_pending.rawEvents++ == 0)
+            m_pending.oldestEventTime = now;
+        m_pending.newestEventTime = now;
+    }
+
+    void InputState::onMouseMoved(float x, float y) {
+        stamp();
+        m_pending.mouseMoved = true;
+
+        glm::vec2 position(x, y);
+        if (m_hasMousePosition)
+            m_pending.mouseDelta += position - m_lastMousePosition;
+        m_lastMousePosition = position;
+        m_hasMousePosition = true;
+    }
+
+    void InputState::onMouseScrolled(float xOffset, float yOffset) {
+        stamp();
+        m_pending.scrolled = true;
+        m_pending.scroll += glm::vec2(xOffset, yOffset);
+    }
+
+    void InputState::onKey(int key, bool pressed) {
+        if (key < 0 || (size_t) key >= KEY_COUNT) return;
+        stamp();
+
+        m_keysDown.set(key, pressed);
+        if (pressed)
+            m_pendingPressed.set(key);
+        else
+            m_pendingReleased.set(key);
+    }
+
+    void InputState::onMouseButton(int button, bool pressed) {
+        if (button < 0 || (size_t) button >= MOUSE_BUTTON_COUNT) return;
+        stamp();
+
+        m_buttonsDown.set(button, pressed);
+    }
+
+    bool InputState::isMouseButtonDown(MouseButton button) const {
+        size_t index = static_cast<size_t>(button);
+        return index < MOUSE_BUTTON_COUNT && m_buttonsDown.test(index);
+    }
+
+    void InputState::endFrame() {
+        m_pending.mousePosition = m_lastMousePosition;
+        m_frame = m_pending;
+        m_pending = InputFrame();
+        m_latencyPending = m_frame.rawEvents > 0;
+
+        m_framePressed = m_pendingPressed;
+        m_frameReleased = m_pendingReleased;
+        m_pendingPressed.reset();
+        m_pendingReleased.reset();
+    }
+
+    void InputState::onPresent() {
+        // the same input is only presented once
+        if (!m_latencyPending) return;
+        m_latencyPending = false;
+
+        double latencyMs = (Profiler::getInstance().now() - m_frame.oldestEventTime) / 1e6;
+        m_latencyHistory[m_latency.frames % LATENCY_HISTORY] = latencyMs;
+        m_latency.frames++;
+        m_latency.lastMs = latencyMs;
+
+        size_t count = std::min<uint64_t>(m_latency.frames, LATENCY_HISTORY);
+        double total = 0.0, maximum = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            total += m_latencyHistory[i];
+            maximum = std::max(maximum, m_latencyHistory[i]);
+        }
+        m_latency.averageMs = total / count;
+        m_latency.maxMs = maximum;
+    }
+
+    void InputState::resetLatencyStats() {
+        m_latency = InputLatencyStats();
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef VXE_INPUT_H
+#define VXE_INPUT_H
+
+#include <bitset>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "KeyCodes.h"
+
+namespace vxe {
+    /// @brief Time from the oldest input a frame consumed until that frame was presented.
+    struct InputLatencyStats {
+        double lastMs = 0.0;
+        double averageMs = 0.0; // over the last InputState::LATENCY_HISTORY frames that had input
+        double maxMs = 0.0;
+        uint64_t frames = 0;    // presented frames that had input, since the last reset
+    };
+
+    /// @brief Everything that arrived between two polls of the window.
+    struct InputFrame {
+        glm::vec2 mousePosition{0.0f};
+        glm::vec2 mouseDelta{0.0f};
+        glm::vec2 scroll{0.0f};
+        bool mouseMoved = false;
+        bool scrolled = false;
+        uint32_t rawEvents = 0;         // callbacks folded into this frame
+        uint64_t oldestEventTime = 0;   // Profiler::now() of the first raw event, 0 without input
+        uint64_t newestEventTime = 0;
+    };
+
+    /// @brief Per-frame input state of a window.
+    ///
+    /// The platform window reports raw events as they arrive, each one stamped with Profiler::now().
+    /// Cursor and scroll movement are summed up until endFrame(), so the application gets one combined
+    /// update per frame no matter how fast the mouse polls. The Renderer calls onPresent() after the
+    /// swap, which closes the latency measurement of the input that frame was built from.
+    class InputState {
+        public:
+            static constexpr size_t KEY_COUNT = static_cast<size_t>(Key::Menu) + 1;
+            static constexpr size_t MOUSE_BUTTON_COUNT = 8;
+            static constexpr size_t LATENCY_HISTORY = 128;
+
+            // raw events, called by the platform window
+            void onMouseMoved(float x, float y);
+            void onMouseScrolled(float xOffset, float yOffset);
+            void onKey(int key, bool pressed);
+            void onMouseButton(int button, bool pressed);
+
+            /// @brief Publishes the accumulated events as the current frame and starts collecting the next one.
+            void endFrame();
+            /// @brief Records the latency of the current frame's input, call once it was presented.
+            void onPresent();
+
+            /// @brief Forgets the cursor position, so that a cursor warp does not count as movement.
+            void resetMouse() { m_hasMousePosition = false; }
+
+            const InputFrame& getFrame() const { return m_frame; }
+            glm::vec2 getMouseDelta() const { return m_frame.mouseDelta; }
+            glm::vec2 getScroll() const { return m_frame.scroll; }
+
+            bool isKeyDown(Key key) const { return testKey(m_keysDown, key); }
+            /// @brief True if the key went down since the previous frame.
+            bool wasKeyPressed(Key key) const { return testKey(m_framePressed, key); }
+            bool wasKeyReleased(Key key) const { return testKey(m_frameReleased, key); }
+            bool isMouseButtonDown(MouseButton button) const;
+
+            const InputLatencyStats& getLatencyStats() const { return m_latency; }
+            void resetLatencyStats();
+
+        private:
+            InputFrame m_frame;
+            InputFrame m_pending;
+            glm::vec2 m_lastMousePosition{0.0f};
+            bool m_hasMousePosition = false;
+            bool m_latencyPending = false;
+
+            std::bitset<KEY_COUNT> m_keysDown, m_pendingPressed, m_pendingReleased, m_framePressed, m_frameReleased;
+            std::bitset<MOUSE_BUTTON_COUNT> m_buttonsDown;
+
+            InputLatencyStats m_latency;
+            double m_latencyHistory[LATENCY_HISTORY] = {};
+
+            void stamp();
+
+            static bool testKey(const std::bitset<KEY_COUNT>& keys, Key key) {
+                size_t index = static_cast<size_t>(key);
+                return index < KEY_COUNT && keys.test(index);
+            }
+    };
+}
+
+#endif
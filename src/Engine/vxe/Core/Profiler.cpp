@@ -0,0 +1,290 @@
+#include "Profiler.h"
+
+#include "../Rendering/graphics/RenderAPI.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+namespace vxe {
+    static std::chrono::steady_clock::time_point getEpoch() {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return epoch;
+    }
+
+    // open zones of the calling thread, zones deeper than this are timed but share the last slot
+    struct ThreadZoneStack {
+        static constexpr uint32_t MAX_DEPTH = 64;
+
+        uint32_t id;
+        uint32_t depth = 0;
+        const char* names[MAX_DEPTH];
+        uint64_t starts[MAX_DEPTH];
+    };
+
+    static std::atomic<uint32_t> s_nextThreadId{0};
+    static thread_local ThreadZoneStack t_stack{s_nextThreadId.fetch_add(1, std::memory_order_relaxed)};
+
+    Profiler::Profiler() {
+        m_current.index = 0;
+        m_current.start = now();
+    }
+
+    Profiler::~Profiler() {}
+
+    uint64_t Profiler::now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - getEpoch()).count();
+    }
+
+    void Profiler::setRenderAPI(RenderAPI* api) {
+        std::lock_guard lock(m_mutex);
+        releaseQueries();
+        m_api = api;
+    }
+
+    void Profiler::beginZone(const char* name) {
+        uint32_t slot = std::min(t_stack.depth, ThreadZoneStack::MAX_DEPTH - 1);
+        t_stack.names[slot] = name;
+        t_stack.starts[slot] = now();
+        t_stack.depth++;
+    }
+
+    void Profiler::endZone() {
+        if (t_stack.depth == 0) return;
+
+        uint64_t end = now();
+        t_stack.depth--;
+        uint32_t slot = std::min(t_stack.depth, ThreadZoneStack::MAX_DEPTH - 1);
+
+        std::lock_guard lock(m_mutex);
+        if (m_current.zones.size() >= MAX_ZONES_PER_FRAME) {
+            m_current.droppedZones++;
+            return;
+        }
+        m_current.zones.push_back(ProfileZone{t_stack.names[slot], t_stack.starts[slot], end - t_stack.starts[slot], t_stack.id, t_stack.depth});
+    }
+
+    void Profiler::beginGPUZone(const char* name) {
+        std::lock_guard lock(m_mutex);
+        if (m_gpuDepth++ > 0 || !m_api) return;
+
+        unsigned int query;
+        if (m_freeQueries.empty()) {
+            query = m_api->createTimerQuery();
+        } else {
+            query = m_freeQueries.back();
+            m_freeQueries.pop_back();
+        }
+
+        m_activeQuery = PendingQuery{query, name, m_current.index, now()};
+        m_api->beginTimerQuery(query);
+    }
+
+    void Profiler::endGPUZone() {
+        std::lock_guard lock(m_mutex);
+        if (m_gpuDepth == 0 || --m_gpuDepth > 0 || !m_api) return;
+
+        m_api->endTimerQuery();
+        m_pendingQueries.push_back(m_activeQuery);
+    }
+
+    void Profiler::endFrame() {
+        std::lock_guard lock(m_mutex);
+
+        uint64_t end = now();
+        m_current.duration = end - m_current.start;
+
+        // zones are recorded when they close, so children come before their parents
+        std::sort(m_current.zones.begin(), m_current.zones.end(), [](const ProfileZone& a, const ProfileZone& b) {
+            return a.thread != b.thread ? a.thread < b.thread : a.start < b.start;
+        });
+
+        uint64_t index = m_current.index;
+        m_history.push_back(std::move(m_current));
+        while (m_history.size() > m_historySize)
+            m_history.pop_front();
+
+        m_current = ProfileFrame();
+        m_current.index = index + 1;
+        m_current.start = end;
+
+        collectGPUQueries();
+    }
+
+    uint64_t Profiler::getFrameIndex() const {
+        std::lock_guard lock(m_mutex);
+        return m_current.index;
+    }
+
+    bool Profiler::getLastGPUFrameTime(uint64_t& frame, double& milliseconds) const {
+        std::lock_guard lock(m_mutex);
+        if (m_lastGPUFrame.frame == UINT64_MAX) return false;
+
+        frame = m_lastGPUFrame.frame;
+        milliseconds = m_lastGPUFrame.duration / 1e6;
+        return true;
+    }
+
+    void Profiler::setHistorySize(size_t frames) {
+        std::lock_guard lock(m_mutex);
+        m_historySize = std::max<size_t>(frames, 1);
+        while (m_history.size() > m_historySize)
+            m_history.pop_front();
+    }
+
+    std::vector<ProfileFrame> Profiler::getHistory() const {
+        std::lock_guard lock(m_mutex);
+        return std::vector<ProfileFrame>(m_history.begin(), m_history.end());
+    }
+
+    std::vector<ProfileZoneStats> Profiler::getZoneStats() const {
+        std::lock_guard lock(m_mutex);
+
+        struct Accumulator {
+            ProfileZoneStats stats;
+            double totalMs = 0.0;
+            size_t calls = 0;
+            size_t frames = 0;
+            uint64_t lastFrame = UINT64_MAX;
+        };
+        std::vector<Accumulator> zones;
+
+        auto add = [&](const ProfileZone& zone, uint64_t frame, bool gpu) {
+            auto it = std::find_if(zones.begin(), zones.end(), [&](const Accumulator& a) {
+                return a.stats.gpu == gpu && a.stats.depth == zone.depth && a.stats.name == zone.name;
+            });
+            if (it == zones.end()) {
+                zones.push_back(Accumulator{ProfileZoneStats{zone.name, zone.depth, gpu, 0.0, 0.0, 0.0}});
+                it = zones.end() - 1;
+            }
+
+            double ms = zone.duration / 1e6;
+            it->totalMs += ms;
+            it->stats.maxMs = std::max(it->stats.maxMs, ms);
+            it->calls++;
+            if (it->lastFrame != frame) {
+                it->frames++;
+                it->lastFrame = frame;
+            }
+        };
+
+        for (const auto& frame : m_history) {
+            for (const auto& zone : frame.zones) add(zone, frame.index, false);
+            for (const auto& zone : frame.gpuZones) add(zone, frame.index, true);
+        }
+
+        std::vector<ProfileZoneStats> stats;
+        stats.reserve(zones.size());
+        for (auto& zone : zones) {
+            zone.stats.averageMs = zone.totalMs / zone.frames;
+            zone.stats.callsPerFrame = (double) zone.calls / zone.frames;
+            stats.push_back(zone.stats);
+        }
+        return stats;
+    }
+
+    std::vector<float> Profiler::getFrameTimes() const {
+        std::lock_guard lock(m_mutex);
+
+        std::vector<float> times;
+        times.reserve(m_history.size());
+        for (const auto& frame : m_history) {
+            times.push_back(frame.duration / 1e6f);
+        }
+        return times;
+    }
+
+    static void writeJSONString(std::ofstream& out, const char* text) {
+        out << '"';
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+
+    bool Profiler::exportChromeTrace(const std::string& path) const {
+        std::vector<ProfileFrame> frames = getHistory();
+
+        std::ofstream out(path);
+        if (!out) {
+            spdlog::error("Failed to open '{}' for the profiler trace.", path);
+            return false;
+        }
+
+        // trace_event timestamps are in microseconds
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << GPU_THREAD << ", \"args\": {\"name\": \"GPU\"}},\n";
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << FRAME_THREAD << ", \"args\": {\"name\": \"Frames\"}}";
+
+        out.precision(3);
+        out << std::fixed;
+        for (const auto& frame : frames) {
+            out << ",\n{\"name\": \"Frame " << frame.index << "\", \"cat\": \"frame\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << FRAME_THREAD
+                << ", \"ts\": " << frame.start / 1e3 << ", \"dur\": " << frame.duration / 1e3 << "}";
+
+            for (const auto* zones : { &frame.zones, &frame.gpuZones }) {
+                for (const auto& zone : *zones) {
+                    out << ",\n{\"name\": ";
+                    writeJSONString(out, zone.name);
+                    out << ", \"cat\": \"" << (zones == &frame.gpuZones ? "gpu" : "cpu") << "\", \"ph\": \"X\", \"pid\": 0"
+                        << ", \"tid\": " << zone.thread << ", \"ts\": " << zone.start / 1e3 << ", \"dur\": " << zone.duration / 1e3 << "}";
+                }
+            }
+        }
+        out << "\n]}\n";
+
+        spdlog::info("Wrote profiler trace of {} frames to '{}'.", frames.size(), path);
+        return true;
+    }
+
+    void Profiler::collectGPUQueries() {
+        if (!m_api) return;
+
+        // results arrive in submission order, stop at the first one that is not ready yet
+        size_t resolved = 0;
+        for (; resolved < m_pendingQueries.size(); resolved++) {
+            const PendingQuery& pending = m_pendingQueries[resolved];
+
+            uint64_t elapsed;
+            if (!m_api->getTimerQueryResult(pending.query, elapsed)) break;
+
+            // the first query of a later frame means all queries of the previous one are in
+            if (pending.frame != m_gpuFrame.frame) {
+                if (m_gpuFrame.frame != UINT64_MAX) m_lastGPUFrame = m_gpuFrame;
+                m_gpuFrame = GPUFrameTime{pending.frame, 0};
+            }
+            m_gpuFrame.duration += elapsed;
+
+            // placed at the time the pass was submitted, the GPU clock is not synchronized with ours
+            auto frame = std::find_if(m_history.begin(), m_history.end(), [&](const ProfileFrame& f) { return f.index == pending.frame; });
+            if (frame != m_history.end())
+                frame->gpuZones.push_back(ProfileZone{pending.name, pending.start, elapsed, GPU_THREAD, 0});
+
+            m_freeQueries.push_back(pending.query);
+        }
+
+        bool frameComplete = resolved == m_pendingQueries.size() || m_pendingQueries[resolved].frame != m_gpuFrame.frame;
+        if (m_gpuFrame.frame != UINT64_MAX && frameComplete) {
+            m_lastGPUFrame = m_gpuFrame;
+            m_gpuFrame = GPUFrameTime();
+        }
+
+        m_pendingQueries.erase(m_pendingQueries.begin(), m_pendingQueries.begin() + resolved);
+    }
+
+    void Profiler::releaseQueries() {
+        if (m_api) {
+            for (unsigned int query : m_freeQueries) m_api->deleteTimerQuery(query);
+            for (const auto& pending : m_pendingQueries) m_api->deleteTimerQuery(pending.query);
+            if (m_gpuDepth > 0) m_api->deleteTimerQuery(m_activeQuery.query);
+        }
+
+        m_freeQueries.clear();
+        m_pendingQueries.clear();
+        m_gpuDepth = 0;
+        m_gpuFrame = GPUFrameTime();
+    }
+}
@@ -0,0 +1,168 @@
+#ifndef VXE_PROFILER_H
+#define VXE_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vxe {
+    class RenderAPI;
+
+    /// @brief One timed scope, times are in nanoseconds since the profiler was created.
+    struct ProfileZone {
+        const char* name;
+        uint64_t start;
+        uint64_t duration;
+        uint32_t thread;    // small per-thread id, GPU zones use GPU_THREAD
+        uint32_t depth;     // nesting depth on its thread
+    };
+
+    /// @brief All zones recorded between two calls to Profiler::endFrame().
+    struct ProfileFrame {
+        uint64_t index;
+        uint64_t start;
+        uint64_t duration;
+        std::vector<ProfileZone> zones;
+        std::vector<ProfileZone> gpuZones; // filled in a few frames late, once the queries resolve
+        size_t droppedZones = 0;
+    };
+
+    /// @brief Per-frame average of a zone over the frame history.
+    struct ProfileZoneStats {
+        const char* name;
+        uint32_t depth;
+        bool gpu;
+        double averageMs;   // total time per frame, averaged over the frames that have the zone
+        double maxMs;
+        double callsPerFrame;
+    };
+
+    /// @brief Hierarchical frame profiler for CPU scopes and GPU passes.
+    ///
+    /// CPU zones are recorded by VXE_PROFILE_SCOPE from any thread. GPU zones are measured with
+    /// timer queries through the RenderAPI set by the Renderer; GL_TIME_ELAPSED queries cannot be
+    /// nested, so a GPU zone opened inside another one is ignored.
+    /// The last getHistorySize() frames are kept and can be exported as a Chrome trace.
+    class Profiler {
+        public:
+            static constexpr uint32_t GPU_THREAD = 0xFFFF;
+            static constexpr uint32_t FRAME_THREAD = 0xFFFE; // trace row of the frame markers
+            static constexpr size_t MAX_ZONES_PER_FRAME = 1 << 16;
+
+            static Profiler& getInstance() {
+                static Profiler instance;
+                return instance;
+            }
+
+            void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+            bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+            /// @brief Sets the API used for GPU timer queries, releasing the queries of the previous one.
+            void setRenderAPI(RenderAPI* api);
+
+            void beginZone(const char* name);
+            void endZone();
+            void beginGPUZone(const char* name);
+            void endGPUZone();
+
+            /// @brief Closes the current frame, starts the next one and collects finished GPU queries.
+            void endFrame();
+            /// @brief Index of the frame currently being recorded, ProfileFrame::index once it ends.
+            uint64_t getFrameIndex() const;
+            /// @brief Total GPU time of the newest frame whose GPU zones have all resolved, a few frames behind.
+            /// @return false if no frame has resolved yet.
+            bool getLastGPUFrameTime(uint64_t& frame, double& milliseconds) const;
+
+            void setHistorySize(size_t frames);
+            size_t getHistorySize() const { return m_historySize; }
+
+            /// @brief Copy of the finished frames, oldest first.
+            std::vector<ProfileFrame> getHistory() const;
+            /// @brief Zones averaged over the history, in the order they were first seen.
+            std::vector<ProfileZoneStats> getZoneStats() const;
+            /// @brief Frame times of the history in milliseconds, oldest first.
+            std::vector<float> getFrameTimes() const;
+
+            /// @brief Writes the history in the Chrome trace_event format (chrome://tracing, Perfetto).
+            bool exportChromeTrace(const std::string& path) const;
+
+            uint64_t now() const;
+
+        private:
+            Profiler();
+            ~Profiler();
+            Profiler(const Profiler&) = delete;
+            Profiler& operator=(const Profiler&) = delete;
+
+            struct PendingQuery {
+                unsigned int query;
+                const char* name;
+                uint64_t frame;
+                uint64_t start;
+            };
+
+            std::atomic<bool> m_enabled{true};
+            mutable std::mutex m_mutex;
+
+            ProfileFrame m_current;
+            std::deque<ProfileFrame> m_history;
+            size_t m_historySize = 240;
+
+            RenderAPI* m_api = nullptr;
+            std::vector<unsigned int> m_freeQueries;
+            std::vector<PendingQuery> m_pendingQueries;
+            PendingQuery m_activeQuery{};
+            int m_gpuDepth = 0;
+
+            struct GPUFrameTime {
+                uint64_t frame = UINT64_MAX;
+                uint64_t duration = 0;
+            };
+            GPUFrameTime m_gpuFrame;        // frame whose queries are being resolved
+            GPUFrameTime m_lastGPUFrame;    // newest frame with all queries resolved
+
+            void collectGPUQueries();
+            void releaseQueries();
+    };
+
+    /// @brief Times the enclosing scope as a CPU zone.
+    class ProfileScope {
+        public:
+            explicit ProfileScope(const char* name) : m_active(Profiler::getInstance().isEnabled()) {
+                if (m_active) Profiler::getInstance().beginZone(name);
+            }
+
+            ~ProfileScope() {
+                if (m_active) Profiler::getInstance().endZone();
+            }
+
+        private:
+            bool m_active;
+    };
+
+    /// @brief Times the GPU work submitted in the enclosing scope.
+    class GPUProfileScope {
+        public:
+            explicit GPUProfileScope(const char* name) : m_active(Profiler::getInstance().isEnabled()) {
+                if (m_active) Profiler::getInstance().beginGPUZone(name);
+            }
+
+            ~GPUProfileScope() {
+                if (m_active) Profiler::getInstance().endGPUZone();
+            }
+
+        private:
+            bool m_active;
+    };
+
+    #define VXE_PROFILE_CONCAT_INNER(a, b) a##b
+    #define VXE_PROFILE_CONCAT(a, b) VXE_PROFILE_CONCAT_INNER(a, b)
+    #define VXE_PROFILE_SCOPE(name) vxe::ProfileScope VXE_PROFILE_CONCAT(vxeProfileScope, __LINE__)(name)
+    #define VXE_PROFILE_FUNCTION() VXE_PROFILE_SCOPE(__func__)
+    #define VXE_PROFILE_GPU_SCOPE(name) vxe::GPUProfileScope VXE_PROFILE_CONCAT(vxeGPUProfileScope, __LINE__)(name)
+}
+
+#endif
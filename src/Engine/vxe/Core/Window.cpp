@@ -1,10 +1,13 @@
 #include "Window.h"
 
 #include <memory>
+#include "../Platform/Linux/HeadlessWindow.h"
 #include "../Platform/Linux/LinuxWindow.h"
 
 namespace vxe {
     std::unique_ptr<Window> Window::Create(const WindowConfig& config) {
+        if (config.headless)
+            return std::make_unique<HeadlessWindow>(config);
         return std::make_unique<LinuxWindow>(config);
     }
 }
\ No newline at end of file
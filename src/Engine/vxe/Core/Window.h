@@ -8,14 +8,16 @@
 #include <memory>
 
 #include "KeyCodes.h"
+#include "Input.h"
 
 namespace vxe {
     struct WindowConfig {
         std::string title;
         uint32_t width, height;
+        bool headless; // render offscreen through EGL, without a display server
 
-        WindowConfig(const std::string& title = "Voxel Engine", uint32_t width = 800, uint32_t height = 600) 
-            : title(title), width(width), height(height) {}
+        WindowConfig(const std::string& title = "Voxel Engine", uint32_t width = 800, uint32_t height = 600, bool headless = false) 
+            : title(title), width(width), height(height), headless(headless) {}
     };
 
     class Window {
@@ -30,6 +32,9 @@ namespace vxe {
             virtual uint32_t getHeight() const = 0;
             virtual bool isKeyDown(Key key) const = 0;
 
+            /// @brief Input collected up to the last onUpdate().
+            virtual InputState& getInput() = 0;
+
             virtual void setVSync(bool enabled) = 0;
             virtual bool isVSync() const = 0;
 
@@ -40,6 +45,9 @@ namespace vxe {
 
             virtual void setCursorEnabled(bool enabled) = 0;
 
+            /// @brief True if there is nothing on screen, the Renderer then draws into an offscreen framebuffer.
+            virtual bool isHeadless() const = 0;
+
             static std::unique_ptr<Window> Create(const WindowConfig& config = WindowConfig());
     };
 }
@@ -0,0 +1,158 @@
+#include "BrickClipmap.h"
+
+#include "../Core/Profiler.h"
+
+#include <cmath>
+
+namespace vxe {
+    static int floorDiv(int a, int b) {
+        return (a >= 0 ? a : a - b + 1) / b;
+    }
+
+    static glm::ivec3 floorDiv(const glm::ivec3& a, int b) {
+        return glm::ivec3(floorDiv(a.x, b), floorDiv(a.y, b), floorDiv(a.z, b));
+    }
+
+    BrickClipmap::BrickClipmap(const glm::ivec3& levelDimensions, int levelCount, int worldHeight)
+        : m_levelDimensions(levelDimensions), m_levelCount(std::min(std::max(levelCount, 1), MAX_LEVELS)),
+        m_worldHeight(worldHeight), m_terrain(0) {
+        m_origins.resize(m_levelCount, glm::ivec3(0));
+        m_brickMap = std::make_unique<BrickMap>(glm::ivec3(levelDimensions.x, levelDimensions.y, levelDimensions.z * m_levelCount));
+        m_brickMap->setDeduplicationEnabled(true);
+        m_brickMap->setChangeTrackingEnabled(false);
+    }
+
+    BrickClipmap::~BrickClipmap() {}
+
+    bool BrickClipmap::update(const glm::vec3& position) {
+        VXE_PROFILE_SCOPE("BrickClipmap::update");
+        bool scrolled = false;
+
+        for (int level = 0; level < m_levelCount; level++) {
+            glm::ivec3 centre = floorDiv(glm::ivec3(glm::floor(position / float(1 << level))), BRICK_SIZE);
+            glm::ivec3 origin = centre - m_levelDimensions / 2;
+            origin.y = 0;
+
+            glm::ivec3 oldOrigin = m_origins[level];
+            if (m_initialized && origin == oldOrigin) continue;
+
+            m_origins[level] = origin;
+            scrolled = true;
+            markRegionChanged(origin * (1 << level), (origin + m_levelDimensions) * (1 << level));
+
+            for (int z = origin.z; z < origin.z + m_levelDimensions.z; z++) {
+                for (int y = origin.y; y < origin.y + m_levelDimensions.y; y++) {
+                    for (int x = origin.x; x < origin.x + m_levelDimensions.x; x++) {
+                        glm::ivec3 old = glm::ivec3(x, y, z) - oldOrigin;
+                        bool wasVisible = m_initialized &&
+                            old.x >= 0 && old.y >= 0 && old.z >= 0 &&
+                            old.x < m_levelDimensions.x && old.y < m_levelDimensions.y && old.z < m_levelDimensions.z;
+
+                        if (!wasVisible)
+                            generateBrick(level, glm::ivec3(x, y, z));
+                    }
+                }
+            }
+        }
+
+        m_initialized = true;
+        m_dirty |= scrolled;
+        return scrolled;
+    }
+
+    void BrickClipmap::setVoxel(glm::ivec3 position, Material material) {
+        glm::ivec3 brickPos = floorDiv(position, BRICK_SIZE);
+        if (!inWindow(0, brickPos)) return;
+
+        m_brickMap->setVoxel(getCell(0, brickPos) * glm::ivec3(BRICK_SIZE) + (position - brickPos * glm::ivec3(BRICK_SIZE)), material);
+        m_dirty = true;
+        markBrickChanged(brickPos);
+    }
+
+    void BrickClipmap::fillRegion(glm::ivec3 position, glm::ivec3 extents, Material material) {
+        for (int z = position.z; z < position.z + extents.z; z++) {
+            for (int y = position.y; y < position.y + extents.y; y++) {
+                for (int x = position.x; x < position.x + extents.x; x++) {
+                    setVoxel(glm::ivec3(x, y, z), material);
+                }
+            }
+        }
+    }
+
+    bool BrickClipmap::generateChunk(const glm::ivec3& pos) {
+        if (!inWindow(0, pos))
+            return false;
+
+        generateBrick(0, pos);
+        m_dirty = true;
+        markBrickChanged(pos);
+
+        return true;
+    }
+
+    Material BrickClipmap::getVoxel(glm::ivec3 position) {
+        // answer from the finest level that covers the position
+        for (int level = 0; level < m_levelCount; level++) {
+            glm::ivec3 levelPos = floorDiv(position, 1 << level);
+            glm::ivec3 brickPos = floorDiv(levelPos, BRICK_SIZE);
+            if (!inWindow(level, brickPos)) continue;
+
+            return m_brickMap->getVoxel(getCell(level, brickPos) * glm::ivec3(BRICK_SIZE) + (levelPos - brickPos * glm::ivec3(BRICK_SIZE)));
+        }
+
+        return Material::AIR;
+    }
+
+    void BrickClipmap::uploadToGPU() {
+        if (!m_dirty) return;
+
+        // scrolling leaves free slots and material holes behind, compact only once they make up most of the storage.
+        // Compaction moves every brick and makes the next upload send everything again.
+        if (m_brickMap->needsCompaction())
+            m_brickMap->compact();
+
+        // only the index slices of the levels that scrolled and the bricks and materials that changed are sent
+        m_brickMap->uploadToGPU();
+        m_dirty = false;
+    }
+
+    GPUGrid BrickClipmap::getGPUGrid() {
+        return m_brickMap->getGPUGrid();
+    }
+
+    size_t BrickClipmap::getSize() {
+        return m_brickMap->getSize();
+    }
+
+    MemoryStats BrickClipmap::getMemoryStats() {
+        // solid voxels are summed over all levels, coarser levels cover the finer ones again
+        MemoryStats stats = m_brickMap->getMemoryStats();
+        stats.addVector("origins", m_origins);
+        return stats;
+    }
+
+    glm::ivec3 BrickClipmap::getClipOffset(int level) const {
+        return ((m_origins[level] % m_levelDimensions) + m_levelDimensions) % m_levelDimensions;
+    }
+
+    bool BrickClipmap::inWindow(int level, const glm::ivec3& brickPos) const {
+        glm::ivec3 local = brickPos - m_origins[level];
+        return local.x >= 0 && local.y >= 0 && local.z >= 0 &&
+            local.x < m_levelDimensions.x && local.y < m_levelDimensions.y && local.z < m_levelDimensions.z;
+    }
+
+    glm::ivec3 BrickClipmap::getCell(int level, const glm::ivec3& brickPos) const {
+        glm::ivec3 cell = ((brickPos % m_levelDimensions) + m_levelDimensions) % m_levelDimensions;
+        cell.z += level * m_levelDimensions.z;
+        return cell;
+    }
+
+    void BrickClipmap::generateBrick(int level, const glm::ivec3& brickPos) {
+        Material voxels[VOXELS_PER_BRICK];
+
+        if (m_terrain.generateBrick(brickPos, m_worldHeight, voxels, 1 << level))
+            m_brickMap->setBrick(getCell(level, brickPos), voxels);
+        else
+            m_brickMap->clearBrick(getCell(level, brickPos));
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef VXE_BRICK_CLIPMAP_H
+#define VXE_BRICK_CLIPMAP_H
+
+#include "Grid.h"
+#include "BrickMap.h"
+#include "TerrainGenerator.h"
+
+#include <vector>
+
+namespace vxe {
+    /// @brief Nested brick grids centred on the camera, each level at twice the voxel size of the one inside it.
+    ///
+    /// All levels share one BrickMap: level l occupies the cells with z in [l * dims.z, (l + 1) * dims.z).
+    /// Within a level, bricks are addressed toroidally (brick coordinate modulo the level size), so when
+    /// the camera moves only the bricks that scroll into a window are generated and everything else stays
+    /// where it is. The windows scroll horizontally only; every level starts at y = 0.
+    ///
+    /// Positions passed through the Grid interface are in level 0 voxels, and edits only affect level 0.
+    class BrickClipmap : public Grid {
+        public:
+            static constexpr int MAX_LEVELS = 8;
+
+            BrickClipmap(const glm::ivec3& levelDimensions, int levelCount, int worldHeight);
+            ~BrickClipmap();
+
+            /// @brief Recentres every level on position (in level 0 voxels) and generates the newly exposed bricks.
+            /// @return true if any level scrolled.
+            bool update(const glm::vec3& position);
+
+            void setVoxel(glm::ivec3 position, Material material) override;
+            void fillRegion(glm::ivec3 position, glm::ivec3 extents, Material material) override;
+            bool generateChunk(const glm::ivec3& pos) override;
+            Material getVoxel(glm::ivec3 position) override;
+
+            void uploadToGPU() override;
+            GPUGrid getGPUGrid() override;
+            size_t getSize() override;
+            MemoryStats getMemoryStats() override;
+
+            int getLevelCount() const { return m_levelCount; }
+            const glm::ivec3& getLevelDimensions() const { return m_levelDimensions; }
+            /// @brief Lowest brick coordinate covered by a level, in bricks of that level.
+            const glm::ivec3& getClipOrigin(int level) const { return m_origins[level]; }
+            /// @brief Cell of the clip origin within its level, i.e. the origin modulo the level dimensions.
+            glm::ivec3 getClipOffset(int level) const;
+            BrickMap* getBrickMap() const { return m_brickMap.get(); }
+
+        private:
+            glm::ivec3 m_levelDimensions;
+            int m_levelCount;
+            int m_worldHeight;
+
+            std::vector<glm::ivec3> m_origins;
+            bool m_initialized = false;
+            bool m_dirty = false;
+
+            std::unique_ptr<BrickMap> m_brickMap;
+            TerrainGenerator m_terrain;
+
+            bool inWindow(int level, const glm::ivec3& brickPos) const;
+            glm::ivec3 getCell(int level, const glm::ivec3& brickPos) const;
+            void generateBrick(int level, const glm::ivec3& brickPos);
+    };
+}
+
+#endif
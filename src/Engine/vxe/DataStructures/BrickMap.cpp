@@ -1,17 +1,16 @@
 #include "BrickMap.h"
 
-#include "../Events/Events.h"
+#include "../Core/Profiler.h"
 
 #include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
 
 namespace vxe {
-    BrickMap::BrickMap(const glm::ivec3& dimensions) : m_dimensions(dimensions), m_noise(0) {
+    BrickMap::BrickMap(const glm::ivec3& dimensions) : m_dimensions(dimensions), m_terrain(0) {
         m_indexData.resize(dimensions.x * dimensions.y * dimensions.z, 0xFFFFFFFF);
-        m_indexDataSSBO = ShaderStorageBuffer::create(0);
-        m_bricksSSBO = ShaderStorageBuffer::create(1);
-        m_materialDataSSBO = ShaderStorageBuffer::create(2);
-
-        m_noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+        m_indexSlicesDirty.resize(dimensions.z, false);
     }
 
     BrickMap::~BrickMap() {}
@@ -24,23 +23,52 @@ namespace vxe {
     }
 
     void BrickMap::setVoxel(glm::ivec3 position, Material mat) {
+        ensureOffsetsValid();
+
         int insertionPoint = setVoxelPrivate(position, mat);
 
+        glm::ivec3 brickPos = position / glm::ivec3(BRICK_SIZE);
         if (insertionPoint != -1)
-            updateMaterialOffset(insertionPoint);
+            updateMaterialOffset(insertionPoint, m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y]);
+
+        markBrickChanged(brickPos);
     }
 
     void BrickMap::fillRegion(glm::ivec3 position, glm::ivec3 extents, Material material) {
-        for (int x = position.x; x < position.x + extents.x; x++) {
-            for (int y = position.y; y < position.y + extents.y; y++) {
-                for (int z = position.z; z < position.z + extents.z; z++) {
-                    setVoxelPrivate(glm::ivec3(x, y, z), material);
+        glm::ivec3 extent = m_dimensions * glm::ivec3(BRICK_SIZE);
+        glm::ivec3 begin = glm::max(position, glm::ivec3(0));
+        glm::ivec3 end = glm::min(position + extents, extent);
+        if (begin.x >= end.x || begin.y >= end.y || begin.z >= end.z)
+            return;
+
+        // one brick at a time, so the material data of each brick is replaced in one go and the
+        // offsets of all other bricks stay valid
+        Material voxels[VOXELS_PER_BRICK];
+        for (int bz = begin.z / BRICK_SIZE; bz * BRICK_SIZE < end.z; bz++) {
+            for (int by = begin.y / BRICK_SIZE; by * BRICK_SIZE < end.y; by++) {
+                for (int bx = begin.x / BRICK_SIZE; bx * BRICK_SIZE < end.x; bx++) {
+                    glm::ivec3 brickPos(bx, by, bz);
+                    glm::ivec3 brickMin = brickPos * glm::ivec3(BRICK_SIZE);
+                    glm::ivec3 from = glm::max(begin, brickMin) - brickMin;
+                    glm::ivec3 to = glm::min(end, brickMin + glm::ivec3(BRICK_SIZE)) - brickMin;
+
+                    if (!readBrick(brickPos, voxels)) {
+                        if (material == Material::AIR) continue;
+                        std::fill(std::begin(voxels), std::end(voxels), Material::AIR);
+                    }
+
+                    for (int z = from.z; z < to.z; z++) {
+                        for (int y = from.y; y < to.y; y++) {
+                            for (int x = from.x; x < to.x; x++) {
+                                voxels[x + y * BRICK_SIZE + z * BRICK_SIZE * BRICK_SIZE] = material;
+                            }
+                        }
+                    }
+
+                    setBrick(brickPos, voxels);
                 }
             }
         }
-
-        markOffsetsInvalid();
-        VXE_DISPATCH(GridChangedEvent);
     }
 
     bool BrickMap::generateChunk(const glm::ivec3& pos) {
@@ -50,9 +78,15 @@ namespace vxe {
         pos.x < 0 || pos.y < 0 || pos.z < 0)
             return false;
 
+        // a new brick only ever grows at the end of the material data, so the other offsets stay valid
+        bool newBrick = !brickExists(pos);
+        // otherwise the offsets are rebuilt packed, which needs the material data without holes
+        if (!newBrick && m_materialHoles > 0)
+            compact();
+
         for (int z = 0; z < BRICK_SIZE; z++) {
             for (int x = 0; x < BRICK_SIZE; x++) {
-                int yTop = (m_noise.GetNoise((float) (x + pos.x * BRICK_SIZE), (float) (z + pos.z * BRICK_SIZE)) + 1.0) / 2.0 * ((m_dimensions.y * BRICK_SIZE) / 4.0) + 1.0;
+                int yTop = m_terrain.getHeight(x + pos.x * BRICK_SIZE, z + pos.z * BRICK_SIZE, m_dimensions.y * BRICK_SIZE);
 
                 if (yTop < pos.y * BRICK_SIZE) continue;
 
@@ -67,33 +101,494 @@ namespace vxe {
             }
         }
 
-        markOffsetsInvalid();
-        VXE_DISPATCH(GridChangedEvent);
+        if (!newBrick)
+            markOffsetsInvalid();
+        else if (m_deduplicate && brickExists(pos))
+            deduplicateBrick(pos);
+
+        markBrickChanged(pos);
+
+        return true;
+    }
+
+    Material BrickMap::getVoxel(glm::ivec3 position) {
+        glm::ivec3 brickPos = position / glm::ivec3(BRICK_SIZE);
+        if (position.x < 0 || position.y < 0 || position.z < 0 ||
+        brickPos.x >= m_dimensions.x || brickPos.y >= m_dimensions.y || brickPos.z >= m_dimensions.z)
+            return Material::AIR;
+
+        if (!brickExists(brickPos))
+            return Material::AIR;
+
+        ensureOffsetsValid();
+
+        glm::ivec3 localVoxelPos = position % glm::ivec3(BRICK_SIZE);
+        uint32_t voxelIndex = localVoxelPos.x + localVoxelPos.y * BRICK_SIZE + localVoxelPos.z * BRICK_SIZE * BRICK_SIZE;
+        uint32_t wordIndex = voxelIndex / 64;
+        uint32_t bitIndex = voxelIndex % 64;
+
+        Brick& brick = getBrick(brickPos);
+        if ((brick.bitmask[wordIndex] & (1UL << bitIndex)) == 0)
+            return Material::AIR;
+
+        uint32_t materialIndex = brick.materialOffset;
+        for (uint32_t w = 0; w < wordIndex; w++) {
+            materialIndex += __builtin_popcountl(brick.bitmask[w]);
+        }
+        materialIndex += __builtin_popcountl(brick.bitmask[wordIndex] & ((1UL << bitIndex) - 1));
+
+        return static_cast<Material>(m_materialData[materialIndex]);
+    }
+
+    RaycastHit BrickMap::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) {
+        constexpr float INF = std::numeric_limits<float>::infinity();
+        RaycastHit result{false, glm::ivec3(0), glm::ivec3(0), 0.0f, Material::AIR};
+
+        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+        if (length == 0.0f) return result;
+
+        glm::vec3 dir = direction / length;
+        glm::ivec3 extent = m_dimensions * glm::ivec3(BRICK_SIZE);
+        glm::ivec3 step;
+        glm::vec3 invDir, tDelta;
+
+        // clip the ray to the grid
+        float t = 0.0f;
+        float tEnd = maxDistance;
+        int entryAxis = -1;
+        for (int i = 0; i < 3; i++) {
+            step[i] = dir[i] > 0.0f ? 1 : (dir[i] < 0.0f ? -1 : 0);
+            invDir[i] = step[i] == 0 ? INF : 1.0f / dir[i];
+            tDelta[i] = std::abs(invDir[i]);
+
+            if (step[i] == 0) {
+                if (origin[i] < 0.0f || origin[i] >= extent[i]) return result;
+                continue;
+            }
+
+            float t0 = (0.0f - origin[i]) * invDir[i];
+            float t1 = (extent[i] - origin[i]) * invDir[i];
+            if (std::min(t0, t1) > t) { t = std::min(t0, t1); entryAxis = i; }
+            tEnd = std::min(tEnd, std::max(t0, t1));
+        }
+        if (t >= tEnd) return result;
+
+        glm::ivec3 normal(0);
+        if (entryAxis != -1) normal[entryAxis] = -step[entryAxis];
+
+        // on a cell boundary, a ray moving in negative direction is already in the lower cell
+        glm::vec3 p = origin + dir * t;
+        glm::ivec3 voxel;
+        for (int i = 0; i < 3; i++) {
+            voxel[i] = step[i] < 0 ? (int) std::ceil(p[i]) - 1 : (int) std::floor(p[i]);
+            voxel[i] = std::min(std::max(voxel[i], 0), extent[i] - 1);
+        }
+
+        ensureOffsetsValid();
+
+        while (t < tEnd) {
+            glm::ivec3 brickPos = voxel / glm::ivec3(BRICK_SIZE);
+            glm::ivec3 brickMin = brickPos * glm::ivec3(BRICK_SIZE);
+
+            if (!brickExists(brickPos)) {
+                // jump to where the ray leaves the brick
+                int axis = 0;
+                float tExit = INF;
+                for (int i = 0; i < 3; i++) {
+                    if (step[i] == 0) continue;
+                    float boundary = step[i] > 0 ? brickMin[i] + BRICK_SIZE : brickMin[i];
+                    float tAxis = (boundary - origin[i]) * invDir[i];
+                    if (tAxis < tExit) { tExit = tAxis; axis = i; }
+                }
+
+                t = tExit;
+                p = origin + dir * t;
+                for (int i = 0; i < 3; i++) {
+                    int v = step[i] < 0 ? (int) std::ceil(p[i]) - 1 : (int) std::floor(p[i]);
+                    voxel[i] = std::min(std::max(v, brickMin[i]), brickMin[i] + (int) BRICK_SIZE - 1);
+                }
+                voxel[axis] = step[axis] > 0 ? brickMin[axis] + BRICK_SIZE : brickMin[axis] - 1;
+                normal = glm::ivec3(0);
+                normal[axis] = -step[axis];
+
+                if (voxel[axis] < 0 || voxel[axis] >= extent[axis]) break;
+                continue;
+            }
+
+            const Brick& brick = getBrick(brickPos);
+            glm::vec3 tMax;
+            for (int i = 0; i < 3; i++) {
+                tMax[i] = step[i] == 0 ? INF : ((voxel[i] + (step[i] > 0 ? 1 : 0)) - origin[i]) * invDir[i];
+            }
+
+            // voxel DDA until the ray hits something or leaves the brick
+            while (t < tEnd) {
+                glm::ivec3 local = voxel - brickMin;
+                uint32_t voxelIndex = local.x + local.y * BRICK_SIZE + local.z * BRICK_SIZE * BRICK_SIZE;
+                if (brick.bitmask[voxelIndex / 64] & (1UL << (voxelIndex % 64))) {
+                    return {true, voxel, normal, t, getVoxel(voxel)};
+                }
+
+                int axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+                t = tMax[axis];
+                tMax[axis] += tDelta[axis];
+                voxel[axis] += step[axis];
+                normal = glm::ivec3(0);
+                normal[axis] = -step[axis];
+
+                if (voxel[axis] < brickMin[axis] || voxel[axis] >= brickMin[axis] + (int) BRICK_SIZE) break;
+            }
+
+            if (voxel.x < 0 || voxel.y < 0 || voxel.z < 0 || voxel.x >= extent.x || voxel.y >= extent.y || voxel.z >= extent.z)
+                break;
+        }
+
+        return result;
+    }
+
+    bool BrickMap::readBrick(const glm::ivec3& brickPos, Material* voxels) {
+        if (!brickExists(brickPos))
+            return false;
+
+        ensureOffsetsValid();
+
+        Brick& brick = getBrick(brickPos);
+        uint32_t materialIndex = brick.materialOffset;
+
+        for (uint32_t i = 0; i < VOXELS_PER_BRICK; i++) {
+            if (brick.bitmask[i / 64] & (1UL << (i % 64))) {
+                voxels[i] = static_cast<Material>(m_materialData[materialIndex++]);
+            } else {
+                voxels[i] = Material::AIR;
+            }
+        }
 
         return true;
     }
 
+    void BrickMap::setBrick(const glm::ivec3& brickPos, const Material* voxels) {
+        markBrickChanged(brickPos);
+
+        uint64_t bitmask[VOXELS_PER_BRICK / 64] = {0};
+        uint32_t materials[VOXELS_PER_BRICK];
+        uint32_t count = 0;
+
+        for (uint32_t i = 0; i < VOXELS_PER_BRICK; i++) {
+            if (voxels[i] == Material::AIR) continue;
+            bitmask[i / 64] |= 1UL << (i % 64);
+            materials[count++] = static_cast<uint32_t>(voxels[i]);
+        }
+
+        if (count == 0) {
+            clearBrick(brickPos);
+            return;
+        }
+
+        ensureOffsetsValid();
+
+        // a shared brick stays with its other cells, copying it would only be overwritten
+        if (brickExists(brickPos) && m_brickRefCounts[m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y]] > 1)
+            clearBrick(brickPos);
+
+        if (!brickExists(brickPos)) {
+            Brick& brick = createBrick(brickPos);
+            std::copy(std::begin(bitmask), std::end(bitmask), brick.bitmask);
+            m_materialsDirty.add(m_materialData.size());
+            m_materialData.insert(m_materialData.end(), materials, materials + count);
+
+            if (m_deduplicate)
+                deduplicateBrick(brickPos);
+            return;
+        }
+
+        size_t index = m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y];
+        Brick& brick = m_bricks[index];
+        uint32_t oldCount = brick.getVoxelCount();
+
+        // the data of the other bricks stays where it is: a brick that shrinks leaves a hole behind its
+        // materials, one that grows moves to the end and leaves its old materials behind
+        if (count <= oldCount) {
+            m_materialHoles += oldCount - count;
+        } else {
+            m_materialHoles += oldCount;
+            removeBrickFromSortedOrder(index);
+            brick.materialOffset = m_materialData.size();
+            m_materialData.resize(m_materialData.size() + count);
+            insertBrickInSortedOrder(index);
+        }
+
+        std::copy(materials, materials + count, m_materialData.begin() + brick.materialOffset);
+        m_materialsDirty.add(brick.materialOffset, brick.materialOffset + count);
+
+        std::copy(std::begin(bitmask), std::end(bitmask), brick.bitmask);
+        markBrickDirty(index);
+        markLODDirty(index);
+
+        // a replaced brick may now equal another one as much as a new brick would
+        if (m_deduplicate)
+            deduplicateBrick(brickPos);
+    }
+
+    void BrickMap::clearBrick(const glm::ivec3& brickPos) {
+        markBrickChanged(brickPos);
+
+        if (!brickExists(brickPos))
+            return;
+
+        ensureOffsetsValid();
+
+        uint32_t& cell = m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y];
+        size_t index = cell;
+        cell = 0xFFFFFFFF;
+        markCellDirty(brickPos);
+        m_logicalBrickCount--;
+
+        if (--m_brickRefCounts[index] > 0)
+            return;
+
+        releaseBrick(index);
+    }
+
+    void BrickMap::releaseBrick(size_t brickIndex) {
+        Brick& brick = m_bricks[brickIndex];
+        uint32_t count = brick.getVoxelCount();
+        removeBrickFromSortedOrder(brickIndex);
+
+        // erasing the material data would move the data of every later brick, so it stays behind until compact()
+        if (brick.materialOffset + count == m_materialData.size())
+            m_materialData.resize(brick.materialOffset);
+        else
+            m_materialHoles += count;
+
+        std::fill(std::begin(brick.bitmask), std::end(brick.bitmask), 0);
+        markBrickDirty(brickIndex);
+        m_brickRefCounts[brickIndex] = 0;
+
+        // the last slot can go right away, others wait for the next new brick
+        if (brickIndex == m_bricks.size() - 1) {
+            m_bricks.pop_back();
+            m_brickRefCounts.pop_back();
+        } else {
+            m_freeBricks.push_back(brickIndex);
+        }
+    }
+
     GPUGrid BrickMap::getGPUGrid() {
-        return {0};
+        ensureOffsetsValid();
+        updateBrickLODs();
+
+        return {{
+            {0, m_indexData.data(), m_indexData.size() * sizeof(uint32_t)},
+            {1, m_bricks.data(), m_bricks.size() * sizeof(Brick)},
+            {2, m_materialData.data(), m_materialData.size() * sizeof(uint32_t)},
+            {5, m_brickLODs.data(), m_brickLODs.size() * sizeof(BrickLOD)}
+        }};
     }
 
     size_t BrickMap::getSize() {
         return m_bricks.size();
     }
 
-    size_t BrickMap::getSizeInBytes() {
-        size_t size = m_bricks.size() * sizeof(Brick);
-        size += m_indexData.size() * sizeof(uint32_t);
-        size += m_materialData.size() * sizeof(uint32_t);
-        size += sizeof(m_bricks) + sizeof(m_indexData) + sizeof(m_materialData);
-        return size;
+    MemoryStats BrickMap::getMemoryStats() {
+        MemoryStats stats;
+        stats.addVector("bricks", m_bricks);
+        stats.addVector("bricksByOffset", m_bricksByOffset);
+        stats.addVector("indexData", m_indexData);
+        stats.addVector("materialData", m_materialData);
+        stats.addVector("brickRefCounts", m_brickRefCounts);
+        stats.addVector("freeBricks", m_freeBricks);
+        stats.addHashMap("brickLookup", m_brickLookup);
+        stats.addVector("brickLODs", m_brickLODs);
+        stats.addVector("lodDirty", m_lodDirty);
+
+        if (m_indexDataSSBO) {
+            stats.addGPUBuffer("index", m_indexDataSSBO->getSize());
+            stats.addGPUBuffer("bricks", m_bricksSSBO->getSize());
+            stats.addGPUBuffer("materials", m_materialDataSSBO->getSize());
+            stats.addGPUBuffer("brickLODs", m_brickLODsSSBO->getSize());
+        }
+
+        // shared bricks count once per cell that uses them
+        for (uint32_t index : m_indexData) {
+            if (index != 0xFFFFFFFF)
+                stats.solidVoxels += m_bricks[index].getVoxelCount();
+        }
+
+        return stats;
     }
 
-    void BrickMap::uploadToGPU() {
+    void BrickMap::deduplicate() {
+        ensureOffsetsValid();
+
+        // merge every brick into the first identical one
+        std::vector<uint32_t> canonical(m_bricks.size());
+        m_brickLookup.clear();
+
+        for (size_t i = 0; i < m_bricks.size(); i++) {
+            canonical[i] = i;
+            if (m_brickRefCounts[i] == 0) continue;
+
+            uint64_t hash = hashBrick(i);
+            auto range = m_brickLookup.equal_range(hash);
+            for (auto it = range.first; it != range.second; it++) {
+                if (bricksEqual(it->second, i)) {
+                    canonical[i] = it->second;
+                    break;
+                }
+            }
+
+            if (canonical[i] != i) {
+                m_brickRefCounts[canonical[i]] += m_brickRefCounts[i];
+                m_brickRefCounts[i] = 0;
+            } else {
+                m_brickLookup.emplace(hash, i);
+            }
+        }
+
+        for (auto& index : m_indexData) {
+            if (index != 0xFFFFFFFF)
+                index = canonical[index];
+        }
+
+        compact();
+    }
+
+    void BrickMap::compact() {
         ensureOffsetsValid();
-        m_bricksSSBO->setData(m_bricks.data(), m_bricks.size() * sizeof(Brick));
-        m_indexDataSSBO->setData(m_indexData.data(), m_indexData.size() * sizeof(uint32_t));
-        m_materialDataSSBO->setData(m_materialData.data(), m_materialData.size() * sizeof(uint32_t));
+
+        // material data is in m_bricksByOffset order, not brick order, so each brick's voxels are copied by
+        // its own offset. The copy is laid out in brick order, which is what resets m_bricksByOffset below
+        std::vector<Brick> bricks;
+        std::vector<uint32_t> materialData;
+        std::vector<uint32_t> refCounts;
+        std::vector<uint32_t> newIndex(m_bricks.size(), 0xFFFFFFFF);
+
+        for (size_t i = 0; i < m_bricks.size(); i++) {
+            if (m_brickRefCounts[i] == 0) continue;
+
+            Brick brick = m_bricks[i];
+            uint32_t count = brick.getVoxelCount();
+            brick.materialOffset = materialData.size();
+            materialData.insert(materialData.end(), m_materialData.begin() + m_bricks[i].materialOffset, m_materialData.begin() + m_bricks[i].materialOffset + count);
+
+            newIndex[i] = bricks.size();
+            bricks.push_back(brick);
+            refCounts.push_back(m_brickRefCounts[i]);
+        }
+
+        for (auto& index : m_indexData) {
+            if (index != 0xFFFFFFFF)
+                index = newIndex[index];
+        }
+
+        m_bricks = std::move(bricks);
+        m_materialData = std::move(materialData);
+        m_brickRefCounts = std::move(refCounts);
+        m_freeBricks.clear();
+        m_materialHoles = 0;
+        m_uploadAll = true;
+
+        // brick indices moved, rebuilding is simpler than remapping and compaction is rare
+        m_brickLODs.clear();
+        m_lodDirty.assign(m_bricks.size(), true);
+
+        m_bricksByOffset.resize(m_bricks.size());
+        m_brickLookup.clear();
+        for (size_t i = 0; i < m_bricks.size(); i++) {
+            m_bricksByOffset[i] = i;
+            if (m_deduplicate)
+                m_brickLookup.emplace(hashBrick(i), i);
+        }
+    }
+
+    bool BrickMap::needsCompaction() const {
+        return m_freeBricks.size() > m_bricks.size() / 2 + 1024 || m_materialHoles > m_materialData.size() / 2 + 65536;
+    }
+
+    BrickDedupStats BrickMap::getDedupStats() {
+        BrickDedupStats stats{m_logicalBrickCount, m_bricks.size() - m_freeBricks.size(), m_freeBricks.size(), 0};
+
+        for (size_t i = 0; i < m_bricks.size(); i++) {
+            if (m_brickRefCounts[i] > 1)
+                stats.bytesSaved += (m_brickRefCounts[i] - 1) * (sizeof(Brick) + m_bricks[i].getVoxelCount() * sizeof(uint32_t));
+        }
+
+        return stats;
+    }
+
+    void BrickMap::uploadToGPU() {
+        VXE_PROFILE_SCOPE("BrickMap::uploadToGPU");
+
+        // created on first upload so that grids can be built without a GL context
+        if (!m_indexDataSSBO) {
+            m_indexDataSSBO = ShaderStorageBuffer::create(0);
+            m_bricksSSBO = ShaderStorageBuffer::create(1);
+            m_materialDataSSBO = ShaderStorageBuffer::create(2);
+            m_brickLODsSSBO = ShaderStorageBuffer::create(5);
+            m_uploadAll = true;
+        }
+
+        // same order as the buffers of getGPUGrid()
+        ShaderStorageBuffer* ssbos[] = { m_indexDataSSBO.get(), m_bricksSSBO.get(), m_materialDataSSBO.get(), m_brickLODsSSBO.get() };
+        GPUGrid gpuGrid = getGPUGrid();
+
+        if (m_uploadAll) {
+            for (size_t i = 0; i < gpuGrid.buffers.size(); i++) {
+                ssbos[i]->setData(const_cast<void*>(gpuGrid.buffers[i].data), gpuGrid.buffers[i].size);
+            }
+        } else {
+            // runs of dirty z slices, for a clipmap each level is a run of slices
+            size_t sliceCells = m_dimensions.x * m_dimensions.y;
+            for (size_t z = 0; z < m_indexSlicesDirty.size();) {
+                if (!m_indexSlicesDirty[z]) { z++; continue; }
+
+                size_t first = z;
+                while (z < m_indexSlicesDirty.size() && m_indexSlicesDirty[z]) z++;
+                m_indexDataSSBO->updateData(m_indexData.data() + first * sliceCells, first * sliceCells * sizeof(uint32_t), (z - first) * sliceCells * sizeof(uint32_t));
+            }
+
+            uploadRanges(m_bricksSSBO.get(), m_bricks.data(), sizeof(Brick), m_bricks.size(), m_bricksDirty);
+            uploadRanges(m_materialDataSSBO.get(), m_materialData.data(), sizeof(uint32_t), m_materialData.size(), m_materialsDirty);
+            uploadRanges(m_brickLODsSSBO.get(), m_brickLODs.data(), sizeof(BrickLOD), m_brickLODs.size(), m_lodsDirty);
+        }
+
+        std::fill(m_indexSlicesDirty.begin(), m_indexSlicesDirty.end(), false);
+        m_bricksDirty.clear();
+        m_materialsDirty.clear();
+        m_lodsDirty.clear();
+        m_uploadAll = false;
+    }
+
+    void BrickMap::uploadRanges(ShaderStorageBuffer* ssbo, const void* data, size_t elementSize, size_t count, DirtyRanges& dirty) {
+        size_t size = count * elementSize;
+
+        // a buffer that outgrew its store is sent whole, with room for the next bricks so that it does not reallocate every time
+        if (size > ssbo->getSize()) {
+            ssbo->setData(nullptr, size + size / 2);
+            ssbo->updateData(data, 0, size);
+            return;
+        }
+
+        // ranges less than 4 KiB apart are sent together, one call costs more than that much data
+        size_t gap = std::max<size_t>(4096 / elementSize, 1);
+        auto& ranges = dirty.ranges;
+        std::sort(ranges.begin(), ranges.end());
+
+        for (size_t i = 0; i < ranges.size();) {
+            size_t first = ranges[i].first;
+            size_t last = ranges[i].second;
+            for (i++; i < ranges.size() && ranges[i].first <= last + gap; i++) {
+                last = std::max(last, ranges[i].second);
+            }
+
+            last = std::min(last, count);
+            if (first < last)
+                ssbo->updateData(static_cast<const char*>(data) + first * elementSize, first * elementSize, (last - first) * elementSize);
+        }
+    }
+
+    std::array<const ShaderStorageBuffer*, 4> BrickMap::getStorageBuffers() const {
+        return { m_indexDataSSBO.get(), m_bricksSSBO.get(), m_materialDataSSBO.get(), m_brickLODsSSBO.get() };
     }
 
     void BrickMap::insertBrickInSortedOrder(size_t brickIndex) {
@@ -107,14 +602,22 @@ namespace vxe {
     }
 
     void BrickMap::removeBrickFromSortedOrder(size_t brickIndex) {
-        
+        auto it = std::find(m_bricksByOffset.begin(), m_bricksByOffset.end(), brickIndex);
+        if (it != m_bricksByOffset.end())
+            m_bricksByOffset.erase(it);
     }
 
     void BrickMap::rebuildMaterialOfssets() {
+        // reused slots put bricks out of index order, the sorted list still has the order of the material data.
+        // Packs the bricks, so only valid while there are no material holes. Compacting here instead would
+        // not help, compact() itself needs valid offsets to find the material data, callers that leave
+        // offsets invalid compact beforehand (see generateChunk).
+        assert(m_materialHoles == 0);
         uint32_t currentOffset = 0;
-        for (auto& brick : m_bricks) {
-            brick.materialOffset = currentOffset;
-            currentOffset += brick.getVoxelCount();
+        m_bricksDirty.add(0);
+        for (size_t index : m_bricksByOffset) {
+            m_bricks[index].materialOffset = currentOffset;
+            currentOffset += m_bricks[index].getVoxelCount();
         }
     }
 
@@ -126,7 +629,10 @@ namespace vxe {
         uint32_t bitIndex = voxelIndex % 64;
         
         if (brickExists(brickPos)) {
-            Brick& brick = getBrick(brickPos);
+            Brick& brick = m_brickRefCounts[m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y]] > 1
+                ? unshareBrick(brickPos)
+                : getBrick(brickPos);
+            markLODDirty(m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y]);
 
             bool voxelWasSet = (brick.bitmask[wordIndex] & (1UL << bitIndex)) != 0;
 
@@ -137,21 +643,36 @@ namespace vxe {
             }
             materialIndex += __builtin_popcountl(brick.bitmask[wordIndex] & ((1UL << bitIndex) - 1));
 
-            if (!voxelWasSet) {
+            if (material == Material::AIR) {
+                if (voxelWasSet) {
+                    brick.bitmask[wordIndex] &= ~(1UL << bitIndex);
+                    markBrickDirty(m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y]);
+                    m_materialsDirty.add(materialIndex);
+                    m_materialData.erase(m_materialData.begin() + materialIndex);
+                    shiftMaterialOffsets(m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y], -1);
+
+                    if (brick.getVoxelCount() == 0)
+                        clearBrick(brickPos);
+                }
+            } else if (!voxelWasSet) {
                 brick.bitmask[wordIndex] |= 1UL << bitIndex;
+                markBrickDirty(m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y]);
 
+                m_materialsDirty.add(materialIndex);
                 m_materialData.insert(m_materialData.begin() + materialIndex, static_cast<uint32_t>(material));
 
                 return materialIndex;
             } else {
                 // if voxel was set before just replace the old material data
                 m_materialData[materialIndex] = static_cast<uint32_t>(material);
+                m_materialsDirty.add(materialIndex, materialIndex + 1);
             }
-        } else {
+        } else if (material != Material::AIR) {
             Brick& brick = createBrick(brickPos);
 
             brick.bitmask[wordIndex] |= 1UL << bitIndex;
             brick.materialOffset = m_materialData.size();
+            m_materialsDirty.add(m_materialData.size());
             m_materialData.push_back(static_cast<uint32_t>(material));
         }
 
@@ -169,15 +690,212 @@ namespace vxe {
         return m_bricks[index];
     }
 
+    size_t BrickMap::allocateBrick() {
+        size_t index;
+        if (!m_freeBricks.empty()) {
+            index = m_freeBricks.back();
+            m_freeBricks.pop_back();
+            m_bricks[index] = {0};
+            m_brickRefCounts[index] = 1;
+        } else {
+            index = m_bricks.size();
+            m_bricks.push_back({0});
+            m_brickRefCounts.push_back(1);
+        }
+
+        m_bricks[index].materialOffset = m_materialData.size();
+        markBrickDirty(index);
+        return index;
+    }
+
     Brick& BrickMap::createBrick(glm::ivec3 brickPos) {
-        size_t index = m_bricks.size();
-        m_bricks.push_back({0});
+        size_t index = allocateBrick();
+        m_logicalBrickCount++;
         m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y] = index;
+        markCellDirty(brickPos);
         insertBrickInSortedOrder(index);
+        markLODDirty(index);
         return m_bricks[index];
     }
 
-    void BrickMap::updateMaterialOffset(uint32_t insertionPoint) {
+    uint64_t BrickMap::hashBrick(size_t brickIndex) const {
+        const Brick& brick = m_bricks[brickIndex];
+        uint64_t hash = 14695981039346656037ULL;
+        uint32_t count = 0;
+
+        for (int i = 0; i < VOXELS_PER_BRICK / 64; i++) {
+            hash = (hash ^ brick.bitmask[i]) * 1099511628211ULL;
+            count += __builtin_popcountl(brick.bitmask[i]);
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            hash = (hash ^ m_materialData[brick.materialOffset + i]) * 1099511628211ULL;
+        }
+
+        return hash;
+    }
+
+    bool BrickMap::bricksEqual(size_t a, size_t b) const {
+        const Brick& brickA = m_bricks[a];
+        const Brick& brickB = m_bricks[b];
+        uint32_t count = 0;
+
+        for (int i = 0; i < VOXELS_PER_BRICK / 64; i++) {
+            if (brickA.bitmask[i] != brickB.bitmask[i]) return false;
+            count += __builtin_popcountl(brickA.bitmask[i]);
+        }
+
+        return std::equal(m_materialData.begin() + brickA.materialOffset, m_materialData.begin() + brickA.materialOffset + count,
+            m_materialData.begin() + brickB.materialOffset);
+    }
+
+    void BrickMap::deduplicateBrick(glm::ivec3 brickPos) {
+        ensureOffsetsValid();
+
+        uint32_t& cell = m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y];
+        uint32_t index = cell;
+        uint64_t hash = hashBrick(index);
+
+        auto range = m_brickLookup.equal_range(hash);
+        for (auto it = range.first; it != range.second; it++) {
+            // the lookup may hold bricks that were edited or released since they were added, so always compare contents
+            if (it->second == index || it->second >= m_bricks.size() || m_brickRefCounts[it->second] == 0 || !bricksEqual(it->second, index)) continue;
+
+            cell = it->second;
+            markCellDirty(brickPos);
+            m_brickRefCounts[it->second]++;
+            releaseBrick(index);
+            return;
+        }
+
+        m_brickLookup.emplace(hash, index);
+    }
+
+    Brick& BrickMap::unshareBrick(glm::ivec3 brickPos) {
+        ensureOffsetsValid();
+
+        uint32_t& cell = m_indexData[brickPos.x + brickPos.y * m_dimensions.x + brickPos.z * m_dimensions.x * m_dimensions.y];
+        size_t shared = cell;
+        size_t index = allocateBrick();
+
+        Brick copy = m_bricks[shared];
+        uint32_t count = copy.getVoxelCount();
+        copy.materialOffset = m_materialData.size();
+
+        m_materialsDirty.add(m_materialData.size());
+        m_materialData.reserve(m_materialData.size() + count);
+        for (uint32_t i = 0; i < count; i++) {
+            m_materialData.push_back(m_materialData[m_bricks[shared].materialOffset + i]);
+        }
+
+        m_bricks[index] = copy;
+        m_brickRefCounts[shared]--;
+        cell = index;
+        markCellDirty(brickPos);
+        insertBrickInSortedOrder(index);
+        markLODDirty(index);
+
+        return m_bricks[index];
+    }
+
+    void BrickMap::markLODDirty(size_t brickIndex) {
+        if (brickIndex >= m_lodDirty.size())
+            m_lodDirty.resize(m_bricks.size(), true);
+        m_lodDirty[brickIndex] = true;
+    }
+
+    void BrickMap::updateBrickLODs() {
+        m_brickLODs.resize(m_bricks.size());
+        m_lodDirty.resize(m_bricks.size(), true);
+
+        for (size_t i = 0; i < m_bricks.size(); i++) {
+            if (!m_lodDirty[i]) continue;
+            buildBrickLOD(i);
+            m_lodDirty[i] = false;
+            m_lodsDirty.add(i, i + 1);
+        }
+    }
+
+    // 2x2x2 majority: a coarse voxel is solid if at least half of its children are,
+    // and takes the most common material among them
+    static void downsampleBrick(const uint8_t* source, int size, uint8_t* target) {
+        int half = size / 2;
+
+        for (int z = 0; z < half; z++) {
+            for (int y = 0; y < half; y++) {
+                for (int x = 0; x < half; x++) {
+                    uint8_t materials[8];
+                    int counts[8];
+                    int distinct = 0;
+                    int solid = 0;
+
+                    for (int child = 0; child < 8; child++) {
+                        int cx = x * 2 + (child & 1), cy = y * 2 + ((child >> 1) & 1), cz = z * 2 + (child >> 2);
+                        uint8_t material = source[cx + cy * size + cz * size * size];
+                        if (material == static_cast<uint8_t>(Material::AIR)) continue;
+
+                        solid++;
+                        int slot = 0;
+                        while (slot < distinct && materials[slot] != material) slot++;
+                        if (slot == distinct) {
+                            materials[distinct] = material;
+                            counts[distinct++] = 0;
+                        }
+                        counts[slot]++;
+                    }
+
+                    uint8_t result = static_cast<uint8_t>(Material::AIR);
+                    if (solid >= 4) {
+                        int best = 0;
+                        for (int slot = 1; slot < distinct; slot++) {
+                            if (counts[slot] > counts[best]) best = slot;
+                        }
+                        result = materials[best];
+                    }
+
+                    target[x + y * half + z * half * half] = result;
+                }
+            }
+        }
+    }
+
+    void BrickMap::buildBrickLOD(size_t brickIndex) {
+        const Brick& brick = m_bricks[brickIndex];
+        uint8_t level0[VOXELS_PER_BRICK];
+        uint8_t level1[VOXELS_PER_BRICK / 8];
+        uint8_t level2[VOXELS_PER_BRICK / 64];
+
+        uint32_t materialIndex = brick.materialOffset;
+        for (uint32_t i = 0; i < VOXELS_PER_BRICK; i++) {
+            level0[i] = (brick.bitmask[i / 64] & (1UL << (i % 64))) ? m_materialData[materialIndex++] : 0;
+        }
+
+        downsampleBrick(level0, BRICK_SIZE, level1);
+        downsampleBrick(level1, BRICK_SIZE / 2, level2);
+
+        BrickLOD& lod = m_brickLODs[brickIndex];
+        lod = BrickLOD{};
+        for (uint32_t i = 0; i < VOXELS_PER_BRICK / 8; i++) {
+            if (level1[i] != 0) lod.level1 |= 1UL << i;
+            lod.materials1[i / 4] |= uint32_t(level1[i]) << ((i % 4) * 8);
+        }
+        for (uint32_t i = 0; i < VOXELS_PER_BRICK / 64; i++) {
+            if (level2[i] != 0) lod.level2 |= 1u << i;
+            lod.materials2[i / 4] |= uint32_t(level2[i]) << ((i % 4) * 8);
+        }
+    }
+
+    void BrickMap::shiftMaterialOffsets(size_t brickIndex, int64_t delta) {
+        auto it = std::upper_bound(m_bricksByOffset.begin(), m_bricksByOffset.end(), m_bricks[brickIndex].materialOffset, [this](uint32_t offset, size_t idx) {
+            return offset < m_bricks[idx].materialOffset;
+        });
+
+        for (; it != m_bricksByOffset.end(); it++) {
+            m_bricks[*it].materialOffset += delta;
+            markBrickDirty(*it);
+        }
+    }
+
+    void BrickMap::updateMaterialOffset(uint32_t insertionPoint, size_t editedBrick) {
         // for (auto& brick : m_bricks) {
         //     if (brick.materialOffset >= insertionPoint) {
         //         brick.materialOffset++;
@@ -189,7 +907,10 @@ namespace vxe {
         });
 
         for (auto iter = it; iter != m_bricksByOffset.end(); iter++) {
-            m_bricks[*iter].materialOffset++;
+            if (*iter != editedBrick) {
+                m_bricks[*iter].materialOffset++;
+                markBrickDirty(*iter);
+            }
         }
     }
 }
\ No newline at end of file
@@ -2,12 +2,16 @@
 #define VXE_BRICKMAP_H
 
 #include "Grid.h"
+#include "TerrainGenerator.h"
 
 #include "../Rendering/graphics/ShaderStorageBuffer.h"
 
-#include <FastNoiseLite.h>
-
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
 #include <vector>
+#include <unordered_map>
 #include <mutex>
 
 namespace vxe {
@@ -27,8 +31,35 @@ namespace vxe {
         }
     };
 
-    struct GPUGrid {
-        uint8_t dummy;
+    /// @brief Downsampled copies of a brick, uploaded alongside it for distant traversal.
+    ///
+    /// Level 1 is 4^3 and level 2 is 2^3 voxels, each built from the level below by 2x2x2 majority.
+    /// Materials are stored one byte per voxel. The layout matches the std430 struct in raymarch.frag.
+    struct BrickLOD {
+        uint64_t level1;
+        uint32_t level2;
+        uint32_t materials2[2];
+        uint32_t materials1[16];
+    };
+
+    static constexpr int BRICK_LOD_LEVELS = 2;
+
+    struct RaycastHit {
+        bool hit;
+        glm::ivec3 voxel;
+        glm::ivec3 normal;  // face the ray entered through, zero if it started inside the voxel
+        float distance;
+        Material material;
+    };
+
+    /// @brief Brick sharing statistics of a BrickMap with deduplication enabled.
+    struct BrickDedupStats {
+        size_t logicalBricks;   // grid cells that hold a brick
+        size_t physicalBricks;  // bricks actually stored, without released slots waiting for reuse
+        size_t freeBricks;      // released slots waiting for reuse, dropped by compact()
+        size_t bytesSaved;      // brick and material bytes not stored thanks to sharing
+
+        float getRatio() const { return physicalBricks == 0 ? 1.0f : (float) logicalBricks / (float) physicalBricks; }
     };
 
     class BrickMap : public Grid {
@@ -39,11 +70,41 @@ namespace vxe {
             void setVoxel(glm::ivec3 position, Material material) override;
             void fillRegion(glm::ivec3 position, glm::ivec3 extents, Material material) override;
             bool generateChunk(const glm::ivec3& pos) override;
-
+            Material getVoxel(glm::ivec3 position) override;
+
+            /// @brief Decodes the brick at brickPos into a dense BRICK_SIZE^3 block (x fastest, then y, then z).
+            /// @return false if there is no brick at that position.
+            bool readBrick(const glm::ivec3& brickPos, Material* voxels);
+            /// @brief Replaces the whole brick at brickPos with a dense block in the same layout as readBrick.
+            void setBrick(const glm::ivec3& brickPos, const Material* voxels);
+            void clearBrick(const glm::ivec3& brickPos);
+            const glm::ivec3& getDimensions() const { return m_dimensions; }
+
+            /// @brief Walks a ray through the grid on the CPU, skipping empty bricks. Everything is in voxel units.
+            RaycastHit raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+
+            /// @brief When enabled, newly generated bricks that are identical to an existing brick share its storage.
+            /// Edits to a shared brick copy it first (copy-on-write).
+            void setDeduplicationEnabled(bool enabled) { m_deduplicate = enabled; }
+            bool isDeduplicationEnabled() const { return m_deduplicate; }
+
+            /// @brief Merges all identical bricks and drops the storage of bricks that are no longer referenced.
+            void deduplicate();
+            /// @brief Drops the storage of bricks that are no longer referenced by any cell and the material
+            /// data they left behind. Brick indices move, so the next upload sends everything again.
+            void compact();
+            /// @brief Whether released slots or left behind material data make up most of the storage.
+            bool needsCompaction() const;
+            BrickDedupStats getDedupStats();
+
+            /// @brief Sends what changed since the last upload, only the first one and the one after a
+            /// compaction send everything.
             void uploadToGPU() override;
+            /// @brief Buffers of the last upload in the order of getGPUGrid(), null before the first one.
+            std::array<const ShaderStorageBuffer*, 4> getStorageBuffers() const;
             GPUGrid getGPUGrid() override;
             size_t getSize() override;
-            size_t getSizeInBytes() override;
+            MemoryStats getMemoryStats() override;
         
         private:
             glm::ivec3 m_dimensions;
@@ -52,15 +113,53 @@ namespace vxe {
             std::vector<uint32_t> m_indexData;
             std::vector<uint32_t> m_materialData;
 
+            // number of index cells pointing at each brick, > 1 means the brick is shared
+            std::vector<uint32_t> m_brickRefCounts;
+            // slots of bricks no cell points at anymore, reused by the next new brick
+            std::vector<uint32_t> m_freeBricks;
+            std::unordered_multimap<uint64_t, uint32_t> m_brickLookup;
+            size_t m_logicalBrickCount = 0;
+            bool m_deduplicate = false;
+
             std::unique_ptr<ShaderStorageBuffer> m_bricksSSBO;
             std::unique_ptr<ShaderStorageBuffer> m_indexDataSSBO;
             std::unique_ptr<ShaderStorageBuffer> m_materialDataSSBO;
 
-            FastNoiseLite m_noise;
+            // indexed like m_bricks, rebuilt on upload for bricks that changed since the last one
+            std::vector<BrickLOD> m_brickLODs;
+            std::vector<bool> m_lodDirty;
+            std::unique_ptr<ShaderStorageBuffer> m_brickLODsSSBO;
+
+            TerrainGenerator m_terrain;
             mutable std::mutex m_chunkGenMutex;
 
             bool m_offsetsNeedRebuild = false;
 
+            // material data of released or grown bricks, left in place so that the data behind it does not move
+            size_t m_materialHoles = 0;
+
+            /// @brief Element ranges [first, second) of a GPU buffer that changed since the last upload.
+            struct DirtyRanges {
+                std::vector<std::pair<size_t, size_t>> ranges;
+
+                // an end of SIZE_MAX reaches to whatever the end of the buffer is at upload
+                void add(size_t first, size_t last = SIZE_MAX) {
+                    // edits mostly come in order, so most of them extend the last range
+                    if (!ranges.empty() && first >= ranges.back().first && first <= ranges.back().second)
+                        ranges.back().second = std::max(ranges.back().second, last);
+                    else
+                        ranges.emplace_back(first, last);
+                }
+                void clear() { ranges.clear(); }
+            };
+
+            // what the next upload has to send, the index is tracked per z slice of cells
+            std::vector<bool> m_indexSlicesDirty;
+            DirtyRanges m_bricksDirty;
+            DirtyRanges m_materialsDirty;
+            DirtyRanges m_lodsDirty;
+            bool m_uploadAll = true;
+
             void ensureOffsetsValid();
             void markOffsetsInvalid() { m_offsetsNeedRebuild = true; }
 
@@ -73,7 +172,25 @@ namespace vxe {
             bool brickExists(glm::ivec3 brickPos);
             Brick& getBrick(glm::ivec3 brickPos);
             Brick& createBrick(glm::ivec3 brickPos);
-            void updateMaterialOffset(uint32_t insertionPoint);
+            // empty brick with a reference count of 1 and its material offset at the end of the material data
+            size_t allocateBrick();
+            // drops the material data of a brick nothing points at anymore and frees its slot
+            void releaseBrick(size_t brickIndex);
+            void updateMaterialOffset(uint32_t insertionPoint, size_t editedBrick);
+            void shiftMaterialOffsets(size_t brickIndex, int64_t delta);
+
+            uint64_t hashBrick(size_t brickIndex) const;
+            bool bricksEqual(size_t a, size_t b) const;
+            void deduplicateBrick(glm::ivec3 brickPos);
+            Brick& unshareBrick(glm::ivec3 brickPos);
+
+            void markCellDirty(const glm::ivec3& brickPos) { m_indexSlicesDirty[brickPos.z] = true; }
+            void markBrickDirty(size_t brickIndex) { m_bricksDirty.add(brickIndex, brickIndex + 1); }
+            static void uploadRanges(ShaderStorageBuffer* ssbo, const void* data, size_t elementSize, size_t count, DirtyRanges& dirty);
+
+            void markLODDirty(size_t brickIndex);
+            void updateBrickLODs();
+            void buildBrickLOD(size_t brickIndex);
     };
 }
 
@@ -4,8 +4,14 @@
 
 #include "Grid.h"
 
+#include <algorithm>
 #include <memory>
 #include "BrickMap.h"
+#include "SparseVoxelDAG.h"
+#include "RLEColumnGrid.h"
+#include "BrickClipmap.h"
+
+#include "../Events/Events.h"
 
 namespace vxe
 {
@@ -14,8 +20,85 @@ namespace vxe
         case GridType::BRICK_MAP: {
                 return std::make_unique<BrickMap>(dimensions);
         } break;
+        case GridType::SPARSE_VOXEL_DAG: {
+                return std::make_unique<SparseVoxelDAG>(dimensions);
+        } break;
+        case GridType::RLE_COLUMNS: {
+                return std::make_unique<RLEColumnGrid>(dimensions);
+        } break;
+        case GridType::BRICK_CLIPMAP: {
+                // dimensions are per level
+                return std::make_unique<BrickClipmap>(dimensions, 4, dimensions.y * BRICK_SIZE);
+        } break;
         }
 
         return nullptr;
     }
+
+    void Grid::flushChanges() {
+        auto changes = std::make_unique<GridChanges>();
+        std::vector<glm::ivec3>& bricks = changes->bricks;
+        std::vector<GridRegion>& regions = changes->regions;
+        {
+            std::lock_guard lock(m_changesMutex);
+            if (m_changedBricks.empty() && m_changedRegions.empty()) return;
+
+            if (VXE_EVENT_MANAGER.getListenerCount<GridChangedEvent>() == 0) {
+                m_changedBricks.clear();
+                m_changedRegions.clear();
+                return;
+            }
+
+            bricks.swap(m_changedBricks);
+            regions.swap(m_changedRegions);
+        }
+
+        std::sort(bricks.begin(), bricks.end(), [](const glm::ivec3& a, const glm::ivec3& b) {
+            return a.z != b.z ? a.z < b.z : a.y != b.y ? a.y < b.y : a.x < b.x;
+        });
+        bricks.erase(std::unique(bricks.begin(), bricks.end()), bricks.end());
+
+        GridRegion& bounds = changes->bounds;
+        bounds = {glm::ivec3(INT32_MAX), glm::ivec3(INT32_MIN)};
+        for (const auto& brick : bricks) {
+            bounds.min = glm::min(bounds.min, brick);
+            bounds.max = glm::max(bounds.max, brick + glm::ivec3(1));
+        }
+        for (const auto& region : regions) {
+            bounds.min = glm::min(bounds.min, region.min);
+            bounds.max = glm::max(bounds.max, region.max);
+        }
+
+        VXE_DISPATCH(GridChangedEvent, this, std::move(changes));
+    }
+
+    bool Grid::hasPendingChanges() const {
+        std::lock_guard lock(m_changesMutex);
+        return !m_changedBricks.empty() || !m_changedRegions.empty();
+    }
+
+    void Grid::setChangeTrackingEnabled(bool enabled) {
+        std::lock_guard lock(m_changesMutex);
+        m_trackChanges = enabled;
+        if (!enabled) {
+            std::vector<glm::ivec3>().swap(m_changedBricks);
+            std::vector<GridRegion>().swap(m_changedRegions);
+        }
+    }
+
+    void Grid::markBrickChanged(const glm::ivec3& brickPos) {
+        std::lock_guard lock(m_changesMutex);
+        if (!m_trackChanges) return;
+
+        // runs of edits usually hit the same brick, the rest is deduplicated on flush
+        if (m_changedBricks.empty() || m_changedBricks.back() != brickPos)
+            m_changedBricks.push_back(brickPos);
+    }
+
+    void Grid::markRegionChanged(const glm::ivec3& minBrick, const glm::ivec3& maxBrick) {
+        std::lock_guard lock(m_changesMutex);
+        if (!m_trackChanges || minBrick.x >= maxBrick.x || minBrick.y >= maxBrick.y || minBrick.z >= maxBrick.z) return;
+
+        m_changedRegions.push_back(GridRegion{minBrick, maxBrick});
+    }
 }
\ No newline at end of file
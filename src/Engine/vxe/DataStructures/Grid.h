@@ -3,8 +3,13 @@
 
 #include <cstddef>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include <glm/glm.hpp>
 
+#include "../Events/VoxelGridEvent.h"
+
 namespace vxe {
     enum class Material {
         AIR = 0,
@@ -20,10 +25,83 @@ namespace vxe {
     };
 
     enum class GridType {
-        BRICK_MAP
+        BRICK_MAP,
+        SPARSE_VOXEL_DAG,
+        RLE_COLUMNS,
+        BRICK_CLIPMAP
+    };
+
+    /// @brief CPU copy of one buffer of a grid, to be uploaded to the SSBO at binding.
+    struct GPUBuffer {
+        unsigned int binding;
+        const void* data;
+        size_t size;
+    };
+
+    /// @brief The buffers a grid uploads. The pointers stay valid until the grid is modified.
+    struct GPUGrid {
+        std::vector<GPUBuffer> buffers;
+
+        size_t getSizeInBytes() const {
+            size_t size = 0;
+            for (const auto& buffer : buffers) size += buffer.size;
+            return size;
+        }
     };
 
-    struct GPUGrid;
+    /// @brief Memory of one container or buffer. Used counts the live elements, reserved what is allocated.
+    struct MemoryUsage {
+        std::string name;
+        size_t usedBytes;
+        size_t reservedBytes;
+    };
+
+    /// @brief Memory report of a grid, per container on the CPU and per SSBO on the GPU.
+    struct MemoryStats {
+        std::vector<MemoryUsage> cpu;
+        std::vector<MemoryUsage> gpu;  // sizes of the buffers as of the last upload
+        size_t solidVoxels = 0;
+
+        template<typename T>
+        void addVector(const std::string& name, const std::vector<T>& vector) {
+            cpu.push_back({name, vector.size() * sizeof(T), vector.capacity() * sizeof(T)});
+        }
+
+        void addVector(const std::string& name, const std::vector<bool>& vector) {
+            cpu.push_back({name, (vector.size() + 7) / 8, vector.capacity() / 8});
+        }
+
+        /// @brief Estimate for node based hash maps: one allocation per element plus the bucket array.
+        template<typename Map>
+        void addHashMap(const std::string& name, const Map& map) {
+            size_t nodes = map.size() * (sizeof(typename Map::value_type) + sizeof(void*));
+            cpu.push_back({name, nodes, nodes + map.bucket_count() * sizeof(void*)});
+        }
+
+        void addGPUBuffer(const std::string& name, size_t size) {
+            gpu.push_back({name, size, size});
+        }
+
+        /// @brief Adds the entries of a grid this one is built on, prefixing their names.
+        void append(const std::string& prefix, const MemoryStats& other) {
+            for (const auto& usage : other.cpu) cpu.push_back({prefix + usage.name, usage.usedBytes, usage.reservedBytes});
+            for (const auto& usage : other.gpu) gpu.push_back({prefix + usage.name, usage.usedBytes, usage.reservedBytes});
+        }
+
+        size_t getUsedBytes() const { return sum(cpu, &MemoryUsage::usedBytes); }
+        size_t getReservedBytes() const { return sum(cpu, &MemoryUsage::reservedBytes); }
+        size_t getGPUBytes() const { return sum(gpu, &MemoryUsage::usedBytes); }
+
+        double getCPUBytesPerSolidVoxel() const { return solidVoxels == 0 ? 0.0 : (double) getReservedBytes() / solidVoxels; }
+        double getGPUBytesPerSolidVoxel() const { return solidVoxels == 0 ? 0.0 : (double) getGPUBytes() / solidVoxels; }
+
+        private:
+            static size_t sum(const std::vector<MemoryUsage>& usages, size_t MemoryUsage::* field) {
+                size_t total = 0;
+                for (const auto& usage : usages) total += usage.*field;
+                return total;
+            }
+    };
 
     class Grid {
         public:
@@ -32,13 +110,34 @@ namespace vxe {
             virtual void setVoxel(glm::ivec3 position, Material material) = 0; // TODO: find modular solution for material
             virtual void fillRegion(glm::ivec3 position, glm::ivec3 extents, Material material) = 0;
             virtual bool generateChunk(const glm::ivec3& pos) = 0;
+            virtual Material getVoxel(glm::ivec3 position) = 0;
 
             virtual void uploadToGPU() = 0;
             virtual GPUGrid getGPUGrid() = 0;
             virtual size_t getSize() = 0;
-            virtual size_t getSizeInBytes() = 0;
+            virtual MemoryStats getMemoryStats() = 0;
+
+            /// @brief Bytes allocated on the CPU, see getMemoryStats() for the breakdown.
+            size_t getSizeInBytes() { return getMemoryStats().getReservedBytes(); }
+
+            /// @brief Sends one GridChangedEvent with everything changed since the last flush, if anything did.
+            /// Edits only record what they touched, so call this once per frame.
+            void flushChanges();
+            bool hasPendingChanges() const;
+            /// @brief Grids used as storage by another grid turn this off, nobody flushes them.
+            void setChangeTrackingEnabled(bool enabled);
 
             static std::unique_ptr<Grid> create(const GridType& type, const glm::ivec3& dimensions);
+
+        protected:
+            void markBrickChanged(const glm::ivec3& brickPos);
+            void markRegionChanged(const glm::ivec3& minBrick, const glm::ivec3& maxBrick);
+
+        private:
+            mutable std::mutex m_changesMutex;
+            std::vector<glm::ivec3> m_changedBricks;
+            std::vector<GridRegion> m_changedRegions;
+            bool m_trackChanges = true;
     };
 }
 
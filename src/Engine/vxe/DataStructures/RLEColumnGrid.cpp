@@ -0,0 +1,255 @@
+#include "RLEColumnGrid.h"
+
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace vxe {
+    // first run that covers y, i.e. the first run ending after it
+    static std::vector<VoxelRun>::iterator findRun(std::vector<VoxelRun>& runs, int y) {
+        return std::upper_bound(runs.begin(), runs.end(), y, [](int value, const VoxelRun& run) {
+            return value < run.end;
+        });
+    }
+
+    static std::vector<VoxelRun>::const_iterator findRun(const std::vector<VoxelRun>& runs, int y) {
+        return std::upper_bound(runs.begin(), runs.end(), y, [](int value, const VoxelRun& run) {
+            return value < run.end;
+        });
+    }
+
+    // makes sure a run boundary exists at y
+    static void splitRun(std::vector<VoxelRun>& runs, int y) {
+        auto it = findRun(runs, y);
+        if (it == runs.end()) return;
+
+        int start = it == runs.begin() ? 0 : std::prev(it)->end;
+        if (start < y)
+            runs.insert(it, VoxelRun{static_cast<uint16_t>(y), it->material});
+    }
+
+    RLEColumnGrid::RLEColumnGrid(const glm::ivec3& dimensions)
+        : m_dimensions(dimensions), m_extent(dimensions * glm::ivec3(BRICK_SIZE)), m_terrain(0) {
+        if (m_extent.y > std::numeric_limits<uint16_t>::max())
+            throw std::runtime_error("RLEColumnGrid is limited to 65535 voxels in height.");
+
+        m_columns.resize(m_extent.x * m_extent.z);
+        m_dirtyBricks.resize(dimensions.x * dimensions.y * dimensions.z, false);
+    }
+
+    RLEColumnGrid::~RLEColumnGrid() {}
+
+    void RLEColumnGrid::setVoxel(glm::ivec3 position, Material material) {
+        if (!inBounds(position)) return;
+        writeSpan(position.x, position.z, position.y, position.y + 1, material);
+        markBrickChanged(position / glm::ivec3(BRICK_SIZE));
+    }
+
+    void RLEColumnGrid::fillRegion(glm::ivec3 position, glm::ivec3 extents, Material material) {
+        glm::ivec3 begin = glm::max(position, glm::ivec3(0));
+        glm::ivec3 end = glm::min(position + extents, m_extent);
+
+        if (begin.x >= end.x || begin.y >= end.y || begin.z >= end.z)
+            return;
+
+        for (int z = begin.z; z < end.z; z++) {
+            for (int x = begin.x; x < end.x; x++) {
+                writeSpan(x, z, begin.y, end.y, material);
+            }
+        }
+
+        markRegionChanged(begin / glm::ivec3(BRICK_SIZE), (end + glm::ivec3(BRICK_SIZE - 1)) / glm::ivec3(BRICK_SIZE));
+    }
+
+    bool RLEColumnGrid::generateChunk(const glm::ivec3& pos) {
+        std::lock_guard lock(m_chunkGenMutex);
+
+        if(pos.x >= m_dimensions.x || pos.y >= m_dimensions.y || pos.z >= m_dimensions.z ||
+        pos.x < 0 || pos.y < 0 || pos.z < 0)
+            return false;
+
+        int baseY = pos.y * BRICK_SIZE;
+
+        for (int z = pos.z * BRICK_SIZE; z < (pos.z + 1) * BRICK_SIZE; z++) {
+            for (int x = pos.x * BRICK_SIZE; x < (pos.x + 1) * BRICK_SIZE; x++) {
+                int yTop = m_terrain.getHeight(x, z, m_extent.y);
+
+                if (yTop < baseY) continue;
+
+                int stoneEnd = std::min(yTop, baseY + (int) BRICK_SIZE);
+                writeSpan(x, z, baseY, stoneEnd, Material::STONE);
+
+                if (yTop < baseY + BRICK_SIZE)
+                    writeSpan(x, z, yTop, yTop + 1, Material::GRASS);
+            }
+        }
+
+        markBrickChanged(pos);
+
+        return true;
+    }
+
+    Material RLEColumnGrid::getVoxel(glm::ivec3 position) {
+        if (!inBounds(position)) return Material::AIR;
+
+        const std::vector<VoxelRun>& runs = m_columns[position.x + position.z * m_extent.x];
+        auto it = findRun(runs, position.y);
+        return it == runs.end() ? Material::AIR : static_cast<Material>(it->material);
+    }
+
+    void RLEColumnGrid::setSpan(int x, int z, int y0, int y1, Material material) {
+        y0 = std::max(y0, 0);
+        y1 = std::min(y1, m_extent.y);
+        if (!writeSpan(x, z, y0, y1, material)) return;
+
+        markRegionChanged(glm::ivec3(x / BRICK_SIZE, y0 / BRICK_SIZE, z / BRICK_SIZE),
+            glm::ivec3(x / BRICK_SIZE + 1, (y1 + BRICK_SIZE - 1) / BRICK_SIZE, z / BRICK_SIZE + 1));
+    }
+
+    bool RLEColumnGrid::readBrick(const glm::ivec3& brickPos, Material* voxels) const {
+        bool empty = true;
+        int baseY = brickPos.y * BRICK_SIZE;
+
+        for (int z = 0; z < BRICK_SIZE; z++) {
+            for (int x = 0; x < BRICK_SIZE; x++) {
+                const std::vector<VoxelRun>& runs = m_columns[(brickPos.x * BRICK_SIZE + x) + (brickPos.z * BRICK_SIZE + z) * m_extent.x];
+                Material* column = voxels + x + z * BRICK_SIZE * BRICK_SIZE;
+
+                auto it = findRun(runs, baseY);
+                for (int y = 0; y < BRICK_SIZE; y++) {
+                    while (it != runs.end() && it->end <= baseY + y) it++;
+
+                    Material material = it == runs.end() ? Material::AIR : static_cast<Material>(it->material);
+                    column[y * BRICK_SIZE] = material;
+                    if (material != Material::AIR) empty = false;
+                }
+            }
+        }
+
+        return !empty;
+    }
+
+    void RLEColumnGrid::uploadToGPU() {
+        syncBricks();
+        m_brickMap->uploadToGPU();
+    }
+
+    GPUGrid RLEColumnGrid::getGPUGrid() {
+        syncBricks();
+        return m_brickMap->getGPUGrid();
+    }
+
+    void RLEColumnGrid::syncBricks() {
+        if (!m_brickMap) {
+            m_brickMap = std::make_unique<BrickMap>(m_dimensions);
+            m_brickMap->setChangeTrackingEnabled(false);
+        }
+
+        Material voxels[VOXELS_PER_BRICK];
+        for (int z = 0; z < m_dimensions.z; z++) {
+            for (int y = 0; y < m_dimensions.y; y++) {
+                for (int x = 0; x < m_dimensions.x; x++) {
+                    size_t index = x + y * m_dimensions.x + z * m_dimensions.x * m_dimensions.y;
+                    if (!m_dirtyBricks[index]) continue;
+
+                    if (readBrick(glm::ivec3(x, y, z), voxels))
+                        m_brickMap->setBrick(glm::ivec3(x, y, z), voxels);
+                    else
+                        m_brickMap->clearBrick(glm::ivec3(x, y, z));
+
+                    m_dirtyBricks[index] = false;
+                }
+            }
+        }
+
+        // compaction moves every brick and makes the next upload send everything, so only once the holes pile up
+        if (m_brickMap->needsCompaction())
+            m_brickMap->compact();
+    }
+
+    size_t RLEColumnGrid::getSize() {
+        return getRunCount();
+    }
+
+    MemoryStats RLEColumnGrid::getMemoryStats() {
+        MemoryStats stats;
+        stats.addVector("columns", m_columns);
+
+        MemoryUsage runs{"runs", 0, 0};
+        for (const auto& column : m_columns) {
+            runs.usedBytes += column.size() * sizeof(VoxelRun);
+            runs.reservedBytes += column.capacity() * sizeof(VoxelRun);
+
+            int start = 0;
+            for (const auto& run : column) {
+                if (run.material != static_cast<uint8_t>(Material::AIR))
+                    stats.solidVoxels += run.end - start;
+                start = run.end;
+            }
+        }
+        stats.cpu.push_back(runs);
+        stats.addVector("dirtyBricks", m_dirtyBricks);
+
+        // the brick map only mirrors the runs for rendering, its voxels are not counted again
+        if (m_brickMap)
+            stats.append("brickMap.", m_brickMap->getMemoryStats());
+
+        return stats;
+    }
+
+    size_t RLEColumnGrid::getRunCount() const {
+        size_t count = 0;
+        for (const auto& runs : m_columns) {
+            count += runs.size();
+        }
+        return count;
+    }
+
+    bool RLEColumnGrid::inBounds(const glm::ivec3& position) const {
+        return position.x >= 0 && position.y >= 0 && position.z >= 0 &&
+            position.x < m_extent.x && position.y < m_extent.y && position.z < m_extent.z;
+    }
+
+    bool RLEColumnGrid::writeSpan(int x, int z, int y0, int y1, Material material) {
+        if (y0 < 0 || y1 > m_extent.y || y0 >= y1 || x < 0 || z < 0 || x >= m_extent.x || z >= m_extent.z) return false;
+
+        setSpanPrivate(m_columns[x + z * m_extent.x], y0, y1, material);
+        markDirty(x, z, y0, y1);
+        return true;
+    }
+
+    void RLEColumnGrid::markDirty(int x, int z, int y0, int y1) {
+        int bx = x / BRICK_SIZE;
+        int bz = z / BRICK_SIZE;
+        for (int by = y0 / BRICK_SIZE; by <= (y1 - 1) / (int) BRICK_SIZE; by++) {
+            m_dirtyBricks[bx + by * m_dimensions.x + bz * m_dimensions.x * m_dimensions.y] = true;
+        }
+    }
+
+    void RLEColumnGrid::setSpanPrivate(std::vector<VoxelRun>& runs, int y0, int y1, Material material) {
+        uint8_t value = static_cast<uint8_t>(material);
+
+        if (runs.empty()) {
+            if (material == Material::AIR) return;
+            runs.push_back(VoxelRun{static_cast<uint16_t>(m_extent.y), static_cast<uint8_t>(Material::AIR)});
+        }
+
+        splitRun(runs, y0);
+        splitRun(runs, y1);
+
+        // runs [first, last] now cover exactly [y0, y1), collapse them into last
+        auto first = findRun(runs, y0);
+        auto last = findRun(runs, y1 - 1);
+        last->material = value;
+        size_t index = runs.erase(first, last) - runs.begin();
+
+        if (index + 1 < runs.size() && runs[index + 1].material == value)
+            runs.erase(runs.begin() + index);
+        if (index > 0 && runs[index - 1].material == value)
+            runs.erase(runs.begin() + index - 1);
+
+        if (runs.size() == 1 && runs[0].material == static_cast<uint8_t>(Material::AIR))
+            std::vector<VoxelRun>().swap(runs);
+    }
+}
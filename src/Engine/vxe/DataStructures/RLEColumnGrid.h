@@ -0,0 +1,68 @@
+#ifndef VXE_RLE_COLUMN_GRID_H
+#define VXE_RLE_COLUMN_GRID_H
+
+#include "Grid.h"
+#include "BrickMap.h"
+#include "TerrainGenerator.h"
+
+#include <vector>
+#include <mutex>
+
+namespace vxe {
+    /// @brief Run of identical voxels in a column, covering [end of the previous run, end).
+    struct VoxelRun {
+        uint16_t end;
+        uint8_t material;
+    };
+
+    /// @brief Grid that stores every (x, z) voxel column as a sorted list of runs.
+    ///
+    /// Lookups are a binary search over the runs of one column and vertical spans are edited in place,
+    /// which suits heightmap-like terrain. An empty run list is an all-air column.
+    /// The GPU consumes bricks, so uploadToGPU() converts the bricks touched since the last upload
+    /// into an internal BrickMap and uploads that.
+    class RLEColumnGrid : public Grid {
+        public:
+            RLEColumnGrid(const glm::ivec3& dimensions);
+            ~RLEColumnGrid();
+
+            void setVoxel(glm::ivec3 position, Material material) override;
+            void fillRegion(glm::ivec3 position, glm::ivec3 extents, Material material) override;
+            bool generateChunk(const glm::ivec3& pos) override;
+            Material getVoxel(glm::ivec3 position) override;
+
+            /// @brief Sets the voxels [y0, y1) of column (x, z) to material.
+            void setSpan(int x, int z, int y0, int y1, Material material);
+
+            /// @brief Decodes the brick at brickPos into a dense BRICK_SIZE^3 block (x fastest, then y, then z).
+            /// @return false if the brick contains only air.
+            bool readBrick(const glm::ivec3& brickPos, Material* voxels) const;
+
+            void uploadToGPU() override;
+            GPUGrid getGPUGrid() override;
+            size_t getSize() override;
+            MemoryStats getMemoryStats() override;
+
+            size_t getRunCount() const;
+
+        private:
+            glm::ivec3 m_dimensions;
+            glm::ivec3 m_extent;
+            std::vector<std::vector<VoxelRun>> m_columns;
+
+            std::vector<bool> m_dirtyBricks;
+            std::unique_ptr<BrickMap> m_brickMap;
+
+            TerrainGenerator m_terrain;
+            mutable std::mutex m_chunkGenMutex;
+
+            bool inBounds(const glm::ivec3& position) const;
+            // sets a span that is known to be within bounds, without recording it as a change
+            bool writeSpan(int x, int z, int y0, int y1, Material material);
+            void markDirty(int x, int z, int y0, int y1);
+            void syncBricks();
+            void setSpanPrivate(std::vector<VoxelRun>& runs, int y0, int y1, Material material);
+    };
+}
+
+#endif
@@ -0,0 +1,355 @@
+#include "SparseVoxelDAG.h"
+
+#include "BrickMap.h"
+#include "../Core/Profiler.h"
+
+#include <limits>
+
+namespace vxe {
+    static_assert(BRICK_SIZE == 8, "SparseVoxelDAG assumes bricks span three octree levels");
+    static constexpr int BRICK_LEVELS = 3;
+    static constexpr uint32_t NOT_VISITED = std::numeric_limits<uint32_t>::max();
+
+    void DAGStorage::reset(int interiorLevels) {
+        nodes.assign(interiorLevels, std::vector<DAGNode>(1, DAGNode{}));
+        nodeLookup.assign(interiorLevels, {});
+        leaves.assign(1, 0);
+        leafLookup.clear();
+    }
+
+    uint32_t DAGStorage::internNode(int level, const DAGNode& node) {
+        static const DAGNode empty{};
+        if (node == empty)
+            return 0;
+
+        auto& lookup = nodeLookup[level];
+        auto it = lookup.find(node);
+        if (it != lookup.end())
+            return it->second;
+
+        uint32_t index = nodes[level].size();
+        nodes[level].push_back(node);
+        lookup.emplace(node, index);
+        return index;
+    }
+
+    uint32_t DAGStorage::internLeaf(uint64_t leaf) {
+        if (leaf == 0)
+            return 0;
+
+        auto it = leafLookup.find(leaf);
+        if (it != leafLookup.end())
+            return it->second;
+
+        uint32_t index = leaves.size();
+        leaves.push_back(leaf);
+        leafLookup.emplace(leaf, index);
+        return index;
+    }
+
+    size_t DAGStorage::getNodeCount() const {
+        size_t count = leaves.size() - 1;
+        for (const auto& level : nodes) {
+            count += level.size() - 1;
+        }
+        return count;
+    }
+
+    SparseVoxelDAG::SparseVoxelDAG(const glm::ivec3& dimensions) : m_dimensions(dimensions), m_terrain(0) {
+        int extent = std::max(dimensions.x, std::max(dimensions.y, dimensions.z)) * BRICK_SIZE;
+
+        m_depth = BRICK_LEVELS;
+        while ((1 << m_depth) < extent) m_depth++;
+
+        m_storage.reset(m_depth - 1);
+    }
+
+    SparseVoxelDAG::~SparseVoxelDAG() {}
+
+    std::unique_ptr<SparseVoxelDAG> SparseVoxelDAG::fromBrickMap(BrickMap& brickMap) {
+        const glm::ivec3& dimensions = brickMap.getDimensions();
+        auto dag = std::make_unique<SparseVoxelDAG>(dimensions);
+
+        Material voxels[VOXELS_PER_BRICK];
+        for (int z = 0; z < dimensions.z; z++) {
+            for (int y = 0; y < dimensions.y; y++) {
+                for (int x = 0; x < dimensions.x; x++) {
+                    if (brickMap.readBrick(glm::ivec3(x, y, z), voxels))
+                        dag->setBrick(glm::ivec3(x, y, z), voxels);
+                }
+            }
+        }
+
+        dag->compact();
+        return dag;
+    }
+
+    void SparseVoxelDAG::setVoxel(glm::ivec3 position, Material material) {
+        if (!inBounds(position)) return;
+        setVoxelPrivate(position, material);
+        markBrickChanged(position / glm::ivec3(BRICK_SIZE));
+    }
+
+    void SparseVoxelDAG::fillRegion(glm::ivec3 position, glm::ivec3 extents, Material material) {
+        for (int x = position.x; x < position.x + extents.x; x++) {
+            for (int y = position.y; y < position.y + extents.y; y++) {
+                for (int z = position.z; z < position.z + extents.z; z++) {
+                    if (inBounds(glm::ivec3(x, y, z)))
+                        setVoxelPrivate(glm::ivec3(x, y, z), material);
+                }
+            }
+        }
+
+        glm::ivec3 extent = m_dimensions * glm::ivec3(BRICK_SIZE);
+        glm::ivec3 begin = glm::max(position, glm::ivec3(0));
+        glm::ivec3 end = glm::min(position + extents, extent);
+        markRegionChanged(begin / glm::ivec3(BRICK_SIZE), (end + glm::ivec3(BRICK_SIZE - 1)) / glm::ivec3(BRICK_SIZE));
+    }
+
+    bool SparseVoxelDAG::generateChunk(const glm::ivec3& pos) {
+        std::lock_guard lock(m_chunkGenMutex);
+
+        if(pos.x >= m_dimensions.x || pos.y >= m_dimensions.y || pos.z >= m_dimensions.z ||
+        pos.x < 0 || pos.y < 0 || pos.z < 0)
+            return false;
+
+        Material voxels[VOXELS_PER_BRICK];
+        if (m_terrain.generateBrick(pos, m_dimensions.y * BRICK_SIZE, voxels))
+            setBrick(pos, voxels);
+
+        markBrickChanged(pos);
+
+        return true;
+    }
+
+    Material SparseVoxelDAG::getVoxel(glm::ivec3 position) {
+        if (!inBounds(position)) return Material::AIR;
+
+        uint32_t current = m_root;
+        for (int level = 0; level < m_depth - 1 && current != 0; level++) {
+            int shift = m_depth - level - 1;
+            int slot = ((position.x >> shift) & 1) | (((position.y >> shift) & 1) << 1) | (((position.z >> shift) & 1) << 2);
+            current = m_storage.nodes[level][current].children[slot];
+        }
+
+        int slot = (position.x & 1) | ((position.y & 1) << 1) | ((position.z & 1) << 2);
+        return static_cast<Material>((m_storage.leaves[current] >> (slot * 8)) & 0xFF);
+    }
+
+    void SparseVoxelDAG::setBrick(const glm::ivec3& brickPos, const Material* voxels) {
+        int level = m_depth - BRICK_LEVELS;
+        uint32_t subtree = buildSubtree(level, glm::ivec3(0), BRICK_SIZE, voxels, BRICK_SIZE);
+        splice(level, brickPos * glm::ivec3(BRICK_SIZE), subtree);
+        markBrickChanged(brickPos);
+    }
+
+    void SparseVoxelDAG::compact() {
+        DAGStorage compacted;
+        compacted.reset(m_depth - 1);
+
+        std::vector<std::vector<uint32_t>> nodeRemap(m_depth - 1);
+        for (int level = 0; level < m_depth - 1; level++) {
+            nodeRemap[level].assign(m_storage.nodes[level].size(), NOT_VISITED);
+        }
+        std::vector<uint32_t> leafRemap(m_storage.leaves.size(), NOT_VISITED);
+
+        m_root = copyInto(compacted, 0, m_root, nodeRemap, leafRemap);
+        m_storage = std::move(compacted);
+        m_liveNodeCount = m_storage.getNodeCount();
+    }
+
+    void SparseVoxelDAG::uploadToGPU() {
+        VXE_PROFILE_SCOPE("SparseVoxelDAG::uploadToGPU");
+        GPUGrid gpuGrid = getGPUGrid();
+
+        if (!m_dagSSBO)
+            m_dagSSBO = ShaderStorageBuffer::create(4);
+        m_dagSSBO->setData(const_cast<void*>(gpuGrid.buffers[0].data), gpuGrid.buffers[0].size);
+    }
+
+    GPUGrid SparseVoxelDAG::getGPUGrid() {
+        compact();
+
+        m_gpuData.clear();
+        if (m_root == 0) {
+            m_gpuData.push_back(0);
+        } else {
+            std::vector<std::vector<uint32_t>> nodeOffsets(m_depth - 1);
+            for (int level = 0; level < m_depth - 1; level++) {
+                nodeOffsets[level].assign(m_storage.nodes[level].size(), NOT_VISITED);
+            }
+            std::vector<uint32_t> leafOffsets(m_storage.leaves.size(), NOT_VISITED);
+
+            flatten(0, m_root, nodeOffsets, leafOffsets);
+        }
+
+        return {{ {4, m_gpuData.data(), m_gpuData.size() * sizeof(uint32_t)} }};
+    }
+
+    size_t SparseVoxelDAG::getSize() {
+        return m_storage.getNodeCount();
+    }
+
+    MemoryStats SparseVoxelDAG::getMemoryStats() {
+        MemoryStats stats;
+        for (int level = 0; level < m_depth - 1; level++) {
+            stats.addVector("nodes[" + std::to_string(level) + "]", m_storage.nodes[level]);
+            stats.addHashMap("nodeLookup[" + std::to_string(level) + "]", m_storage.nodeLookup[level]);
+        }
+        stats.addVector("leaves", m_storage.leaves);
+        stats.addHashMap("leafLookup", m_storage.leafLookup);
+        stats.addVector("gpuData", m_gpuData);
+
+        if (m_dagSSBO)
+            stats.addGPUBuffer("dag", m_dagSSBO->getSize());
+
+        // solid voxels below every node, bottom up so that shared subtrees are only counted once
+        std::vector<uint64_t> below(m_storage.leaves.size());
+        for (size_t i = 0; i < m_storage.leaves.size(); i++) {
+            for (int octant = 0; octant < 8; octant++) {
+                below[i] += (m_storage.leaves[i] >> (octant * 8) & 0xFF) != 0;
+            }
+        }
+
+        for (int level = m_depth - 2; level >= 0; level--) {
+            std::vector<uint64_t> counts(m_storage.nodes[level].size());
+            for (size_t i = 0; i < counts.size(); i++) {
+                for (uint32_t child : m_storage.nodes[level][i].children) {
+                    counts[i] += below[child];
+                }
+            }
+            below = std::move(counts);
+        }
+        stats.solidVoxels = below[m_root];
+
+        return stats;
+    }
+
+    bool SparseVoxelDAG::inBounds(const glm::ivec3& position) const {
+        glm::ivec3 extent = m_dimensions * glm::ivec3(BRICK_SIZE);
+        return position.x >= 0 && position.y >= 0 && position.z >= 0 &&
+            position.x < extent.x && position.y < extent.y && position.z < extent.z;
+    }
+
+    void SparseVoxelDAG::maybeCompact() {
+        // path copying leaves the old path behind on every edit, so collect once garbage dominates
+        if (m_storage.getNodeCount() > 2 * m_liveNodeCount + (1 << 16))
+            compact();
+    }
+
+    uint32_t SparseVoxelDAG::buildSubtree(int level, const glm::ivec3& origin, int size, const Material* voxels, int stride) {
+        if (size == 2) {
+            uint64_t leaf = 0;
+            for (int slot = 0; slot < 8; slot++) {
+                glm::ivec3 p = origin + glm::ivec3(slot & 1, (slot >> 1) & 1, (slot >> 2) & 1);
+                uint64_t material = static_cast<uint64_t>(voxels[p.x + p.y * stride + p.z * stride * stride]);
+                leaf |= material << (slot * 8);
+            }
+            return m_storage.internLeaf(leaf);
+        }
+
+        int half = size / 2;
+        DAGNode node{};
+        for (int slot = 0; slot < 8; slot++) {
+            glm::ivec3 childOrigin = origin + glm::ivec3(slot & 1, (slot >> 1) & 1, (slot >> 2) & 1) * half;
+            node.children[slot] = buildSubtree(level + 1, childOrigin, half, voxels, stride);
+        }
+        return m_storage.internNode(level, node);
+    }
+
+    void SparseVoxelDAG::splice(int level, const glm::ivec3& position, uint32_t subtree) {
+        uint32_t path[32];
+        int slots[32];
+
+        uint32_t current = m_root;
+        for (int l = 0; l < level; l++) {
+            int shift = m_depth - l - 1;
+            path[l] = current;
+            slots[l] = ((position.x >> shift) & 1) | (((position.y >> shift) & 1) << 1) | (((position.z >> shift) & 1) << 2);
+            current = m_storage.nodes[l][current].children[slots[l]];
+        }
+
+        uint32_t newIndex = subtree;
+        for (int l = level - 1; l >= 0; l--) {
+            DAGNode node = m_storage.nodes[l][path[l]];
+            node.children[slots[l]] = newIndex;
+            newIndex = m_storage.internNode(l, node);
+        }
+        m_root = newIndex;
+
+        maybeCompact();
+    }
+
+    void SparseVoxelDAG::setVoxelPrivate(const glm::ivec3& position, Material material) {
+        uint32_t current = m_root;
+        for (int level = 0; level < m_depth - 1 && current != 0; level++) {
+            int shift = m_depth - level - 1;
+            int slot = ((position.x >> shift) & 1) | (((position.y >> shift) & 1) << 1) | (((position.z >> shift) & 1) << 2);
+            current = m_storage.nodes[level][current].children[slot];
+        }
+
+        int slot = (position.x & 1) | ((position.y & 1) << 1) | ((position.z & 1) << 2);
+        uint64_t leaf = m_storage.leaves[current];
+        leaf &= ~(0xFFULL << (slot * 8));
+        leaf |= static_cast<uint64_t>(material) << (slot * 8);
+
+        splice(m_depth - 1, position, m_storage.internLeaf(leaf));
+    }
+
+    uint32_t SparseVoxelDAG::copyInto(DAGStorage& target, int level, uint32_t index,
+        std::vector<std::vector<uint32_t>>& nodeRemap, std::vector<uint32_t>& leafRemap) const {
+        if (index == 0)
+            return 0;
+
+        if (level == m_depth - 1) {
+            if (leafRemap[index] == NOT_VISITED)
+                leafRemap[index] = target.internLeaf(m_storage.leaves[index]);
+            return leafRemap[index];
+        }
+
+        if (nodeRemap[level][index] == NOT_VISITED) {
+            DAGNode node = m_storage.nodes[level][index];
+            for (int slot = 0; slot < 8; slot++) {
+                node.children[slot] = copyInto(target, level + 1, node.children[slot], nodeRemap, leafRemap);
+            }
+            nodeRemap[level][index] = target.internNode(level, node);
+        }
+        return nodeRemap[level][index];
+    }
+
+    uint32_t SparseVoxelDAG::flatten(int level, uint32_t index,
+        std::vector<std::vector<uint32_t>>& nodeOffsets, std::vector<uint32_t>& leafOffsets) {
+        if (level == m_depth - 1) {
+            if (leafOffsets[index] == NOT_VISITED) {
+                uint64_t leaf = m_storage.leaves[index];
+                leafOffsets[index] = m_gpuData.size();
+                m_gpuData.push_back(static_cast<uint32_t>(leaf));
+                m_gpuData.push_back(static_cast<uint32_t>(leaf >> 32));
+            }
+            return leafOffsets[index];
+        }
+
+        if (nodeOffsets[level][index] != NOT_VISITED)
+            return nodeOffsets[level][index];
+
+        const DAGNode node = m_storage.nodes[level][index];
+        uint32_t mask = 0;
+        for (int slot = 0; slot < 8; slot++) {
+            if (node.children[slot] != 0) mask |= 1u << slot;
+        }
+
+        uint32_t offset = m_gpuData.size();
+        nodeOffsets[level][index] = offset;
+        m_gpuData.push_back(mask);
+        m_gpuData.resize(m_gpuData.size() + __builtin_popcount(mask));
+
+        uint32_t childWord = offset + 1;
+        for (int slot = 0; slot < 8; slot++) {
+            if (node.children[slot] == 0) continue;
+            uint32_t childOffset = flatten(level + 1, node.children[slot], nodeOffsets, leafOffsets);
+            m_gpuData[childWord++] = childOffset;
+        }
+
+        return offset;
+    }
+}
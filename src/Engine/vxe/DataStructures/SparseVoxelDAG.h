@@ -0,0 +1,115 @@
+#ifndef VXE_SPARSE_VOXEL_DAG_H
+#define VXE_SPARSE_VOXEL_DAG_H
+
+#include "Grid.h"
+#include "TerrainGenerator.h"
+
+#include "../Rendering/graphics/ShaderStorageBuffer.h"
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace vxe {
+    class BrickMap;
+
+    /// @brief Interior node of the DAG. A child index of 0 means the child is empty.
+    struct DAGNode {
+        uint32_t children[8];
+
+        bool operator==(const DAGNode& other) const {
+            for (int i = 0; i < 8; i++) {
+                if (children[i] != other.children[i]) return false;
+            }
+            return true;
+        }
+    };
+
+    struct DAGNodeHash {
+        size_t operator()(const DAGNode& node) const {
+            uint64_t hash = 14695981039346656037ULL;
+            for (int i = 0; i < 8; i++) {
+                hash ^= node.children[i];
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+    };
+
+    /// @brief Hash-consed node pools of a SparseVoxelDAG. Index 0 of every pool is the empty node.
+    struct DAGStorage {
+        std::vector<std::vector<DAGNode>> nodes;
+        std::vector<std::unordered_map<DAGNode, uint32_t, DAGNodeHash>> nodeLookup;
+        std::vector<uint64_t> leaves;
+        std::unordered_map<uint64_t, uint32_t> leafLookup;
+
+        void reset(int interiorLevels);
+        uint32_t internNode(int level, const DAGNode& node);
+        uint32_t internLeaf(uint64_t leaf);
+        size_t getNodeCount() const;
+    };
+
+    /// @brief Sparse voxel octree in which identical subtrees are stored only once (hash-consing).
+    ///
+    /// The octree covers a cube of 2^depth voxels. Nodes of the last interior level point to leaves,
+    /// which hold the materials of a 2x2x2 block packed into a single uint64_t (one byte per voxel).
+    /// Every edit copies the path from the edited leaf to the root, so the old path becomes garbage
+    /// that is reclaimed by compact().
+    ///
+    /// GPU layout (uint32 words, root at offset 0):
+    ///  - interior node: child mask in the low 8 bits, followed by one word offset per set bit
+    ///  - leaf: two words with the eight voxel materials, byte i = octant i
+    class SparseVoxelDAG : public Grid {
+        public:
+            SparseVoxelDAG(const glm::ivec3& dimensions);
+            ~SparseVoxelDAG();
+
+            static std::unique_ptr<SparseVoxelDAG> fromBrickMap(BrickMap& brickMap);
+
+            void setVoxel(glm::ivec3 position, Material material) override;
+            void fillRegion(glm::ivec3 position, glm::ivec3 extents, Material material) override;
+            bool generateChunk(const glm::ivec3& pos) override;
+            Material getVoxel(glm::ivec3 position) override;
+
+            /// @brief Replaces the brick at brickPos with a dense BRICK_SIZE^3 block (x fastest, then y, then z).
+            void setBrick(const glm::ivec3& brickPos, const Material* voxels);
+
+            /// @brief Drops all nodes that are no longer reachable from the root.
+            void compact();
+
+            void uploadToGPU() override;
+            GPUGrid getGPUGrid() override;
+            size_t getSize() override;
+            MemoryStats getMemoryStats() override;
+
+            int getDepth() const { return m_depth; }
+            size_t getGPUSizeInBytes() const { return m_gpuData.size() * sizeof(uint32_t); }
+
+        private:
+            glm::ivec3 m_dimensions;
+            int m_depth;
+            uint32_t m_root = 0;
+
+            DAGStorage m_storage;
+            size_t m_liveNodeCount = 0;
+            std::vector<uint32_t> m_gpuData;
+            std::unique_ptr<ShaderStorageBuffer> m_dagSSBO;
+
+            TerrainGenerator m_terrain;
+            mutable std::mutex m_chunkGenMutex;
+
+            bool inBounds(const glm::ivec3& position) const;
+            void maybeCompact();
+
+            uint32_t buildSubtree(int level, const glm::ivec3& origin, int size, const Material* voxels, int stride);
+            void splice(int level, const glm::ivec3& position, uint32_t subtree);
+            void setVoxelPrivate(const glm::ivec3& position, Material material);
+
+            uint32_t copyInto(DAGStorage& target, int level, uint32_t index,
+                std::vector<std::vector<uint32_t>>& nodeRemap, std::vector<uint32_t>& leafRemap) const;
+            uint32_t flatten(int level, uint32_t index,
+                std::vector<std::vector<uint32_t>>& nodeOffsets, std::vector<uint32_t>& leafOffsets);
+    };
+}
+
+#endif
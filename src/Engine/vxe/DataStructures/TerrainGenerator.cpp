@@ -0,0 +1,38 @@
+#include "TerrainGenerator.h"
+
+#include "BrickMap.h"
+
+namespace vxe {
+    TerrainGenerator::TerrainGenerator(int seed) : m_noise(seed) {
+        m_noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    }
+
+    int TerrainGenerator::getHeight(int x, int z, int worldHeight) const {
+        return (m_noise.GetNoise((float) x, (float) z) + 1.0) / 2.0 * (worldHeight / 4.0) + 1.0;
+    }
+
+    bool TerrainGenerator::generateBrick(const glm::ivec3& brickPos, int worldHeight, Material* voxels, int scale) const {
+        bool empty = true;
+        int baseY = brickPos.y * BRICK_SIZE;
+
+        for (int z = 0; z < BRICK_SIZE; z++) {
+            for (int x = 0; x < BRICK_SIZE; x++) {
+                // coarse voxels point sample the heightmap at their corner column
+                int yTop = getHeight((x + brickPos.x * BRICK_SIZE) * scale, (z + brickPos.z * BRICK_SIZE) * scale, worldHeight) / scale;
+
+                for (int y = 0; y < BRICK_SIZE; y++) {
+                    int worldY = baseY + y;
+                    Material material = Material::AIR;
+
+                    if (worldY < yTop) material = Material::STONE;
+                    else if (worldY == yTop) material = Material::GRASS;
+
+                    voxels[x + y * BRICK_SIZE + z * BRICK_SIZE * BRICK_SIZE] = material;
+                    if (material != Material::AIR) empty = false;
+                }
+            }
+        }
+
+        return !empty;
+    }
+}
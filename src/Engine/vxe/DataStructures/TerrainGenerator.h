@@ -0,0 +1,27 @@
+#ifndef VXE_TERRAIN_GENERATOR_H
+#define VXE_TERRAIN_GENERATOR_H
+
+#include "Grid.h"
+
+#include <FastNoiseLite.h>
+
+namespace vxe {
+    /// @brief Heightmap terrain shared by all grid implementations so they generate the same world.
+    class TerrainGenerator {
+        public:
+            TerrainGenerator(int seed = 0);
+
+            /// @brief Height of the terrain surface at the given voxel column. Voxels below it are stone, the voxel at it is grass.
+            int getHeight(int x, int z, int worldHeight) const;
+
+            /// @brief Fills a dense BRICK_SIZE^3 block (x fastest, then y, then z) for the brick at brickPos.
+            /// With a scale above 1 every voxel stands for scale^3 voxels and brickPos is in bricks of that size.
+            /// @return false if the brick contains only air.
+            bool generateBrick(const glm::ivec3& brickPos, int worldHeight, Material* voxels, int scale = 1) const;
+
+        private:
+            FastNoiseLite m_noise;
+    };
+}
+
+#endif
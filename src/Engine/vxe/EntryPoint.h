@@ -1,10 +1,10 @@
 #ifndef VXE_ENTRYPOINT_H
 #define VXE_ENTRYPOINT_H
 
-extern vxe::Application* vxe::createApplication();
+extern vxe::Application* vxe::createApplication(int argc, char** argv);
 
 int main(int argc, char** argv) {
-    auto app = vxe::createApplication();
+    auto app = vxe::createApplication(argc, argv);
     app->run();
     delete app;
 }
@@ -16,9 +16,13 @@ namespace vxe {
         KeyPressed, KeyReleased, KeyTyped,
         MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseScrolled,
         // Voxel Grid Events
-        GridChanged
+        GridChanged,
+
+        Count // keep last
     };
 
+    static constexpr size_t EVENT_TYPE_COUNT = static_cast<size_t>(EventType::Count);
+
     enum EventCategory {
         None = 0,
         EventCategoryApplication    = 1 << 0,
@@ -72,7 +76,7 @@ namespace vxe {
 
     // Macros for easy event class definition
     #define EVENT_CLASS_TYPE(type) \
-        static EventType getStaticType() { return EventType::type; } \
+        static constexpr EventType getStaticType() { return EventType::type; } \
         virtual EventType getEventType() const override { return getStaticType(); } \
         virtual const char* getName() const override { return #type; }
 
@@ -2,13 +2,13 @@
 #define VXE_EVENT_MANAGER_H
 
 #include "Event.h"
+#include "EventQueue.h"
+#include "../Core/Profiler.h"
+#include <array>
 #include <functional>
 #include <vector>
-#include <unordered_map>
 #include <memory>
-#include <queue>
 #include <mutex>
-#include <typeindex>
 
 namespace vxe {
 
@@ -16,30 +16,12 @@ namespace vxe {
     template<typename EventType>
     using EventCallback = std::function<bool(EventType&)>;
 
-    // Base listener interface
-    class IEventListener {
-    public:
-        virtual ~IEventListener() = default;
-        virtual bool handleEvent(Event& event) = 0;
-        virtual std::type_index getEventType() const = 0;
-    };
-
-    // Templated event listener
-    template<typename EventType>
-    class EventListener : public IEventListener {
-    public:
-        EventListener(EventCallback<EventType> callback) : m_callback(callback) {}
+    // Listener as a plain function pointer plus the object it is called on, no allocation or type erasure per call
+    struct EventDelegate {
+        void* instance;
+        bool (*function)(void* instance, Event& event);
 
-        bool handleEvent(Event& event) override {
-            return m_callback(static_cast<EventType&>(event));
-        }
-
-        std::type_index getEventType() const override {
-            return std::type_index(typeid(EventType));
-        }
-
-    private:
-        EventCallback<EventType> m_callback;
+        bool operator()(Event& event) const { return function(instance, event); }
     };
 
     class EventManager {
@@ -53,8 +35,16 @@ namespace vxe {
         template<typename EventType>
         void subscribe(EventCallback<EventType> callback) {
             std::lock_guard<std::mutex> lock(m_mutex);
-            auto listener = std::make_shared<EventListener<EventType>>(callback);
-            m_listeners[std::type_index(typeid(EventType))].push_back(listener);
+            auto stored = std::make_unique<EventCallback<EventType>>(std::move(callback));
+            getListeners(EventType::getStaticType()).push_back({stored.get(), &invokeCallback<EventType>});
+            m_callbacks.push_back(std::unique_ptr<void, void(*)(void*)>(stored.release(), &deleteCallback<EventType>));
+        }
+
+        // Subscribe to an event type with a member function known at compile time, called directly
+        template<typename EventType, auto MemberFunc, typename T>
+        void subscribe(T* instance) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            getListeners(EventType::getStaticType()).push_back({instance, &invokeMember<EventType, T, MemberFunc>});
         }
 
         // Subscribe to an event type with a member function
@@ -69,88 +59,116 @@ namespace vxe {
         template<typename EventType>
         void unsubscribe() {
             std::lock_guard<std::mutex> lock(m_mutex);
-            m_listeners.erase(std::type_index(typeid(EventType)));
+            getListeners(EventType::getStaticType()).clear();
         }
 
-        // Dispatch an event immediately
+        // Dispatch an event immediately, the event lives on the stack
         template<typename EventType, typename... Args>
         void dispatch(Args&&... args) {
-            auto event = std::make_unique<EventType>(std::forward<Args>(args)...);
-            dispatchEvent(*event);
+            auto& listeners = getListeners(EventType::getStaticType());
+            if (listeners.empty()) return;
+
+            EventType event(std::forward<Args>(args)...);
+            invokeListeners(listeners, event);
         }
 
-        // Queue an event for later processing
+        // Queue an event for later processing, safe to call from any thread and from event handlers
         template<typename EventType, typename... Args>
         void queueEvent(Args&&... args) {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_eventQueue.push(std::make_unique<EventType>(std::forward<Args>(args)...));
+            m_eventQueue.push<EventType>(std::forward<Args>(args)...);
         }
 
-        // Process all queued events
+        // Process the events queued so far, events queued by the handlers are processed on the next call.
+        // Must always be called from the same thread.
         void processEvents() {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            while (!m_eventQueue.empty()) {
-                auto& event = m_eventQueue.front();
-                dispatchEvent(*event);
-                m_eventQueue.pop();
-            }
+            VXE_PROFILE_SCOPE("EventManager::processEvents");
+            m_eventQueue.drain([this](Event& event) {
+                dispatchEvent(event);
+            });
         }
 
         // Direct event dispatch
         void dispatchEvent(Event& event) {
-            std::type_index eventType = std::type_index(typeid(event));
-            
-            auto it = m_listeners.find(eventType);
-            if (it != m_listeners.end()) {
-                for (auto& listener : it->second) {
-                    if (event.isHandled()) break;
-                    listener->handleEvent(event);
-                }
-            }
+            invokeListeners(getListeners(event.getEventType()), event);
         }
 
         // Clear all listeners
         void clear() {
             std::lock_guard<std::mutex> lock(m_mutex);
-            m_listeners.clear();
-            std::queue<std::unique_ptr<Event>> empty;
-            m_eventQueue.swap(empty);
+            for (auto& listeners : m_listeners) listeners.clear();
+            m_callbacks.clear();
+            m_eventQueue.discard();
         }
 
         // Get number of listeners for a specific event type
         template<typename EventType>
         size_t getListenerCount() const {
             std::lock_guard<std::mutex> lock(m_mutex);
-            auto it = m_listeners.find(std::type_index(typeid(EventType)));
-            return it != m_listeners.end() ? it->second.size() : 0;
+            return m_listeners[static_cast<size_t>(EventType::getStaticType())].size();
         }
 
         // Check if there are any events in the queue
         bool hasQueuedEvents() const {
-            std::lock_guard<std::mutex> lock(m_mutex);
             return !m_eventQueue.empty();
         }
 
         size_t getQueuedEventCount() const {
-            std::lock_guard<std::mutex> lock(m_mutex);
             return m_eventQueue.size();
         }
 
+        EventQueueMetrics getQueueMetrics() const {
+            return m_eventQueue.getMetrics();
+        }
+
+        void resetQueueMetrics() {
+            m_eventQueue.resetMetrics();
+        }
+
     private:
         EventManager() = default;
         ~EventManager() = default;
         EventManager(const EventManager&) = delete;
         EventManager& operator=(const EventManager&) = delete;
 
+        template<typename EventType>
+        static bool invokeCallback(void* callback, Event& event) {
+            return (*static_cast<EventCallback<EventType>*>(callback))(static_cast<EventType&>(event));
+        }
+
+        template<typename EventType>
+        static void deleteCallback(void* callback) {
+            delete static_cast<EventCallback<EventType>*>(callback);
+        }
+
+        template<typename EventType, typename T, auto MemberFunc>
+        static bool invokeMember(void* instance, Event& event) {
+            return (static_cast<T*>(instance)->*MemberFunc)(static_cast<EventType&>(event));
+        }
+
+        std::vector<EventDelegate>& getListeners(EventType type) {
+            return m_listeners[static_cast<size_t>(type)];
+        }
+
+        static void invokeListeners(const std::vector<EventDelegate>& listeners, Event& event) {
+            // by index, a listener may subscribe another one while we iterate
+            for (size_t i = 0; i < listeners.size(); i++) {
+                if (event.isHandled()) break;
+                listeners[i](event);
+            }
+        }
+
         mutable std::mutex m_mutex;
-        std::unordered_map<std::type_index, std::vector<std::shared_ptr<IEventListener>>> m_listeners;
-        std::queue<std::unique_ptr<Event>> m_eventQueue;
+        // indexed by EventType
+        std::array<std::vector<EventDelegate>, EVENT_TYPE_COUNT> m_listeners;
+        // owns the std::function behind callback listeners
+        std::vector<std::unique_ptr<void, void(*)(void*)>> m_callbacks;
+        EventQueue m_eventQueue;
     };
 
     // Convenience macros
     #define VXE_EVENT_MANAGER vxe::EventManager::getInstance()
     #define VXE_SUBSCRIBE(EventType, callback) VXE_EVENT_MANAGER.subscribe<EventType>(callback)
-    #define VXE_SUBSCRIBE_MEMBER(EventType, instance, memberFunc) VXE_EVENT_MANAGER.subscribe<EventType>(instance, memberFunc)
+    #define VXE_SUBSCRIBE_MEMBER(EventType, instance, memberFunc) VXE_EVENT_MANAGER.subscribe<EventType, memberFunc>(instance)
     #define VXE_DISPATCH(EventType, ...) VXE_EVENT_MANAGER.dispatch<EventType>(__VA_ARGS__)
     #define VXE_QUEUE_EVENT(EventType, ...) VXE_EVENT_MANAGER.queueEvent<EventType>(__VA_ARGS__)
     #define VXE_PROCESS_EVENTS() VXE_EVENT_MANAGER.processEvents()
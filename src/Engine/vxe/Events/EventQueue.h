@@ -0,0 +1,302 @@
+#ifndef VXE_EVENT_QUEUE_H
+#define VXE_EVENT_QUEUE_H
+
+#include "Event.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+namespace vxe {
+
+    struct EventQueueMetrics {
+        size_t capacity;            // current size of the ring, grows after overflows
+        uint32_t resizes;
+        uint64_t enqueued;
+        uint64_t overflowed;        // events that did not fit into the ring and went to the locked fallback
+        size_t highWaterMark;       // most events waiting in the ring at once
+        double averageEnqueueNs;    // time spent in push(), sampled
+        uint64_t maxEnqueueNs;
+    };
+
+    // Bounded multi-producer/single-consumer queue of events (Vyukov's sequence-numbered ring).
+    //
+    // Every slot has inline storage the event is constructed in, so queueing does not allocate. The
+    // sequence number of a slot tells producers whether it is free for their position and the consumer
+    // whether it has been published. If the ring is full, events go to a mutex protected overflow list
+    // instead of blocking, so a handler may queue events even while the ring is being drained.
+    // Events from one producer are handled in the order they were queued.
+    //
+    // A drain that found overflowed events replaces the ring by one large enough for them (up to
+    // MAX_CAPACITY), so a queue that is too small for its load stops taking the locked path. Producers
+    // may still hold the old ring, so it is kept until the queue is destroyed.
+    class EventQueue {
+    public:
+        static constexpr size_t EVENT_STORAGE_SIZE = 64;
+        static constexpr size_t MAX_CAPACITY = 16384;
+        static constexpr uint32_t LATENCY_SAMPLE_INTERVAL = 16;
+
+        explicit EventQueue(size_t capacity = 1024) {
+            if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+                throw std::runtime_error("EventQueue capacity must be a power of two.");
+
+            m_rings.push_back(std::make_unique<Ring>(capacity, 0));
+            m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+        }
+
+        ~EventQueue() {
+            discard();
+        }
+
+        EventQueue(const EventQueue&) = delete;
+        EventQueue& operator=(const EventQueue&) = delete;
+
+        // Can be called from any thread
+        template<typename EventType, typename... Args>
+        void push(Args&&... args) {
+            static_assert(sizeof(EventType) <= EVENT_STORAGE_SIZE, "Event does not fit into an EventQueue slot.");
+            static_assert(alignof(EventType) <= alignof(std::max_align_t), "Event is over-aligned for an EventQueue slot.");
+
+            // reading the clock costs as much as the push itself, so only every 16th push per thread is timed
+            static thread_local uint32_t pushCount = 0;
+            bool timed = (pushCount++ & (LATENCY_SAMPLE_INTERVAL - 1)) == 0;
+            auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+            // once events overflowed, later ones follow them until the next drain to keep the order
+            Slot* slot = nullptr;
+            Ring* ring = m_ring.load(std::memory_order_acquire);
+            size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+            while (m_overflowSize.load(std::memory_order_acquire) == 0) {
+                Slot& candidate = ring->at(position);
+                size_t sequence = candidate.sequence.load(std::memory_order_acquire);
+                intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+                if (difference == 0) {
+                    if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot = &candidate;
+                        break;
+                    }
+                } else if (difference < 0) {
+                    // full, unless the consumer has just replaced the ring
+                    Ring* current = m_ring.load(std::memory_order_acquire);
+                    if (current == ring) break;
+                    ring = current;
+                    position = m_enqueuePosition.load(std::memory_order_relaxed);
+                } else {
+                    position = m_enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            if (slot) {
+                // read before publishing, the consumer cannot be past this event yet
+                size_t dequeued = m_dequeuePosition.load(std::memory_order_relaxed) + m_skippedPositions.load(std::memory_order_relaxed);
+                slot->event = new (slot->storage) EventType(std::forward<Args>(args)...);
+                slot->sequence.store(position + 1, std::memory_order_release);
+                updateMax(m_highWaterMark, distance(dequeued, position + 1));
+            } else {
+                std::lock_guard<std::mutex> lock(m_overflowMutex);
+                m_overflow.push_back(std::make_unique<EventType>(std::forward<Args>(args)...));
+                m_overflowSize.store(m_overflow.size(), std::memory_order_release);
+                m_overflowed.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            m_enqueued.fetch_add(1, std::memory_order_relaxed);
+            if (timed) {
+                uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                m_timedEnqueues.fetch_add(1, std::memory_order_relaxed);
+                m_enqueueNs.fetch_add(elapsed, std::memory_order_relaxed);
+                updateMax(m_maxEnqueueNs, elapsed);
+            }
+        }
+
+        // Consumer thread only. Hands every event queued before the call to handler, events queued
+        // while draining are left for the next call.
+        template<typename Handler>
+        size_t drain(Handler&& handler) {
+            size_t end = m_enqueuePosition.load(std::memory_order_acquire);
+
+            // taken together with end so that no ring event queued after an overflowed one is handled before it
+            std::vector<std::unique_ptr<Event>> overflow;
+            if (m_overflowSize.load(std::memory_order_acquire) > 0) {
+                std::lock_guard<std::mutex> lock(m_overflowMutex);
+                end = m_enqueuePosition.load(std::memory_order_acquire);
+                overflow.swap(m_overflow);
+                m_overflowSize.store(0, std::memory_order_release);
+            }
+
+            size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+            size_t count = 0;
+            while (position != end) {
+                if (m_retiredRing && position == m_retiredEnd) {
+                    // the old ring is empty, the current one starts after the positions skipped by grow()
+                    position = m_resumePosition;
+                    m_retiredRing = nullptr;
+                    m_dequeuePosition.store(position, std::memory_order_relaxed);
+                    m_skippedPositions.store(0, std::memory_order_relaxed);
+                    continue;
+                }
+
+                Ring* ring = m_retiredRing ? m_retiredRing : m_ring.load(std::memory_order_relaxed);
+                Slot& slot = ring->at(position);
+                // claimed but not yet written, everything after it waits for the next drain
+                if (slot.sequence.load(std::memory_order_acquire) != position + 1) break;
+
+                handler(*slot.event);
+                slot.event->~Event();
+
+                // a slot of the old ring must never look free again to a producer that still holds it
+                slot.sequence.store(ring == m_retiredRing ? position : position + ring->capacity, std::memory_order_release);
+                m_dequeuePosition.store(++position, std::memory_order_relaxed);
+                count++;
+            }
+
+            if (position != end && !overflow.empty()) {
+                // the overflowed events are newer than the ring events we stopped at, keep them for later
+                std::lock_guard<std::mutex> lock(m_overflowMutex);
+                overflow.insert(overflow.end(), std::make_move_iterator(m_overflow.begin()), std::make_move_iterator(m_overflow.end()));
+                m_overflow.swap(overflow);
+                m_overflowSize.store(m_overflow.size(), std::memory_order_release);
+                return count;
+            }
+
+            for (auto& event : overflow) {
+                handler(*event);
+            }
+
+            if (!overflow.empty())
+                grow(m_ring.load(std::memory_order_relaxed)->capacity + overflow.size());
+
+            return count + overflow.size();
+        }
+
+        // Consumer thread only. Destroys the queued events without handling them.
+        void discard() {
+            while (drain([](Event&) {}) > 0) {}
+        }
+
+        size_t size() const {
+            size_t dequeued = m_dequeuePosition.load(std::memory_order_relaxed) + m_skippedPositions.load(std::memory_order_relaxed);
+            return distance(dequeued, m_enqueuePosition.load(std::memory_order_relaxed)) + m_overflowSize.load(std::memory_order_relaxed);
+        }
+
+        bool empty() const { return size() == 0; }
+
+        EventQueueMetrics getMetrics() const {
+            uint64_t timed = m_timedEnqueues.load(std::memory_order_relaxed);
+            return {
+                m_ring.load(std::memory_order_relaxed)->capacity,
+                m_resizes.load(std::memory_order_relaxed),
+                m_enqueued.load(std::memory_order_relaxed),
+                m_overflowed.load(std::memory_order_relaxed),
+                m_highWaterMark.load(std::memory_order_relaxed),
+                timed == 0 ? 0.0 : (double) m_enqueueNs.load(std::memory_order_relaxed) / timed,
+                m_maxEnqueueNs.load(std::memory_order_relaxed)
+            };
+        }
+
+        void resetMetrics() {
+            m_enqueued.store(0, std::memory_order_relaxed);
+            m_overflowed.store(0, std::memory_order_relaxed);
+            m_highWaterMark.store(0, std::memory_order_relaxed);
+            m_timedEnqueues.store(0, std::memory_order_relaxed);
+            m_enqueueNs.store(0, std::memory_order_relaxed);
+            m_maxEnqueueNs.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        struct alignas(64) Slot {
+            std::atomic<size_t> sequence;
+            Event* event;   // the base of the event constructed in storage
+            alignas(std::max_align_t) unsigned char storage[EVENT_STORAGE_SIZE];
+        };
+
+        struct Ring {
+            Ring(size_t capacity, size_t firstPosition) : capacity(capacity), mask(capacity - 1), slots(std::make_unique<Slot[]>(capacity)) {
+                for (size_t i = 0; i < capacity; i++) {
+                    at(firstPosition + i).sequence.store(firstPosition + i, std::memory_order_relaxed);
+                }
+            }
+
+            Slot& at(size_t position) { return slots[position & mask]; }
+
+            const size_t capacity;
+            const size_t mask;
+            std::unique_ptr<Slot[]> slots;
+        };
+
+        // Consumer thread only. Switches producers to a ring of at least the given capacity, the events
+        // left in the old one are drained from it first.
+        void grow(size_t capacity) {
+            Ring* ring = m_ring.load(std::memory_order_relaxed);
+            if (m_retiredRing || ring->capacity >= MAX_CAPACITY) return;
+
+            size_t newCapacity = ring->capacity;
+            while (newCapacity < capacity && newCapacity < MAX_CAPACITY) newCapacity *= 2;
+            if (newCapacity == ring->capacity) return;
+
+            // no producer can claim a position of the old ring from here on: its free slots all wait for
+            // positions below first, and a producer that still reads them sees a full ring and reloads
+            size_t first = m_dequeuePosition.load(std::memory_order_relaxed) + ring->capacity;
+            m_rings.push_back(std::make_unique<Ring>(newCapacity, first));
+            m_ring.store(m_rings.back().get(), std::memory_order_release);
+
+            size_t end = m_enqueuePosition.load(std::memory_order_relaxed);
+            while (!m_enqueuePosition.compare_exchange_weak(end, first, std::memory_order_relaxed)) {}
+
+            m_retiredRing = ring;
+            m_retiredEnd = end;
+            m_resumePosition = first;
+            m_skippedPositions.store(first - end, std::memory_order_relaxed);
+            m_resizes.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // the positions are read one after the other and the consumer may move on in between, so to can be behind from
+        static size_t distance(size_t from, size_t to) {
+            intptr_t difference = (intptr_t) to - (intptr_t) from;
+            return difference > 0 ? (size_t) difference : 0;
+        }
+
+        template<typename T>
+        static void updateMax(std::atomic<T>& maximum, T value) {
+            T current = maximum.load(std::memory_order_relaxed);
+            while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        }
+
+        std::atomic<Ring*> m_ring{nullptr};
+        // every ring so far, a producer may still be looking at an old one
+        std::vector<std::unique_ptr<Ring>> m_rings;
+
+        // consumer only, set by grow() until the events left in the old ring are drained
+        Ring* m_retiredRing = nullptr;
+        size_t m_retiredEnd = 0;
+        size_t m_resumePosition = 0;
+
+        // on separate cache lines, producers only contend on the first one
+        alignas(64) std::atomic<size_t> m_enqueuePosition{0};
+        alignas(64) std::atomic<size_t> m_dequeuePosition{0};
+        // positions between the old and the new ring that no event will ever use, excluded from size()
+        std::atomic<size_t> m_skippedPositions{0};
+
+        std::mutex m_overflowMutex;
+        std::vector<std::unique_ptr<Event>> m_overflow;
+        std::atomic<size_t> m_overflowSize{0};
+
+        std::atomic<uint32_t> m_resizes{0};
+        std::atomic<uint64_t> m_enqueued{0};
+        std::atomic<uint64_t> m_overflowed{0};
+        std::atomic<size_t> m_highWaterMark{0};
+        std::atomic<uint64_t> m_timedEnqueues{0};
+        std::atomic<uint64_t> m_enqueueNs{0};
+        std::atomic<uint64_t> m_maxEnqueueNs{0};
+    };
+
+} // namespace vxe
+
+#endif // VXE_EVENT_QUEUE_H
@@ -7,10 +7,14 @@ namespace vxe {
 
     class MouseMovedEvent : public Event {
     public:
-        MouseMovedEvent(float x, float y) : m_mouseX(x), m_mouseY(y) {}
+        MouseMovedEvent(float x, float y, float deltaX = 0.0f, float deltaY = 0.0f)
+            : m_mouseX(x), m_mouseY(y), m_deltaX(deltaX), m_deltaY(deltaY) {}
 
         float getX() const { return m_mouseX; }
         float getY() const { return m_mouseY; }
+        // movement since the previous MouseMovedEvent, summed over all cursor updates of the frame
+        float getDeltaX() const { return m_deltaX; }
+        float getDeltaY() const { return m_deltaY; }
 
         std::string toString() const override {
             return "MouseMovedEvent: " + std::to_string(m_mouseX) + ", " + std::to_string(m_mouseY);
@@ -21,6 +25,7 @@ namespace vxe {
 
     private:
         float m_mouseX, m_mouseY;
+        float m_deltaX, m_deltaY;
     };
 
     class MouseScrolledEvent : public Event {
@@ -3,14 +3,54 @@
 
 #include "Event.h"
 
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
 namespace vxe {
+    class Grid;
+
+    /// @brief Box of bricks, min inclusive and max exclusive.
+    struct GridRegion {
+        glm::ivec3 min;
+        glm::ivec3 max;
+    };
+
+    /// @brief Everything that changed in a grid since its last Grid::flushChanges().
+    ///
+    /// Single edits are listed as bricks, bulk edits (fillRegion, clipmap scrolling) as regions.
+    /// Brick coordinates are those of the grid, level 0 bricks for a clipmap.
+    struct GridChanges {
+        std::vector<glm::ivec3> bricks;
+        std::vector<GridRegion> regions;
+        GridRegion bounds;  // smallest region containing all changed bricks and regions
+    };
+
+    /// @brief Sent once per Grid::flushChanges() that found changes.
+    ///
+    /// The lists live behind a pointer so that the event fits into an EventQueue slot and can be queued.
     class GridChangedEvent : public Event {
     public:
-        GridChangedEvent() = default;
+        GridChangedEvent(Grid* grid, std::unique_ptr<const GridChanges> changes)
+            : m_grid(grid), m_changes(std::move(changes)) {}
+
+        Grid* getGrid() const { return m_grid; }
+        const std::vector<glm::ivec3>& getBricks() const { return m_changes->bricks; }
+        const std::vector<GridRegion>& getRegions() const { return m_changes->regions; }
+        /// @brief Smallest region containing all changed bricks and regions.
+        const GridRegion& getBounds() const { return m_changes->bounds; }
+
+        std::string toString() const override {
+            return "GridChangedEvent: " + std::to_string(getBricks().size()) + " bricks, " + std::to_string(getRegions().size()) + " regions";
+        }
 
         EVENT_CLASS_TYPE(GridChanged);
         EVENT_CLASS_CATEGORY(EventCategoryVoxelGrid);
+
+    private:
+        Grid* m_grid;
+        std::unique_ptr<const GridChanges> m_changes;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
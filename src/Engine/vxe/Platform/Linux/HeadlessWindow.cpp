@@ -0,0 +1,110 @@
+#include "HeadlessWindow.h"
+
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+namespace vxe {
+    static bool hasExtension(const char* extensions, const char* name) {
+        if (!extensions) return false;
+
+        size_t length = std::strlen(name);
+        for (const char* found = std::strstr(extensions, name); found; found = std::strstr(found + length, name)) {
+            bool start = found == extensions || found[-1] == ' ';
+            bool end = found[length] == ' ' || found[length] == '\0';
+            if (start && end) return true;
+        }
+        return false;
+    }
+
+    static EGLDisplay getDisplay() {
+        // the surfaceless platform needs neither X11 nor Wayland nor a DRM device
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (hasExtension(clientExtensions, "EGL_EXT_platform_base") && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+            auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (getPlatformDisplay) {
+                EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+                if (display != EGL_NO_DISPLAY) return display;
+            }
+        }
+
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    HeadlessWindow::HeadlessWindow(const WindowConfig& config)
+        : m_width(config.width), m_height(config.height) {}
+
+    HeadlessWindow::~HeadlessWindow() {
+        if (m_display == EGL_NO_DISPLAY) return;
+
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_context != EGL_NO_CONTEXT) eglDestroyContext(m_display, m_context);
+        if (m_surface != EGL_NO_SURFACE) eglDestroySurface(m_display, m_surface);
+        eglTerminate(m_display);
+    }
+
+    void HeadlessWindow::onUpdate() {
+        // keeps the per-frame bookkeeping going, e.g. for the latency stats
+        m_input.endFrame();
+    }
+
+    void HeadlessWindow::setOpenGLContext() {
+        m_display = getDisplay();
+        EGLint major, minor;
+        if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, &major, &minor)) {
+            spdlog::error("Failed to initialize EGL (error 0x{:x}).", eglGetError());
+            throw std::runtime_error("Failed to initialize EGL!");
+        }
+        spdlog::info("Initialized EGL {}.{} ({}).", major, minor, eglQueryString(m_display, EGL_VENDOR));
+
+        bool surfaceless = hasExtension(eglQueryString(m_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+        // without a surface type eglChooseConfig only returns window configs, of which the surfaceless
+        // platform has none, so the pbuffer bit is asked for even when no pbuffer is created
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_NONE
+        };
+
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(m_display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+            spdlog::error("No EGL config for desktop OpenGL (error 0x{:x}).", eglGetError());
+            throw std::runtime_error("Failed to choose an EGL config!");
+        }
+
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 4,
+            EGL_CONTEXT_MINOR_VERSION, 5,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (m_context == EGL_NO_CONTEXT) {
+            spdlog::error("Failed to create an OpenGL 4.5 core context (error 0x{:x}).", eglGetError());
+            throw std::runtime_error("Failed to create EGL context!");
+        }
+
+        // everything is drawn into framebuffer objects, the surface is only there to make the context current
+        if (!surfaceless) {
+            const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+            m_surface = eglCreatePbufferSurface(m_display, config, surfaceAttributes);
+            if (m_surface == EGL_NO_SURFACE) {
+                spdlog::error("Failed to create a pbuffer surface (error 0x{:x}).", eglGetError());
+                throw std::runtime_error("Failed to create EGL surface!");
+            }
+        }
+
+        if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+            spdlog::error("Failed to make the EGL context current (error 0x{:x}).", eglGetError());
+            throw std::runtime_error("Failed to make EGL context current!");
+        }
+        spdlog::info("Created headless {} context ({}x{}).", surfaceless ? "surfaceless" : "pbuffer", m_width, m_height);
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef VXE_HEADLESS_WINDOW_H
+#define VXE_HEADLESS_WINDOW_H
+
+#include "../../Core/Window.h"
+
+#include <EGL/egl.h>
+
+namespace vxe {
+    /// @brief Window without anything on screen, for automated runs on machines without a display.
+    ///
+    /// Creates an OpenGL 4.5 core context through EGL, surfaceless where the driver supports it (Mesa,
+    /// including llvmpipe) and with a small pbuffer otherwise. The Renderer draws into an offscreen
+    /// framebuffer of getWidth() x getHeight() instead of a back buffer. There is no input.
+    class HeadlessWindow : public Window {
+        public:
+            HeadlessWindow(const WindowConfig& config);
+            ~HeadlessWindow() override;
+
+            void init() override {}
+
+            void onUpdate() override;
+
+            uint32_t getWidth() const override { return m_width; }
+            uint32_t getHeight() const override { return m_height; }
+            bool isKeyDown(Key key) const override { return false; }
+            InputState& getInput() override { return m_input; }
+
+            // nothing is presented, so there is nothing to sync to
+            void setVSync(bool enabled) override {}
+            bool isVSync() const override { return false; }
+
+            void* getNativeWindow() const override { return nullptr; }
+
+            void swapBuffer() const override {}
+
+            void setOpenGLContext() override;
+
+            void setCursorEnabled(bool enabled) override {}
+
+            bool isHeadless() const override { return true; }
+
+        private:
+            uint32_t m_width, m_height;
+            InputState m_input;
+
+            EGLDisplay m_display = EGL_NO_DISPLAY;
+            EGLContext m_context = EGL_NO_CONTEXT;
+            EGLSurface m_surface = EGL_NO_SURFACE;
+    };
+}
+
+#endif
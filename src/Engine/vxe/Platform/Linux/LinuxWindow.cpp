@@ -50,6 +50,10 @@ namespace vxe {
         });
 
         glfwSetKeyCallback(m_window, [](GLFWwindow* window, int key, int scancode, int action, int mods) {
+            WindowData& data = *(WindowData*) glfwGetWindowUserPointer(window);
+            if (action != GLFW_REPEAT)
+                data.input.onKey(key, action == GLFW_PRESS);
+
             switch (action) {
                 case GLFW_PRESS: {
                     VXE_DISPATCH(KeyPressedEvent, key, 0);
@@ -68,6 +72,9 @@ namespace vxe {
         });
 
         glfwSetMouseButtonCallback(m_window, [](GLFWwindow* window, int button, int action, int mods) {
+            WindowData& data = *(WindowData*) glfwGetWindowUserPointer(window);
+            data.input.onMouseButton(button, action == GLFW_PRESS);
+
             switch (action) {
                 case GLFW_PRESS: {
                     VXE_DISPATCH(MouseButtonPressedEvent, button);
@@ -90,21 +97,34 @@ namespace vxe {
             VXE_DISPATCH(WindowMovedEvent, xpos, ypos);
         });
 
+        // cursor and scroll callbacks come at the polling rate of the device, they are only
+        // accumulated here and dispatched once per frame from onUpdate()
         glfwSetScrollCallback(m_window, [](GLFWwindow* window, double xOffset, double yOffset) {
-            VXE_DISPATCH(MouseScrolledEvent, (float) xOffset, (float) yOffset);
+            WindowData& data = *(WindowData*) glfwGetWindowUserPointer(window);
+            data.input.onMouseScrolled((float) xOffset, (float) yOffset);
         });
 
         glfwSetCursorPosCallback(m_window, [](GLFWwindow* window, double xPos, double yPos) {
-            VXE_DISPATCH(MouseMovedEvent, xPos, yPos);
+            WindowData& data = *(WindowData*) glfwGetWindowUserPointer(window);
+            data.input.onMouseMoved((float) xPos, (float) yPos);
         });
     }
 
     void LinuxWindow::onUpdate() {
         glfwPollEvents();
+
+        InputState& input = m_data.input;
+        input.endFrame();
+
+        const InputFrame& frame = input.getFrame();
+        if (frame.mouseMoved)
+            VXE_DISPATCH(MouseMovedEvent, frame.mousePosition.x, frame.mousePosition.y, frame.mouseDelta.x, frame.mouseDelta.y);
+        if (frame.scrolled)
+            VXE_DISPATCH(MouseScrolledEvent, frame.scroll.x, frame.scroll.y);
     }
 
     bool LinuxWindow::isKeyDown(Key key) const {
-        return glfwGetKey(m_window, static_cast<int>(key)) == GLFW_PRESS;
+        return m_data.input.isKeyDown(key);
     }
 
     void LinuxWindow::setVSync(bool enabled) {
@@ -137,6 +157,9 @@ namespace vxe {
     }
 
     void LinuxWindow::setCursorEnabled(bool enabled) {
+        // switching the mode warps the cursor
+        m_data.input.resetMouse();
+
         if (enabled)
             glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
         else
@@ -18,6 +18,7 @@ namespace vxe {
             unsigned int getWidth() const override { return m_data.width; }
             unsigned int getHeight() const override { return m_data.height; }
             bool isKeyDown(Key key) const override;
+            InputState& getInput() override { return m_data.input; }
 
             void setVSync(bool enabled) override;
             bool isVSync() const override;
@@ -30,6 +31,8 @@ namespace vxe {
 
             void setCursorEnabled(bool enabled) override;
 
+            bool isHeadless() const override { return false; }
+
         private:
             GLFWwindow* m_window;
 
@@ -37,6 +40,7 @@ namespace vxe {
                 std::string title;
                 unsigned int width, height;
                 bool vSync;
+                InputState input;
             };
 
             WindowData m_data;
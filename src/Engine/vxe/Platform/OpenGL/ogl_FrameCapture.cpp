@@ -0,0 +1,91 @@
+#include "ogl_FrameCapture.h"
+#include "ogl_Framebuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+vxe::OGLFrameCapture::OGLFrameCapture(unsigned int slots)
+    : m_slots(std::max(slots, 1u)) {
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.buffer);
+    }
+}
+
+vxe::OGLFrameCapture::~OGLFrameCapture() {
+    for (Slot& slot : m_slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.buffer);
+    }
+}
+
+bool vxe::OGLFrameCapture::capture(const Framebuffer* source, uint32_t width, uint32_t height, uint64_t index) {
+    if (m_pending == m_slots.size()) return false;
+
+    Slot& slot = m_slots[(m_oldest + m_pending) % m_slots.size()];
+    size_t size = (size_t) width * height * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (size > slot.capacity) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        slot.capacity = size;
+    }
+
+    GLuint framebuffer = source ? static_cast<const OGLFramebuffer*>(source)->getID() : 0;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glReadBuffer(source ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+
+    // with a pack buffer bound this returns right away, the copy runs after the frame's draws
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.index = index;
+    slot.width = width;
+    slot.height = height;
+    m_pending++;
+    return true;
+}
+
+bool vxe::OGLFrameCapture::read(CapturedFrame& frame, bool wait) {
+    if (m_pending == 0) return false;
+
+    Slot& slot = m_slots[m_oldest];
+    GLenum result;
+    do {
+        result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000 : 0);
+    } while (wait && result == GL_TIMEOUT_EXPIRED);
+
+    if (result == GL_WAIT_FAILED) {
+        spdlog::error("Waiting for the readback of frame {} failed.", slot.index);
+        throw std::runtime_error("Frame capture failed.");
+    }
+    if (result == GL_TIMEOUT_EXPIRED) return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    size_t size = (size_t) slot.width * slot.height * 4;
+    frame.index = slot.index;
+    frame.width = slot.width;
+    frame.height = slot.height;
+    frame.pixels.resize(size);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (mapped) {
+        std::memcpy(frame.pixels.data(), mapped, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        spdlog::warn("Failed to map the readback of frame {}.", slot.index);
+        std::fill(frame.pixels.begin(), frame.pixels.end(), 0);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_oldest = (m_oldest + 1) % m_slots.size();
+    m_pending--;
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef OPENGL_FRAME_CAPTURE_H
+#define OPENGL_FRAME_CAPTURE_H
+
+#include "../../Rendering/graphics/FrameCapture.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace vxe {
+    class OGLFrameCapture : public FrameCapture {
+        public:
+            OGLFrameCapture(unsigned int slots);
+            ~OGLFrameCapture();
+
+            OGLFrameCapture(const OGLFrameCapture&) = delete;
+            OGLFrameCapture& operator=(const OGLFrameCapture&) = delete;
+
+            bool capture(const Framebuffer* source, uint32_t width, uint32_t height, uint64_t index) override;
+            bool read(CapturedFrame& frame, bool wait) override;
+            size_t getPendingCount() const override { return m_pending; }
+
+        private:
+            // a pixel pack buffer glReadPixels copies into without stalling
+            struct Slot {
+                GLuint buffer = 0;
+                size_t capacity = 0;
+                GLsync fence = nullptr;
+                uint64_t index = 0;
+                uint32_t width = 0, height = 0;
+            };
+
+            std::vector<Slot> m_slots;
+            size_t m_oldest = 0;
+            size_t m_pending = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include "ogl_Framebuffer.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+static GLenum getInternalFormat(vxe::TextureFormat format) {
+    switch (format) {
+        case vxe::TextureFormat::RGBA16F: return GL_RGBA16F;
+        case vxe::TextureFormat::RGBA32F: return GL_RGBA32F;
+        case vxe::TextureFormat::R32F: return GL_R32F;
+        default: return GL_RGBA8;
+    }
+}
+
+vxe::OGLFramebuffer::OGLFramebuffer(uint32_t width, uint32_t height, const std::vector<TextureFormat>& colorFormats)
+    : m_formats(colorFormats), m_width(width), m_height(height) {
+    create();
+}
+
+vxe::OGLFramebuffer::~OGLFramebuffer() {
+    release();
+}
+
+void vxe::OGLFramebuffer::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_id);
+}
+
+void vxe::OGLFramebuffer::unbind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void vxe::OGLFramebuffer::bindColorAttachment(size_t index, unsigned int unit) const {
+    glBindTextureUnit(unit, m_colors.at(index));
+}
+
+void vxe::OGLFramebuffer::bindColorAttachmentImage(size_t index, unsigned int unit, ImageAccess access) const {
+    GLenum glAccess = access == ImageAccess::ReadOnly ? GL_READ_ONLY : access == ImageAccess::WriteOnly ? GL_WRITE_ONLY : GL_READ_WRITE;
+    glBindImageTexture(unit, m_colors.at(index), 0, GL_FALSE, 0, glAccess, getInternalFormat(m_formats.at(index)));
+}
+
+void vxe::OGLFramebuffer::resize(uint32_t width, uint32_t height) {
+    if (width == m_width && height == m_height) return;
+
+    m_width = width;
+    m_height = height;
+    release();
+    create();
+}
+
+void vxe::OGLFramebuffer::create() {
+    m_colors.resize(m_formats.size());
+    glGenTextures((GLsizei) m_colors.size(), m_colors.data());
+    for (size_t i = 0; i < m_colors.size(); i++) {
+        glBindTexture(GL_TEXTURE_2D, m_colors[i]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, getInternalFormat(m_formats[i]), m_width, m_height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    glGenTextures(1, &m_depth);
+    glBindTexture(GL_TEXTURE_2D, m_depth);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, m_width, m_height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &m_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_id);
+    std::vector<GLenum> drawBuffers(m_colors.size());
+    for (size_t i = 0; i < m_colors.size(); i++) {
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + (GLenum) i;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, drawBuffers[i], GL_TEXTURE_2D, m_colors[i], 0);
+    }
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+    glDrawBuffers((GLsizei) drawBuffers.size(), drawBuffers.data());
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        spdlog::error("Framebuffer of {}x{} is incomplete (status 0x{:x}).", m_width, m_height, status);
+        throw std::runtime_error("Failed to create framebuffer.");
+    }
+}
+
+void vxe::OGLFramebuffer::release() {
+    glDeleteFramebuffers(1, &m_id);
+    glDeleteTextures((GLsizei) m_colors.size(), m_colors.data());
+    glDeleteTextures(1, &m_depth);
+    m_colors.clear();
+    m_id = m_depth = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef OPENGL_FRAMEBUFFER_H
+#define OPENGL_FRAMEBUFFER_H
+
+#include "../../Rendering/graphics/Framebuffer.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace vxe {
+    class OGLFramebuffer : public Framebuffer {
+        public:
+            OGLFramebuffer(uint32_t width, uint32_t height, const std::vector<TextureFormat>& colorFormats);
+            ~OGLFramebuffer();
+
+            OGLFramebuffer(const OGLFramebuffer&) = delete;
+            OGLFramebuffer& operator=(const OGLFramebuffer&) = delete;
+
+            void bind() const override;
+            void unbind() const override;
+
+            void resize(uint32_t width, uint32_t height) override;
+
+            uint32_t getWidth() const override { return m_width; }
+            uint32_t getHeight() const override { return m_height; }
+            unsigned int getColorAttachment(size_t index = 0) const override { return m_colors.at(index); }
+            size_t getColorAttachmentCount() const override { return m_colors.size(); }
+            void bindColorAttachment(size_t index, unsigned int unit) const override;
+            void bindColorAttachmentImage(size_t index, unsigned int unit, ImageAccess access) const override;
+
+            GLuint getID() const { return m_id; }
+
+        private:
+            GLuint m_id = 0, m_depth = 0;
+            std::vector<GLuint> m_colors;
+            std::vector<TextureFormat> m_formats;
+            uint32_t m_width = 0, m_height = 0;
+
+            void create();
+            void release();
+    };
+}
+
+#endif
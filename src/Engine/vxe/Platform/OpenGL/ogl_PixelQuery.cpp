@@ -0,0 +1,83 @@
+#include "ogl_PixelQuery.h"
+#include "ogl_Framebuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+vxe::OGLPixelQuery::OGLPixelQuery(unsigned int slots)
+    : m_slots(std::max(slots, 1u)) {
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.buffer);
+    }
+}
+
+vxe::OGLPixelQuery::~OGLPixelQuery() {
+    for (Slot& slot : m_slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.buffer);
+    }
+}
+
+bool vxe::OGLPixelQuery::request(const Framebuffer* source, uint32_t x, uint32_t y) {
+    if (m_pending == m_slots.size()) return false;
+
+    Slot& slot = m_slots[(m_oldest + m_pending) % m_slots.size()];
+    size_t count = source->getColorAttachmentCount();
+    size_t size = count * sizeof(glm::vec4);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (size > slot.capacity) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        slot.capacity = size;
+    }
+
+    // with a pack buffer bound these return right away, the copies run after the frame's draws
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<const OGLFramebuffer*>(source)->getID());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    for (size_t i = 0; i < count; i++) {
+        glReadBuffer(GL_COLOR_ATTACHMENT0 + (GLenum) i);
+        glReadPixels(x, y, 1, 1, GL_RGBA, GL_FLOAT, reinterpret_cast<void*>(i * sizeof(glm::vec4)));
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.count = count;
+    m_pending++;
+    return true;
+}
+
+bool vxe::OGLPixelQuery::read(std::vector<glm::vec4>& values) {
+    if (m_pending == 0) return false;
+
+    Slot& slot = m_slots[m_oldest];
+    GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_WAIT_FAILED) {
+        spdlog::error("Waiting for a pixel readback failed.");
+        throw std::runtime_error("Pixel query failed.");
+    }
+    if (result == GL_TIMEOUT_EXPIRED) return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    size_t size = slot.count * sizeof(glm::vec4);
+    values.assign(slot.count, glm::vec4(0.0f));
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (mapped) {
+        std::memcpy(values.data(), mapped, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        spdlog::warn("Failed to map a pixel readback.");
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_oldest = (m_oldest + 1) % m_slots.size();
+    m_pending--;
+    return true;
+}
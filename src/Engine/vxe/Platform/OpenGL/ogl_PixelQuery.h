@@ -0,0 +1,38 @@
+#ifndef OPENGL_PIXEL_QUERY_H
+#define OPENGL_PIXEL_QUERY_H
+
+#include "../../Rendering/graphics/PixelQuery.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace vxe {
+    class OGLPixelQuery : public PixelQuery {
+        public:
+            OGLPixelQuery(unsigned int slots);
+            ~OGLPixelQuery();
+
+            OGLPixelQuery(const OGLPixelQuery&) = delete;
+            OGLPixelQuery& operator=(const OGLPixelQuery&) = delete;
+
+            bool request(const Framebuffer* source, uint32_t x, uint32_t y) override;
+            bool read(std::vector<glm::vec4>& values) override;
+            size_t getPendingCount() const override { return m_pending; }
+
+        private:
+            // a pixel pack buffer with one RGBA32F value per attachment
+            struct Slot {
+                GLuint buffer = 0;
+                size_t capacity = 0;
+                GLsync fence = nullptr;
+                size_t count = 0;
+            };
+
+            std::vector<Slot> m_slots;
+            size_t m_oldest = 0;
+            size_t m_pending = 0;
+    };
+}
+
+#endif
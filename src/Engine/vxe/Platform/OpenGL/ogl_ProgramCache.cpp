@@ -0,0 +1,135 @@
+#include "ogl_ProgramCache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace vxe {
+    static constexpr uint32_t CACHE_MAGIC = 0x50455856; // "VXEP"
+    static constexpr uint32_t CACHE_VERSION = 1;
+    static constexpr uint32_t MAX_BINARY_SIZE = 64 << 20;
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t size;
+    };
+
+    static std::filesystem::path s_directory = "shader_cache";
+
+    static std::string getDriverString() {
+        auto get = [](GLenum name) {
+            const GLubyte* value = glGetString(name);
+            return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+        };
+        return get(GL_VENDOR) + '\n' + get(GL_RENDERER) + '\n' + get(GL_VERSION);
+    }
+
+    static std::filesystem::path getPath(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) key);
+        return s_directory / name;
+    }
+
+    void OGLProgramCache::setDirectory(const std::filesystem::path& directory) {
+        s_directory = directory;
+    }
+
+    const std::filesystem::path& OGLProgramCache::getDirectory() {
+        return s_directory;
+    }
+
+    bool OGLProgramCache::isEnabled() {
+        if (s_directory.empty()) return false;
+
+        // some drivers support the extension without any binary format
+        static const bool supported = [] {
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            if (formats == 0) spdlog::warn("The driver supports no program binary formats, shaders will always be compiled.");
+            return formats > 0;
+        }();
+        return supported;
+    }
+
+    uint64_t OGLProgramCache::beginKey() {
+        static const uint64_t driverKey = addToKey(0xcbf29ce484222325ull, getDriverString());
+        return driverKey;
+    }
+
+    uint64_t OGLProgramCache::addToKey(uint64_t key, std::string_view data) {
+        // FNV-1a, with the length mixed in so that moving text between parts changes the key
+        for (unsigned char c : data) {
+            key ^= c;
+            key *= 0x100000001b3ull;
+        }
+        key ^= data.size();
+        key *= 0x100000001b3ull;
+        return key;
+    }
+
+    bool OGLProgramCache::load(GLuint program, uint64_t key) {
+        std::ifstream in(getPath(key), std::ios::binary);
+        if (!in) return false;
+
+        CacheHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != CACHE_MAGIC
+            || header.version != CACHE_VERSION || header.key != key || header.size > MAX_BINARY_SIZE) {
+            spdlog::warn("Ignoring invalid program binary '{}'.", getPath(key).string());
+            return false;
+        }
+
+        std::vector<char> binary(header.size);
+        if (!in.read(binary.data(), binary.size())) {
+            spdlog::warn("Program binary '{}' is truncated.", getPath(key).string());
+            return false;
+        }
+
+        glProgramBinary(program, header.format, binary.data(), (GLsizei) binary.size());
+
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            spdlog::info("Driver rejected program binary '{}', compiling from source.", getPath(key).string());
+            return false;
+        }
+        return true;
+    }
+
+    void OGLProgramCache::store(GLuint program, uint64_t key) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(s_directory, error);
+
+        // written to a temporary file first, so a crash never leaves a truncated binary under the key
+        std::filesystem::path path = getPath(key);
+        std::filesystem::path temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            CacheHeader header{CACHE_MAGIC, CACHE_VERSION, key, format, (uint32_t) length};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(binary.data(), length);
+            if (!out) {
+                spdlog::warn("Failed to write program binary '{}'.", temporary.string());
+                return;
+            }
+        }
+
+        std::filesystem::rename(temporary, path, error);
+        if (error)
+            spdlog::warn("Failed to store program binary '{}': {}", path.string(), error.message());
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef OPENGL_PROGRAM_CACHE_H
+#define OPENGL_PROGRAM_CACHE_H
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace vxe {
+    /// @brief On-disk cache of linked program binaries.
+    ///
+    /// A binary is stored under a key hashed from everything that went into the program and the driver
+    /// strings, so a different driver or GPU misses instead of loading a binary it cannot use. A driver
+    /// may still reject a binary of the same version, load() reports that as a miss as well.
+    class OGLProgramCache {
+        public:
+            /// @brief Where binaries are stored, an empty path disables the cache. Defaults to "shader_cache".
+            static void setDirectory(const std::filesystem::path& directory);
+            static const std::filesystem::path& getDirectory();
+            static bool isEnabled();
+
+            /// @brief Starts a key, extend it with addToKey() for every source and define.
+            static uint64_t beginKey();
+            static uint64_t addToKey(uint64_t key, std::string_view data);
+
+            /// @brief Loads the binary stored under key into program.
+            /// @return true if the program was linked from the binary
+            static bool load(GLuint program, uint64_t key);
+            /// @brief Stores the binary of a linked program, the program must have been linked with
+            /// GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+            static void store(GLuint program, uint64_t key);
+    };
+}
+
+#endif
@@ -1,12 +1,21 @@
 #include "ogl_RenderAPI.h"
+#include "ogl_Shader.h"
+#include "ogl_ShaderStorageBuffer.h"
 
 #include <GL/glew.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
 void vxe::OGLRenderAPI::init(Window* window) {
     window->setOpenGLContext();
 
-    if(glewInit() != GLEW_OK){
+    GLenum result = glewInit();
+    // GLEW loads the GL entry points before the GLX ones, under EGL without an X display only the latter fail
+    if (result == GLEW_ERROR_NO_GLX_DISPLAY && window->isHeadless())
+        result = GLEW_OK;
+
+    if(result != GLEW_OK){
         // spdlog::critical("Failed to initialize GLEW!");
         throw std::runtime_error("Failed to initialize GLEW!");
     }
@@ -33,10 +42,99 @@ void vxe::OGLRenderAPI::drawElements(const vxe::VertexArray* va, unsigned int co
     glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, NULL);
 }
 
+void vxe::OGLRenderAPI::dispatchCompute(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) {
+    glDispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+void vxe::OGLRenderAPI::memoryBarrier(uint32_t barriers) {
+    GLbitfield bits = 0;
+    if (barriers & BARRIER_SHADER_STORAGE) bits |= GL_SHADER_STORAGE_BARRIER_BIT;
+    if (barriers & BARRIER_SHADER_IMAGE) bits |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+    if (barriers & BARRIER_TEXTURE_FETCH) bits |= GL_TEXTURE_FETCH_BARRIER_BIT;
+    if (barriers & BARRIER_BUFFER_UPDATE) bits |= GL_BUFFER_UPDATE_BARRIER_BIT;
+    if (barriers & BARRIER_FRAMEBUFFER) bits |= GL_FRAMEBUFFER_BARRIER_BIT;
+    if (bits) glMemoryBarrier(bits);
+}
+
+GLuint vxe::OGLRenderAPI::s_boundProgram = 0;
+std::vector<GLuint> vxe::OGLRenderAPI::s_boundStorageBuffers;
+
+bool vxe::OGLRenderAPI::bindProgram(const Shader* program) {
+    return useProgram(static_cast<const OGLShader*>(program)->getID());
+}
+
+bool vxe::OGLRenderAPI::bindStorageBuffer(const ShaderStorageBuffer* buffer) {
+    auto oglBuffer = static_cast<const OGLShaderStorageBuffer*>(buffer);
+    return bindStorageBufferBase(oglBuffer->getIndex(), oglBuffer->getID());
+}
+
+void vxe::OGLRenderAPI::resetStateCache() {
+    s_boundProgram = 0;
+    std::fill(s_boundStorageBuffers.begin(), s_boundStorageBuffers.end(), 0);
+}
+
+bool vxe::OGLRenderAPI::useProgram(GLuint program) {
+    // 0 is not cached, unbinding always goes through and leaves nothing known to be bound
+    if (program != 0 && program == s_boundProgram) return false;
+
+    glUseProgram(program);
+    s_boundProgram = program;
+    return true;
+}
+
+bool vxe::OGLRenderAPI::bindStorageBufferBase(GLuint index, GLuint buffer) {
+    if (index >= s_boundStorageBuffers.size())
+        s_boundStorageBuffers.resize(index + 1, 0);
+    if (s_boundStorageBuffers[index] == buffer) return false;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, buffer);
+    s_boundStorageBuffers[index] = buffer;
+    return true;
+}
+
+void vxe::OGLRenderAPI::forgetProgram(GLuint program) {
+    if (s_boundProgram == program)
+        s_boundProgram = 0;
+}
+
+void vxe::OGLRenderAPI::forgetStorageBuffer(GLuint buffer) {
+    // deleting a buffer unbinds it everywhere
+    std::replace(s_boundStorageBuffers.begin(), s_boundStorageBuffers.end(), buffer, (GLuint) 0);
+}
+
 void vxe::OGLRenderAPI::setClearColor(const glm::vec4& color) {
     glClearColor(color.r, color.g, color.b, color.a);
 }
 
 void vxe::OGLRenderAPI::swapBuffer(Window* window) {
     window->swapBuffer();
+}
+
+unsigned int vxe::OGLRenderAPI::createTimerQuery() {
+    unsigned int query;
+    glGenQueries(1, &query);
+    return query;
+}
+
+void vxe::OGLRenderAPI::deleteTimerQuery(unsigned int query) {
+    glDeleteQueries(1, &query);
+}
+
+void vxe::OGLRenderAPI::beginTimerQuery(unsigned int query) {
+    glBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+void vxe::OGLRenderAPI::endTimerQuery() {
+    glEndQuery(GL_TIME_ELAPSED);
+}
+
+bool vxe::OGLRenderAPI::getTimerQueryResult(unsigned int query, uint64_t& nanoseconds) {
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+
+    GLuint64 elapsed;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+    nanoseconds = elapsed;
+    return true;
 }
\ No newline at end of file
@@ -3,8 +3,11 @@
 
 #include "../../Rendering/graphics/RenderAPI.h"
 
+#include <GL/glew.h>
 #include <glm/vec4.hpp>
 
+#include <vector>
+
 namespace vxe {
     class OGLRenderAPI : public RenderAPI {
         public:
@@ -13,10 +16,37 @@ namespace vxe {
             void clear() override;
             void drawVertexArray(const VertexArray* va, unsigned int count) override;
             void drawElements(const vxe::VertexArray* va, unsigned int count) override;
+            void dispatchCompute(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ = 1) override;
+            void memoryBarrier(uint32_t barriers) override;
+
+            bool bindProgram(const Shader* program) override;
+            bool bindStorageBuffer(const ShaderStorageBuffer* buffer) override;
+            void resetStateCache() override;
+
+            // The state cache behind bindProgram() and bindStorageBuffer(), shared by every OGL class that binds
+            // programs or storage buffers. There is a single context, so a single cache.
+            /// @return false if program was in use already and nothing was done
+            static bool useProgram(GLuint program);
+            /// @return false if buffer was bound to index already and nothing was done
+            static bool bindStorageBufferBase(GLuint index, GLuint buffer);
+            /// @brief Forgets a program or buffer that is deleted, GL hands out its name again.
+            static void forgetProgram(GLuint program);
+            static void forgetStorageBuffer(GLuint buffer);
 
             void setClearColor(const glm::vec4& color) override;
 
             void swapBuffer(Window* window) override;
+
+            unsigned int createTimerQuery() override;
+            void deleteTimerQuery(unsigned int query) override;
+            void beginTimerQuery(unsigned int query) override;
+            void endTimerQuery() override;
+            bool getTimerQueryResult(unsigned int query, uint64_t& nanoseconds) override;
+
+        private:
+            // 0 where it is not known what is bound, no program or buffer has that name
+            static GLuint s_boundProgram;
+            static std::vector<GLuint> s_boundStorageBuffers; // by binding index
     };
 }
 
@@ -1,104 +1,217 @@
 #include "ogl_Shader.h"
 
 #include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <spdlog/spdlog.h>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "ogl_ProgramCache.h"
+#include "ogl_RenderAPI.h"
+#include "../../Rendering/graphics/ShaderPreprocessor.h"
+#include "../../Core/Profiler.h"
+
 namespace vxe {
         OGLShader::OGLShader() {
             m_program = glCreateProgram();
         }
 
         OGLShader::~OGLShader() {
+            OGLRenderAPI::forgetProgram(m_program);
             glDeleteProgram(m_program);
         }
 
         void OGLShader::bind() const {
-            glUseProgram(m_program);
+            OGLRenderAPI::useProgram(m_program);
         }
         void OGLShader::unbind() const {
-            glUseProgram(0);
+            OGLRenderAPI::useProgram(0);
         }
 
         void OGLShader::vertex(const std::string& str, const bool isSrc) {
+            // compiled in compile(), unless the program binary is cached
+            m_vertStage = loadStage(str, isSrc, "vertex");
+        }
+
+        void OGLShader::fragment(const std::string& str, const bool isSrc) {
+            m_fragStage = loadStage(str, isSrc, "fragment");
+        }
+
+        void OGLShader::compute(const std::string& str, const bool isSrc) {
+            m_compStage = loadStage(str, isSrc, "compute");
+        }
+
+        PreprocessedShader OGLShader::loadStage(const std::string& str, bool isSrc, const char* stage) {
             std::string src;
             if (isSrc) {
                 src = str;
             } else {
-                std::ifstream vertexFile(str);
-                if (!vertexFile.is_open()) {
-                    spdlog::error("Failed to open vertex shader file: {0}", str);
-                    throw std::runtime_error("Failed to open vertex shader file.");
+                std::ifstream file(str);
+                if (!file.is_open()) {
+                    spdlog::error("Failed to open {0} shader file: {1}", stage, str);
+                    throw std::runtime_error("Failed to open " + std::string(stage) + " shader file.");
                 }
-                src = std::string((std::istreambuf_iterator<char>(vertexFile)), std::istreambuf_iterator<char>());
+                src = std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                addToName(str);
             }
-            m_vert = glCreateShader(GL_VERTEX_SHADER);
-            const char* vertCode = src.c_str();
-            glShaderSource(m_vert, 1, &vertCode, NULL);
+            return resolveShaderIncludes(src, isSrc ? std::filesystem::current_path() / "<source>" : std::filesystem::path(str));
         }
 
-        void OGLShader::fragment(const std::string& str, const bool isSrc) {
-            std::string src;
-            if (isSrc) {
-                src = str;
-            } else {
-                std::ifstream fragmentFile(str);
-                if (!fragmentFile.is_open()) {
-                    spdlog::error("Failed to open fragment shader file: {0}", str);
-                    throw std::runtime_error("Failed to open fragment shader file.");
+        void OGLShader::define(std::string_view name, std::string_view value) {
+            for (auto& define : m_defines) {
+                if (define.first == name) {
+                    define.second = value;
+                    return;
                 }
-                src = std::string((std::istreambuf_iterator<char>(fragmentFile)), std::istreambuf_iterator<char>());
             }
-            m_frag = glCreateShader(GL_FRAGMENT_SHADER);
-            const char* fragCode = src.c_str();
-            glShaderSource(m_frag, 1, &fragCode, NULL);
+            m_defines.emplace_back(name, value);
         }
 
         void OGLShader::compile() {
-            glCompileShader(m_vert);
-            checkCompileErrors(m_vert, "VERTEX");
-            glCompileShader(m_frag);
-            checkCompileErrors(m_frag, "FRAGMENT");
+            VXE_PROFILE_FUNCTION();
+            auto start = std::chrono::steady_clock::now();
+
+            struct Stage {
+                GLenum type;
+                const char* name;
+                const PreprocessedShader* preprocessed;
+                std::string source;
+            };
+            std::vector<Stage> stages;
+            if (!m_compStage.source.empty()) {
+                stages.push_back({ GL_COMPUTE_SHADER, "COMPUTE", &m_compStage });
+            } else {
+                stages.push_back({ GL_VERTEX_SHADER, "VERTEX", &m_vertStage });
+                stages.push_back({ GL_FRAGMENT_SHADER, "FRAGMENT", &m_fragStage });
+            }
+
+            // the defines are part of the source, so they are part of the cache key as well
+            bool useCache = OGLProgramCache::isEnabled();
+            uint64_t key = useCache ? OGLProgramCache::beginKey() : 0;
+            for (auto& stage : stages) {
+                stage.source = injectShaderDefines(stage.preprocessed->source, m_defines);
+                if (useCache)
+                    key = OGLProgramCache::addToKey(key, stage.source);
+            }
+
+            m_fromBinaryCache = useCache && OGLProgramCache::load(m_program, key);
+            if (!m_fromBinaryCache) {
+                std::vector<GLuint> shaders;
+                for (const auto& stage : stages) {
+                    GLuint shader = compileShader(stage.type, stage.source);
+                    checkCompileErrors(shader, stage.name, stage.preprocessed);
+                    glAttachShader(m_program, shader);
+                    shaders.push_back(shader);
+                }
+
+                if (useCache)
+                    glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+                glLinkProgram(m_program);
+                checkCompileErrors(m_program, "PROGRAM");
 
-            glAttachShader(m_program, m_vert);
-            glAttachShader(m_program, m_frag);
-            glLinkProgram(m_program);
-            checkCompileErrors(m_program, "PROGRAM");
+                for (GLuint shader : shaders) {
+                    glDetachShader(m_program, shader);
+                    glDeleteShader(shader);
+                }
+
+                if (useCache)
+                    OGLProgramCache::store(m_program, key);
+            }
 
-            glDeleteShader(m_vert);
-            glDeleteShader(m_frag);
+            cacheUniformLocations();
+
+            // the sources are only needed to build the key and to compile
+            m_vertStage = PreprocessedShader();
+            m_fragStage = PreprocessedShader();
+            m_compStage = PreprocessedShader();
+
+            m_compileTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            spdlog::info("{} program '{}' in {:.1f} ms.", m_fromBinaryCache ? "Loaded cached" : "Compiled",
+                m_name.empty() ? "<source>" : m_name, m_compileTimeMs);
         }
 
-        void OGLShader::setUniform(const std::string& name, const int value) {
-            glUniform1i(glGetUniformLocation(m_program, name.c_str()), value);
+        unsigned int OGLShader::compileShader(unsigned int type, const std::string& source) {
+            GLuint shader = glCreateShader(type);
+            const char* code = source.c_str();
+            glShaderSource(shader, 1, &code, NULL);
+            glCompileShader(shader);
+            return shader;
+        }
+
+        void OGLShader::addToName(const std::string& path) {
+            if (!m_name.empty()) m_name += '+';
+            m_name += std::filesystem::path(path).filename().string();
+        }
+
+        void OGLShader::cacheUniformLocations() {
+            m_uniformLocations.clear();
+
+            GLint count = 0, maxLength = 0;
+            glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+            glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+            std::vector<GLchar> buffer(std::max(maxLength, 1));
+            for (GLint i = 0; i < count; i++) {
+                GLsizei length = 0;
+                GLint size;
+                GLenum type;
+                glGetActiveUniform(m_program, i, (GLsizei) buffer.size(), &length, &size, &type, buffer.data());
+
+                std::string name(buffer.data(), length);
+                GLint location = glGetUniformLocation(m_program, name.c_str());
+                if (location < 0) continue; // member of a uniform block
+
+                // arrays are reported as "name[0]", the elements follow at consecutive locations
+                if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+                    m_uniformLocations.emplace_back(name.substr(0, name.size() - 3), location);
+                }
+                m_uniformLocations.emplace_back(std::move(name), location);
+            }
+
+            std::sort(m_uniformLocations.begin(), m_uniformLocations.end());
+        }
+
+        int OGLShader::getUniformLocation(std::string_view name) const {
+            auto it = std::lower_bound(m_uniformLocations.begin(), m_uniformLocations.end(), name,
+                [](const std::pair<std::string, GLint>& entry, std::string_view key) { return entry.first < key; });
+            if (it == m_uniformLocations.end() || it->first != name) return -1;
+            return it->second;
+        }
+
+        void OGLShader::setUniform(std::string_view name, const int value) {
+            glUniform1i(getUniformLocation(name), value);
+        }
+        void OGLShader::setUniform(std::string_view name, const unsigned int value) {
+            glUniform1ui(getUniformLocation(name), value);
         }
-        void OGLShader::setUniform(const std::string& name, const unsigned int value) {
-            glUniform1ui(glGetUniformLocation(m_program, name.c_str()), value);
+        void OGLShader::setUniform(std::string_view name, const float value) {
+            glUniform1f(getUniformLocation(name), value);
         }
-        void OGLShader::setUniform(const std::string& name, const float value) {
-            glUniform1f(glGetUniformLocation(m_program, name.c_str()), value);
+        void OGLShader::setUniform(std::string_view name, const glm::vec2 value) {
+            glUniform2f(getUniformLocation(name), value.x, value.y);
         }
-        void OGLShader::setUniform(const std::string& name, const glm::vec2 value) {
-            glUniform2f(glGetUniformLocation(m_program, name.c_str()), value.x, value.y);
+        void OGLShader::setUniform(std::string_view name, const glm::vec3 value) {
+            glUniform3f(getUniformLocation(name), value.x, value.y, value.z);
         }
-        void OGLShader::setUniform(const std::string& name, const glm::vec3 value) {
-            glUniform3f(glGetUniformLocation(m_program, name.c_str()), value.x, value.y, value.z);
+        void OGLShader::setUniform(std::string_view name, const glm::vec4 value) {
+            glUniform4f(getUniformLocation(name), value.x, value.y, value.z, value.w);
         }
-        void OGLShader::setUniform(const std::string& name, const glm::vec4 value) {
-            glUniform4f(glGetUniformLocation(m_program, name.c_str()), value.x, value.y, value.z, value.w);
+        void OGLShader::setUniform(std::string_view name, const glm::ivec2 value) {
+            glUniform2i(getUniformLocation(name), value.x, value.y);
         }
-        void OGLShader::setUniform(const std::string& name, const glm::ivec2 value) {
-            glUniform2i(glGetUniformLocation(m_program, name.c_str()), value.x, value.y);
+        void OGLShader::setUniform(std::string_view name, const glm::ivec3 value) {
+            glUniform3i(getUniformLocation(name), value.x, value.y, value.z);
         }
-        void OGLShader::setUniform(const std::string& name, const glm::ivec3 value) {
-            glUniform3i(glGetUniformLocation(m_program, name.c_str()), value.x, value.y, value.z);
+        void OGLShader::setUniform(std::string_view name, const glm::mat4 value) {
+            glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
         }
-        void OGLShader::setUniform(const std::string& name, const glm::mat4 value) {
-            glUniformMatrix4fv(glGetUniformLocation(m_program, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+        void OGLShader::setUniform(std::string_view name, const glm::ivec3* values, size_t count) {
+            glUniform3iv(getUniformLocation(name), (GLsizei) count, glm::value_ptr(values[0]));
         }
 
-        void OGLShader::checkCompileErrors(GLuint shader, std::string type) {
+        void OGLShader::checkCompileErrors(GLuint shader, std::string type, const PreprocessedShader* stage) {
             GLint success;
             GLchar infoLog[1024];
             if (type != "PROGRAM") {
@@ -106,6 +219,9 @@ namespace vxe {
                 if (!success) {
                     glGetShaderInfoLog(shader, 1024, NULL, infoLog);
                     spdlog::error("Failed to compile {0} shader:\n\t{1}", type, infoLog);
+                    // messages are prefixed with the source string number, which is the index of the file
+                    for (size_t i = 0; stage && i < stage->files.size(); i++)
+                        spdlog::error("\tsource {0}: {1}", i, stage->files[i].string());
                     throw std::runtime_error("Shader compilation failed: " + std::string(infoLog));
                 }
             } else {
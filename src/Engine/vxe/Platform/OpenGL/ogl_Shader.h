@@ -2,9 +2,13 @@
 #define OPENGL_SHADER_H
 
 #include "../../Rendering/graphics/Shader.h"
+#include "../../Rendering/graphics/ShaderPreprocessor.h"
 
 #include <GL/glew.h>
 
+#include <utility>
+#include <vector>
+
 namespace vxe {
     class OGLShader : public Shader {
         public:
@@ -16,24 +20,47 @@ namespace vxe {
 
             void vertex(const std::string& str, const bool isSrc = false) override;
             void fragment(const std::string& str, const bool isSrc = false) override;
+            void compute(const std::string& str, const bool isSrc = false) override;
 
+            void define(std::string_view name, std::string_view value = "1") override;
             void compile() override;
 
-            void setUniform(const std::string& name, const int value) override;
-            void setUniform(const std::string& name, const unsigned int value) override;
-            void setUniform(const std::string& name, const float value) override;
-            void setUniform(const std::string& name, const glm::vec2 value) override;
-            void setUniform(const std::string& name, const glm::vec3 value) override;
-            void setUniform(const std::string& name, const glm::vec4 value) override;
-            void setUniform(const std::string& name, const glm::ivec2 value) override;
-            void setUniform(const std::string& name, const glm::ivec3 value) override;
-            void setUniform(const std::string& name, const glm::mat4 value) override;
+            void setUniform(std::string_view name, const int value) override;
+            void setUniform(std::string_view name, const unsigned int value) override;
+            void setUniform(std::string_view name, const float value) override;
+            void setUniform(std::string_view name, const glm::vec2 value) override;
+            void setUniform(std::string_view name, const glm::vec3 value) override;
+            void setUniform(std::string_view name, const glm::vec4 value) override;
+            void setUniform(std::string_view name, const glm::ivec2 value) override;
+            void setUniform(std::string_view name, const glm::ivec3 value) override;
+            void setUniform(std::string_view name, const glm::mat4 value) override;
+            void setUniform(std::string_view name, const glm::ivec3* values, size_t count) override;
+
+            int getUniformLocation(std::string_view name) const override;
+
+            double getCompileTimeMs() const override { return m_compileTimeMs; }
+            bool isFromBinaryCache() const override { return m_fromBinaryCache; }
+
+            GLuint getID() const { return m_program; }
 
         private:
-            GLuint m_program, m_vert, m_frag;
+            GLuint m_program;
+            PreprocessedShader m_vertStage, m_fragStage, m_compStage;
+            std::vector<std::pair<std::string, std::string>> m_defines;
+            std::string m_name; // file names of the stages, for logging
+
+            double m_compileTimeMs = 0.0;
+            bool m_fromBinaryCache = false;
+
+            // active uniforms sorted by name, arrays are listed under their name without "[0]"
+            std::vector<std::pair<std::string, GLint>> m_uniformLocations;
+
+            void cacheUniformLocations();
+            void addToName(const std::string& path);
+            PreprocessedShader loadStage(const std::string& str, bool isSrc, const char* stage);
 
             unsigned int compileShader(unsigned int type, const std::string& source);
-            void checkCompileErrors(GLuint shader, std::string type);
+            void checkCompileErrors(GLuint shader, std::string type, const PreprocessedShader* stage = nullptr);
     };
 }
 
@@ -1,4 +1,5 @@
 #include "ogl_ShaderStorageBuffer.h"
+#include "ogl_RenderAPI.h"
 
 vxe::OGLShaderStorageBuffer::OGLShaderStorageBuffer(unsigned int index) {
     glGenBuffers(1, &m_id);
@@ -6,6 +7,7 @@ vxe::OGLShaderStorageBuffer::OGLShaderStorageBuffer(unsigned int index) {
 }
 
 vxe::OGLShaderStorageBuffer::~OGLShaderStorageBuffer() {
+    OGLRenderAPI::forgetStorageBuffer(m_id);
     glDeleteBuffers(1, &m_id);
 }
 
@@ -14,7 +16,7 @@ void vxe::OGLShaderStorageBuffer::bind() const {
 }
 
 void vxe::OGLShaderStorageBuffer::bindBase() const {
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_index, m_id);
+    OGLRenderAPI::bindStorageBufferBase(m_index, m_id);
 }
 
 void vxe::OGLShaderStorageBuffer::unbind() const {
@@ -24,6 +26,24 @@ void vxe::OGLShaderStorageBuffer::unbind() const {
 void vxe::OGLShaderStorageBuffer::setData(void *data, unsigned int size) {
     bind();
     glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_STATIC_DRAW);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_index, m_id);
+    m_size = size;
     bindBase();
+}
+
+void vxe::OGLShaderStorageBuffer::updateData(const void *data, size_t offset, size_t size) {
+    if (size == 0) return;
+
+    glNamedBufferSubData(m_id, offset, size, data);
+}
+
+void vxe::OGLShaderStorageBuffer::clear() {
+    if (m_size == 0) return;
+
+    // without data the clear value is zero
+    glClearNamedBufferData(m_id, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+}
+
+void vxe::OGLShaderStorageBuffer::getData(void *data, unsigned int size) const {
+    bind();
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
 }
\ No newline at end of file
@@ -18,8 +18,16 @@ namespace vxe {
             void bindBase() const override;
             void unbind() const override;
             void setData(void* data, unsigned int size) override;
+            void updateData(const void* data, size_t offset, size_t size) override;
+            void clear() override;
+            void getData(void* data, unsigned int size) const override;
+            size_t getSize() const override { return m_size; }
+
+            GLuint getID() const { return m_id; }
+            GLuint getIndex() const { return m_index; }
         private:
             GLuint m_id, m_index;
+            size_t m_size = 0;
     };
 }
 
@@ -0,0 +1,66 @@
+#include "ogl_UniformBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+vxe::OGLUniformBuffer::OGLUniformBuffer(unsigned int index, size_t size, unsigned int frames)
+    : m_index(index), m_size(size), m_frames(std::max(frames, 1u)), m_fences(m_frames, nullptr) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_stride = (size + alignment - 1) / alignment * alignment;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &m_id);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+    glBufferStorage(GL_UNIFORM_BUFFER, m_stride * m_frames, nullptr, flags);
+    m_mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, m_stride * m_frames, flags));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    if (!m_mapped) {
+        spdlog::error("Failed to map uniform buffer of {} bytes.", m_stride * m_frames);
+        throw std::runtime_error("Failed to map uniform buffer.");
+    }
+}
+
+vxe::OGLUniformBuffer::~OGLUniformBuffer() {
+    for (GLsync fence : m_fences) {
+        if (fence) glDeleteSync(fence);
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glDeleteBuffers(1, &m_id);
+}
+
+void vxe::OGLUniformBuffer::setData(const void* data, size_t size) {
+    if (size > m_size)
+        throw std::runtime_error("Uniform buffer data is larger than the buffer.");
+
+    // everything reading the current region has been submitted by now
+    if (m_written) {
+        m_fences[m_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_current = (m_current + 1) % m_frames;
+    }
+    m_written = true;
+
+    GLsync& fence = m_fences[m_current];
+    if (fence) {
+        // only waits if the GPU is more than m_frames frames behind
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+            spdlog::warn("Waiting for uniform buffer region {} failed.", m_current);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    std::memcpy(m_mapped + m_current * m_stride, data, size);
+    bindBase();
+}
+
+void vxe::OGLUniformBuffer::bindBase() const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, m_index, m_id, m_current * m_stride, m_size);
+}
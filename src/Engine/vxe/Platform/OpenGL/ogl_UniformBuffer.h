@@ -0,0 +1,37 @@
+#ifndef OPENGL_UNIFORM_BUFFER_H
+#define OPENGL_UNIFORM_BUFFER_H
+
+#include "../../Rendering/graphics/UniformBuffer.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace vxe {
+    class OGLUniformBuffer : public UniformBuffer {
+        public:
+            OGLUniformBuffer(unsigned int index, size_t size, unsigned int frames);
+            ~OGLUniformBuffer();
+
+            OGLUniformBuffer(const OGLUniformBuffer&) = delete;
+            OGLUniformBuffer& operator=(const OGLUniformBuffer&) = delete;
+
+            void setData(const void* data, size_t size) override;
+            void bindBase() const override;
+            size_t getSize() const override { return m_size; }
+
+        private:
+            GLuint m_id, m_index;
+            size_t m_size, m_stride;
+            unsigned int m_frames;
+            unsigned int m_current = 0;
+            bool m_written = false;
+
+            // persistently mapped storage of all regions
+            unsigned char* m_mapped = nullptr;
+            // signaled once the GPU is done with the draws that used the region
+            std::vector<GLsync> m_fences;
+    };
+}
+
+#endif
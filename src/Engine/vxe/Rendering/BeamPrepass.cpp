@@ -0,0 +1,29 @@
+#include "BeamPrepass.h"
+
+#include "../Core/Profiler.h"
+
+namespace vxe {
+    void BeamPrepass::execute(RenderAPI* api, Renderable* scene, glm::uvec2 size) {
+        VXE_PROFILE_GPU_SCOPE("beam");
+
+        // partial tiles at the right and top edge get a texel too
+        glm::uvec2 tiles = (glm::max(size, glm::uvec2(1)) + TILE_SIZE - 1u) / TILE_SIZE;
+        if (!m_target)
+            m_target = Framebuffer::create(tiles.x, tiles.y, { TextureFormat::R32F });
+        else if (tiles != m_tiles)
+            m_target->resize(tiles.x, tiles.y);
+        m_tiles = tiles;
+
+        // every texel is written, clearing only resets the depth the triangle is tested against
+        m_target->bind();
+        api->setViewport(0, 0, tiles.x, tiles.y);
+        api->clear();
+        scene->draw(api);
+        m_target->unbind();
+    }
+
+    void BeamPrepass::bindStartDistances(unsigned int unit) const {
+        if (m_target)
+            m_target->bindColorAttachment(0, unit);
+    }
+}
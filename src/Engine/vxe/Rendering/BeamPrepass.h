@@ -0,0 +1,38 @@
+#ifndef VXE_BEAM_PREPASS_H
+#define VXE_BEAM_PREPASS_H
+
+#include <cstdint>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Renderable.h"
+#include "graphics/Framebuffer.h"
+
+namespace vxe {
+    /// @brief Low resolution pass that finds how far the rays of each screen tile can skip empty space.
+    ///
+    /// A program like assets/shader/beam.frag traces one cone per TILE_SIZE x TILE_SIZE pixels and writes
+    /// the distance up to which the cone is empty. That distance is safe for every ray of the tile, so
+    /// the full resolution pass starts its traversal there instead of walking the same empty bricks
+    /// in each of the tile's pixels.
+    class BeamPrepass {
+        public:
+            static constexpr uint32_t TILE_SIZE = 8;
+
+            /// @brief Draws scene into one pixel per tile of a frame of the given size, with the program
+            /// that is bound. Leaves the default framebuffer bound.
+            void execute(RenderAPI* api, Renderable* scene, glm::uvec2 size);
+            /// @brief Binds the start distances of the last execute() to a texture unit.
+            void bindStartDistances(unsigned int unit) const;
+
+            /// @brief Tiles of the last execute().
+            glm::uvec2 getTileCount() const { return m_tiles; }
+
+        private:
+            std::unique_ptr<Framebuffer> m_target;
+            glm::uvec2 m_tiles{0};
+    };
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include "FaceLightCache.h"
+
+#include "../Core/Profiler.h"
+
+#include <algorithm>
+
+namespace vxe {
+    FaceLightCache::FaceLightCache(uint32_t capacity)
+        : m_capacity(capacity) {}
+
+    void FaceLightCache::setScene(const glm::ivec3& dimensions, const glm::vec3& lightPos, float voxelScale) {
+        // every cached face depends on where the light is relative to it, small moves barely shift the shadows
+        if (dimensions != m_dimensions || voxelScale != m_voxelScale || glm::length(lightPos - m_lightPos) > LIGHT_MOVE_THRESHOLD * voxelScale) {
+            m_clearAll = true;
+            m_lightPos = lightPos;
+        }
+
+        if (dimensions != m_dimensions)
+            m_queued.assign((size_t) dimensions.x * dimensions.y * dimensions.z, false);
+        m_dimensions = dimensions;
+        m_voxelScale = voxelScale;
+    }
+
+    void FaceLightCache::invalidate(const GridChangedEvent& event) {
+        if (m_clearAll) return;
+
+        glm::ivec3 radius(INVALIDATION_RADIUS);
+        for (const glm::ivec3& brick : event.getBricks()) {
+            invalidateShadowVolume(brick - radius, brick + radius + 1);
+        }
+        for (const GridRegion& region : event.getRegions()) {
+            invalidateShadowVolume(region.min - radius, region.max + radius);
+        }
+    }
+
+    void FaceLightCache::invalidateShadowVolume(glm::ivec3 min, glm::ivec3 max) {
+        if (m_clearAll) return;
+        invalidateRegion(min, max);
+
+        // A face whose shadow ray passes through the box may be lit or shadowed differently now. Those faces
+        // lie behind the box as seen from the light, in slices that are the box scaled up about the light.
+        // Slices one brick apart overlap, so their union covers the whole volume.
+        glm::vec3 light = m_lightPos / (m_voxelScale * (float) BRICK_SIZE);
+        glm::vec3 center = glm::vec3(min + max) * 0.5f;
+        glm::vec3 halfExtent = glm::vec3(max - min) * 0.5f;
+        float distance = glm::length(center - light);
+        if (distance <= glm::length(halfExtent)) {
+            // with the light inside the box, every direction may be shadowed by it
+            m_clearAll = true;
+            clearQueued();
+            return;
+        }
+
+        glm::vec3 away = (center - light) / distance;
+        float length = glm::length(glm::vec3(m_dimensions));
+        for (float t = 1.0f; t <= length && !m_clearAll; t += 1.0f) {
+            glm::vec3 slice = center + away * t;
+            glm::vec3 extent = halfExtent * ((distance + t) / distance) + 0.5f;
+            invalidateRegion(glm::ivec3(glm::floor(slice - extent)), glm::ivec3(glm::ceil(slice + extent)));
+        }
+    }
+
+    void FaceLightCache::invalidateRegion(glm::ivec3 min, glm::ivec3 max) {
+        min = glm::max(min, glm::ivec3(0));
+        max = glm::min(max, m_dimensions);
+        if (glm::any(glm::greaterThanEqual(min, max))) return;
+
+        for (int z = min.z; z < max.z; z++) {
+            for (int y = min.y; y < max.y; y++) {
+                for (int x = min.x; x < max.x; x++) {
+                    uint32_t cell = (uint32_t) (x + y * m_dimensions.x + z * m_dimensions.x * m_dimensions.y);
+                    if (m_queued[cell]) continue;
+
+                    m_queued[cell] = true;
+                    m_invalidated.push_back(cell);
+                }
+            }
+        }
+
+        // past a quarter of the cells, starting over is cheaper than clearing them one by one
+        if (m_invalidated.size() > m_queued.size() / 4) {
+            m_clearAll = true;
+            clearQueued();
+        }
+    }
+
+    void FaceLightCache::clearQueued() {
+        for (uint32_t cell : m_invalidated) {
+            m_queued[cell] = false;
+        }
+        m_invalidated.clear();
+    }
+
+    void FaceLightCache::update(RenderAPI* api, Shader* program) {
+        VXE_PROFILE_GPU_SCOPE("face light cache");
+
+        if (!m_slotsSSBO) {
+            m_slotsSSBO = ShaderStorageBuffer::create(SLOTS_BINDING);
+            m_facesSSBO = ShaderStorageBuffer::create(FACES_BINDING);
+            m_invalidatedSSBO = ShaderStorageBuffer::create(INVALIDATED_BINDING);
+            m_facesSSBO->setData(nullptr, m_capacity * FACE_WORDS * 2 * sizeof(uint32_t));
+        }
+
+        if (m_clearAll) {
+            uint32_t cells = (uint32_t) (m_dimensions.x * m_dimensions.y * m_dimensions.z);
+            if (m_slotsSSBO->getSize() != (1 + cells) * sizeof(uint32_t))
+                m_slotsSSBO->setData(nullptr, (1 + cells) * sizeof(uint32_t));
+            m_slotsSSBO->clear();
+            m_facesSSBO->clear();
+            m_clearAll = false;
+            clearQueued();
+        }
+
+        m_slotsSSBO->bindBase();
+        m_facesSSBO->bindBase();
+
+        if (!m_invalidated.empty()) {
+            m_invalidatedSSBO->setData(m_invalidated.data(), (unsigned int) (m_invalidated.size() * sizeof(uint32_t)));
+            program->bind();
+            program->setUniform("invalidatedCount", (uint32_t) m_invalidated.size());
+            api->dispatchCompute(((uint32_t) m_invalidated.size() + 63) / 64, 1);
+            clearQueued();
+        }
+        // the clears and the invalidation have to land before the faces are read
+        api->memoryBarrier(BARRIER_SHADER_STORAGE);
+    }
+
+    size_t FaceLightCache::getSizeInBytes() const {
+        size_t size = 0;
+        if (m_slotsSSBO) size += m_slotsSSBO->getSize() + m_facesSSBO->getSize();
+        return size;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef VXE_FACE_LIGHT_CACHE_H
+#define VXE_FACE_LIGHT_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../DataStructures/BrickMap.h"
+#include "../Events/VoxelGridEvent.h"
+#include "graphics/RenderAPI.h"
+#include "graphics/Shader.h"
+#include "graphics/ShaderStorageBuffer.h"
+
+namespace vxe {
+    /// @brief Shadows of the voxel faces of a brick map, kept on the GPU from frame to frame.
+    ///
+    /// Cells of the brick map get a slot the first time a shader shades one of their faces, see
+    /// assets/shader/common/face_light_cache.glsl. A slot has a valid and a lit bit for each of the six
+    /// faces of every voxel, a face is traced once and then read from its bits until it is invalidated.
+    /// An edit invalidates the cells near it and those in its shadow volume, everything is dropped when the
+    /// brick map changes or the light moves further than LIGHT_MOVE_THRESHOLD. A light that keeps moving
+    /// still clears the cache every time it crosses the threshold, the cache pays off for lights that rest.
+    /// The slots are never given back, once all are handed out the remaining cells trace every frame.
+    class FaceLightCache {
+        public:
+            static constexpr unsigned int SLOTS_BINDING = 8;
+            static constexpr unsigned int FACES_BINDING = 9;
+            static constexpr unsigned int INVALIDATED_BINDING = 10;
+            // valid bits of the faces of a cell, followed by as many lit bits
+            static constexpr uint32_t FACE_WORDS = (uint32_t) (VOXELS_PER_BRICK * 6 / 32);
+            // bricks around an edit whose faces are traced again
+            static constexpr int INVALIDATION_RADIUS = 2;
+            // voxels the light may move before the cached shadows are dropped
+            static constexpr float LIGHT_MOVE_THRESHOLD = 0.5f;
+
+            /// @param capacity cells that can hold a slot at once
+            FaceLightCache(uint32_t capacity = 8192);
+
+            /// @brief Drops every slot if the brick map dimensions or the voxel scale differ from the last call, or
+            /// the light moved further than LIGHT_MOVE_THRESHOLD since the slots were last dropped.
+            void setScene(const glm::ivec3& dimensions, const glm::vec3& lightPos, float voxelScale);
+            /// @brief Queues the cells around everything the event lists and in its shadow volume for invalidation.
+            void invalidate(const GridChangedEvent& event);
+            /// @brief Drops every slot with the next update().
+            void clear() { m_clearAll = true; }
+
+            /// @brief Applies the queued invalidations with program (assets/shader/face_light_invalidate.comp)
+            /// and binds the buffers. Call before the passes that use the cache.
+            void update(RenderAPI* api, Shader* program);
+
+            uint32_t getCapacity() const { return m_capacity; }
+            size_t getSizeInBytes() const;
+
+        private:
+            uint32_t m_capacity;
+            glm::ivec3 m_dimensions{0};
+            glm::vec3 m_lightPos{0.0f};
+            float m_voxelScale = 0.0f;
+            bool m_clearAll = true;
+            std::vector<uint32_t> m_invalidated;
+            std::vector<bool> m_queued;                         // per cell, whether it is in m_invalidated
+
+            std::unique_ptr<ShaderStorageBuffer> m_slotsSSBO;   // slots handed out, then the slot + 1 of each cell
+            std::unique_ptr<ShaderStorageBuffer> m_facesSSBO;
+            std::unique_ptr<ShaderStorageBuffer> m_invalidatedSSBO;
+
+            void invalidateShadowVolume(glm::ivec3 min, glm::ivec3 max);
+            void invalidateRegion(glm::ivec3 min, glm::ivec3 max);
+            void clearQueued();
+    };
+}
+
+#endif
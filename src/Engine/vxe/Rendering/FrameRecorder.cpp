@@ -0,0 +1,170 @@
+#include "FrameRecorder.h"
+
+#include "../Core/Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+namespace vxe {
+    FrameRecorder::FrameRecorder(std::filesystem::path directory, unsigned int slots)
+        : m_directory(std::move(directory)) {
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+        if (error) {
+            spdlog::error("Failed to create capture directory '{}': {}", m_directory.string(), error.message());
+            throw std::runtime_error("Failed to create capture directory.");
+        }
+
+        m_capture = FrameCapture::create(slots);
+        m_writer = std::thread(&FrameRecorder::writeLoop, this);
+    }
+
+    FrameRecorder::~FrameRecorder() {
+        finish();
+    }
+
+    void FrameRecorder::capture(const Framebuffer* source, uint32_t width, uint32_t height) {
+        if (!m_writer.joinable()) return;
+        VXE_PROFILE_FUNCTION();
+
+        collect(false);
+        if (!m_capture->capture(source, width, height, m_nextIndex)) {
+            // every slot still waits for its readback, the GPU is more than a few frames behind
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stats.stalls++;
+            }
+            collect(true);
+            m_capture->capture(source, width, height, m_nextIndex);
+        }
+        m_nextIndex++;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.captured++;
+    }
+
+    void FrameRecorder::finish() {
+        if (!m_writer.joinable()) return;
+
+        while (m_capture->getPendingCount() > 0) {
+            collect(true);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_queueChanged.notify_all();
+        m_writer.join();
+
+        FrameRecorderStats stats = getStats();
+        spdlog::info("Recorded {} of {} frames to '{}'. (stalls: {}) (write: {:.2f} ms/frame)",
+            stats.written, stats.captured, m_directory.string(), stats.stalls, stats.averageWriteMs);
+    }
+
+    FrameRecorderStats FrameRecorder::getStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    void FrameRecorder::collect(bool waitForOldest) {
+        bool wait = waitForOldest;
+        while (m_capture->getPendingCount() > 0) {
+            CapturedFrame frame = takeFree();
+            if (!m_capture->read(frame, wait)) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_free.push_back(std::move(frame));
+                break;
+            }
+
+            wait = false;
+            enqueue(std::move(frame));
+        }
+    }
+
+    void FrameRecorder::enqueue(CapturedFrame&& frame) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_queue.size() >= MAX_QUEUED_FRAMES) {
+            // the disk is slower than the renderer, holding more frames would only grow memory
+            m_stats.stalls++;
+            m_queueChanged.wait(lock, [&] { return m_queue.size() < MAX_QUEUED_FRAMES; });
+        }
+        m_queue.push_back(std::move(frame));
+
+        lock.unlock();
+        m_queueChanged.notify_all();
+    }
+
+    CapturedFrame FrameRecorder::takeFree() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.empty()) return CapturedFrame();
+
+        CapturedFrame frame = std::move(m_free.back());
+        m_free.pop_back();
+        return frame;
+    }
+
+    void FrameRecorder::writeLoop() {
+        std::vector<uint8_t> rgb;
+        bool failed = false;
+
+        while (true) {
+            CapturedFrame frame;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_queueChanged.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+                if (m_queue.empty()) return;
+
+                frame = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            m_queueChanged.notify_all();
+
+            auto start = std::chrono::steady_clock::now();
+            bool written = writeFrame(frame, rgb);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            if (!written && !failed) {
+                spdlog::error("Failed to write frame {} to '{}'.", frame.index, m_directory.string());
+                failed = true;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (written) {
+                m_stats.written++;
+                m_writeMs += ms;
+                m_stats.averageWriteMs = m_writeMs / m_stats.written;
+            }
+            m_free.push_back(std::move(frame));
+        }
+    }
+
+    bool FrameRecorder::writeFrame(const CapturedFrame& frame, std::vector<uint8_t>& rgb) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%06llu.ppm", (unsigned long long) frame.index);
+
+        std::ofstream file(m_directory / name, std::ios::binary);
+        if (!file) return false;
+
+        // binary PPM is RGB with the top row first, the readback is RGBA with the bottom row first
+        rgb.resize((size_t) frame.width * frame.height * 3);
+        for (uint32_t y = 0; y < frame.height; y++) {
+            const uint8_t* src = frame.pixels.data() + (size_t) (frame.height - 1 - y) * frame.width * 4;
+            uint8_t* dst = rgb.data() + (size_t) y * frame.width * 3;
+            for (uint32_t x = 0; x < frame.width; x++) {
+                dst[x * 3 + 0] = src[x * 4 + 0];
+                dst[x * 3 + 1] = src[x * 4 + 1];
+                dst[x * 3 + 2] = src[x * 4 + 2];
+            }
+        }
+
+        file << "P6\n" << frame.width << " " << frame.height << "\n255\n";
+        file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+        return (bool) file;
+    }
+}
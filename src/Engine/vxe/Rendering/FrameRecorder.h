@@ -0,0 +1,71 @@
+#ifndef VXE_FRAME_RECORDER_H
+#define VXE_FRAME_RECORDER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "graphics/FrameCapture.h"
+
+namespace vxe {
+    struct FrameRecorderStats {
+        uint64_t captured = 0;
+        uint64_t written = 0;
+        uint64_t stalls = 0;        // captures that had to wait for an earlier readback or for the writer
+        double averageWriteMs = 0.0;
+    };
+
+    /// @brief Writes every rendered frame to <directory>/frame_000000.ppm, frame_000001.ppm, ...
+    ///
+    /// The pixels are read back through FrameCapture a few frames late and encoded on a writer thread,
+    /// so recording only stalls the render loop when the GPU or the disk cannot keep up.
+    /// All methods except getStats() have to be called on the thread that owns the GL context.
+    class FrameRecorder {
+        public:
+            static constexpr size_t MAX_QUEUED_FRAMES = 8;
+
+            /// @param slots frames that may be in flight between capture and readback
+            FrameRecorder(std::filesystem::path directory, unsigned int slots = 3);
+            ~FrameRecorder();
+
+            FrameRecorder(const FrameRecorder&) = delete;
+            FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+            /// @brief Records the frame in source, or in the window's back buffer if source is null.
+            /// Call after the last draw and before the swap.
+            void capture(const Framebuffer* source, uint32_t width, uint32_t height);
+            /// @brief Reads back and writes every captured frame, then stops the writer.
+            void finish();
+
+            FrameRecorderStats getStats() const;
+            const std::filesystem::path& getDirectory() const { return m_directory; }
+
+        private:
+            std::filesystem::path m_directory;
+            std::unique_ptr<FrameCapture> m_capture;
+            uint64_t m_nextIndex = 0;
+
+            mutable std::mutex m_mutex;
+            std::condition_variable m_queueChanged;
+            std::deque<CapturedFrame> m_queue;
+            std::vector<CapturedFrame> m_free; // written frames whose pixel storage is reused
+            bool m_stopping = false;
+            FrameRecorderStats m_stats;
+            double m_writeMs = 0.0;
+            std::thread m_writer;
+
+            // moves finished readbacks to the writer, only the oldest one is waited for
+            void collect(bool waitForOldest);
+            void enqueue(CapturedFrame&& frame);
+            CapturedFrame takeFree();
+            void writeLoop();
+            bool writeFrame(const CapturedFrame& frame, std::vector<uint8_t>& rgb) const;
+    };
+}
+
+#endif
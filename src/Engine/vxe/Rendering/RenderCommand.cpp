@@ -0,0 +1,70 @@
+#include "RenderCommand.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+namespace vxe {
+    static uint64_t hashPointer(const void* pointer, uint64_t seed) {
+        uint64_t x = (uint64_t) (uintptr_t) pointer ^ seed;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    void RenderCommand::addStorageBuffer(const ShaderStorageBuffer* buffer) {
+        if (!buffer) return;
+        if (storageBufferCount == MAX_STORAGE_BUFFERS) {
+            spdlog::error("A render command binds more than {} storage buffers.", MAX_STORAGE_BUFFERS);
+            throw std::runtime_error("Too many storage buffers for a render command!");
+        }
+
+        storageBuffers[storageBufferCount++] = buffer;
+    }
+
+    void RenderCommandList::submit(Renderable* object, Shader* program,
+        std::initializer_list<const ShaderStorageBuffer*> storageBuffers, uint16_t layer) {
+        RenderCommand command;
+        command.object = object;
+        command.program = program;
+        for (const ShaderStorageBuffer* buffer : storageBuffers) {
+            command.addStorageBuffer(buffer);
+        }
+        submit(std::move(command), layer);
+    }
+
+    void RenderCommandList::submit(RenderCommand command, uint16_t layer) {
+        command.sortKey = makeSortKey(layer, command.program, command.storageBuffers, command.storageBufferCount);
+        m_commands.push_back(std::move(command));
+    }
+
+    void RenderCommandList::append(RenderCommandList& other) {
+        if (m_commands.empty()) {
+            m_commands.swap(other.m_commands);
+        } else {
+            m_commands.insert(m_commands.end(), other.m_commands.begin(), other.m_commands.end());
+        }
+        other.m_commands.clear();
+    }
+
+    void RenderCommandList::sort() {
+        std::stable_sort(m_commands.begin(), m_commands.end(), [](const RenderCommand& a, const RenderCommand& b) {
+            return a.sortKey < b.sortKey;
+        });
+    }
+
+    uint64_t RenderCommandList::makeSortKey(uint16_t layer, const Shader* program, const ShaderStorageBuffer* const* storageBuffers, uint32_t count) {
+        // a collision only costs a state change, the commands are drawn correctly whatever their order in a layer
+        uint64_t buffers = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            buffers = hashPointer(storageBuffers[i], buffers + i);
+        }
+
+        // program changes are the expensive ones, so they are grouped first
+        uint64_t programBits = program ? hashPointer(program, 0) & 0xFFFFFF : 0;
+        return ((uint64_t) layer << 48) | (programBits << 24) | (buffers & 0xFFFFFF);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef VXE_RENDER_COMMAND_H
+#define VXE_RENDER_COMMAND_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "Renderable.h"
+#include "graphics/Shader.h"
+#include "graphics/ShaderStorageBuffer.h"
+
+namespace vxe {
+    /// @brief Draw of a Renderable together with the program, storage buffers and uniforms it needs.
+    struct RenderCommand {
+        static constexpr size_t MAX_STORAGE_BUFFERS = 8;
+
+        Renderable* object = nullptr;
+        Shader* program = nullptr; // null draws with whatever program is bound
+        const ShaderStorageBuffer* storageBuffers[MAX_STORAGE_BUFFERS] = {};
+        uint32_t storageBufferCount = 0;
+        // sets the uniforms of the draw once program is bound, called even if it was bound already. A plain
+        // function and what it works on, so that recording a command never allocates
+        void (*setUniforms)(void* context, Shader& program) = nullptr;
+        void* uniformContext = nullptr;
+        // layer in the top 16 bits, then hashes of the program and of the storage buffers
+        uint64_t sortKey = 0;
+
+        /// @brief Adds a buffer to bind before the draw, null ones are skipped.
+        void addStorageBuffer(const ShaderStorageBuffer* buffer);
+    };
+
+    /// @brief Commands of one frame, recorded without any calls into the RenderAPI.
+    ///
+    /// A list belongs to one thread at a time, so each thread that prepares draws fills its own and hands it
+    /// to Renderer::submit(). Sorting by key orders the commands by layer and groups those with the same
+    /// program and buffers, the order of submission is only kept between commands with equal keys.
+    class RenderCommandList {
+        public:
+            /// @param layer commands of a lower layer are drawn first, whatever their state
+            void submit(Renderable* object, Shader* program = nullptr,
+                std::initializer_list<const ShaderStorageBuffer*> storageBuffers = {}, uint16_t layer = 0);
+            /// @brief Adds command, its sort key is made here.
+            void submit(RenderCommand command, uint16_t layer = 0);
+            /// @brief Moves the commands of other to the end of this list and leaves other empty.
+            void append(RenderCommandList& other);
+            void sort();
+            void clear() { m_commands.clear(); }
+
+            bool empty() const { return m_commands.empty(); }
+            size_t size() const { return m_commands.size(); }
+            const std::vector<RenderCommand>& getCommands() const { return m_commands; }
+
+            static uint64_t makeSortKey(uint16_t layer, const Shader* program, const ShaderStorageBuffer* const* storageBuffers, uint32_t count);
+
+        private:
+            std::vector<RenderCommand> m_commands;
+    };
+}
+
+#endif
@@ -0,0 +1,62 @@
+#include "RenderScaleController.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace vxe {
+    // aim a bit below the budget, a frame right at it is already late when something else takes longer
+    static constexpr double HEADROOM = 0.9;
+    // weight of a new measurement in the smoothed cost
+    static constexpr double SMOOTHING = 0.15;
+    // scale changes below this are ignored, larger ones are limited to MAX_STEP per frame
+    static constexpr float DEAD_ZONE = 0.02f;
+    static constexpr float MAX_STEP = 0.05f;
+
+    RenderScaleController::RenderScaleController(float targetMs, float minScale, float maxScale)
+        : m_targetMs(targetMs), m_minScale(minScale), m_maxScale(maxScale), m_scale(maxScale) {
+        std::fill(std::begin(m_frames), std::end(m_frames), UINT64_MAX);
+        std::fill(std::begin(m_scales), std::end(m_scales), maxScale);
+    }
+
+    float RenderScaleController::beginFrame(uint64_t frame) {
+        if (m_enabled && m_fullResolutionMs > 0.0) {
+            float ideal = (float) std::sqrt(m_targetMs * HEADROOM / m_fullResolutionMs);
+            ideal = std::clamp(ideal, m_minScale, m_maxScale);
+
+            float difference = ideal - m_scale;
+            if (std::abs(difference) > DEAD_ZONE || ideal == m_minScale || ideal == m_maxScale)
+                m_scale += std::clamp(difference, -MAX_STEP, MAX_STEP);
+        }
+
+        m_frames[frame % HISTORY] = frame;
+        m_scales[frame % HISTORY] = m_scale;
+        return m_scale;
+    }
+
+    void RenderScaleController::addMeasurement(uint64_t frame, double gpuMs) {
+        if (m_lastMeasured != UINT64_MAX && frame <= m_lastMeasured) return;
+        // too old to know what scale it was rendered at
+        if (m_frames[frame % HISTORY] != frame || gpuMs <= 0.0) return;
+        m_lastMeasured = frame;
+
+        float scale = m_scales[frame % HISTORY];
+        double fullResolutionMs = gpuMs / (scale * scale);
+
+        if (m_fullResolutionMs == 0.0)
+            m_fullResolutionMs = fullResolutionMs;
+        else
+            m_fullResolutionMs += (fullResolutionMs - m_fullResolutionMs) * SMOOTHING;
+    }
+
+    void RenderScaleController::setEnabled(bool enabled) {
+        m_enabled = enabled;
+        if (!enabled) m_scale = m_maxScale;
+    }
+
+    void RenderScaleController::setRange(float minScale, float maxScale) {
+        m_minScale = std::min(minScale, maxScale);
+        m_maxScale = maxScale;
+        m_scale = std::clamp(m_scale, m_minScale, m_maxScale);
+    }
+}
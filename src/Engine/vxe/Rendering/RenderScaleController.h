@@ -0,0 +1,53 @@
+#ifndef VXE_RENDER_SCALE_CONTROLLER_H
+#define VXE_RENDER_SCALE_CONTROLLER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vxe {
+    /// @brief Picks the render scale that keeps the GPU frame time within a budget.
+    ///
+    /// The raymarcher's cost grows with the pixel count, i.e. with the square of the scale. Every GPU
+    /// frame time is divided by the squared scale that frame was rendered at, which gives the cost of a
+    /// full resolution frame no matter how many frames late the measurement arrives. The scale follows
+    /// sqrt(budget / cost), smoothed and limited in how fast it may change so that it does not oscillate.
+    class RenderScaleController {
+        public:
+            static constexpr size_t HISTORY = 16;   // frames a measurement may lag behind
+
+            RenderScaleController(float targetMs = 16.0f, float minScale = 0.5f, float maxScale = 1.0f);
+
+            /// @brief Call once per frame before rendering it.
+            /// @return the scale to render the frame at
+            float beginFrame(uint64_t frame);
+            /// @brief Reports the GPU time of an earlier frame, older or repeated measurements are ignored.
+            void addMeasurement(uint64_t frame, double gpuMs);
+
+            void setEnabled(bool enabled);
+            bool isEnabled() const { return m_enabled; }
+
+            void setTargetFrameTime(float ms) { m_targetMs = ms; }
+            float getTargetFrameTime() const { return m_targetMs; }
+            void setRange(float minScale, float maxScale);
+            float getMinScale() const { return m_minScale; }
+            float getMaxScale() const { return m_maxScale; }
+
+            float getScale() const { return m_scale; }
+            /// @brief Smoothed GPU time of a frame at full resolution, 0 before the first measurement.
+            double getFullResolutionMs() const { return m_fullResolutionMs; }
+
+        private:
+            float m_targetMs, m_minScale, m_maxScale;
+            float m_scale;
+            bool m_enabled = true;
+
+            double m_fullResolutionMs = 0.0;
+            uint64_t m_lastMeasured = UINT64_MAX;
+
+            // scale each recent frame was rendered at, indexed by frame % HISTORY
+            uint64_t m_frames[HISTORY];
+            float m_scales[HISTORY];
+    };
+}
+
+#endif
@@ -1,29 +1,200 @@
 #include "Renderer.h"
 
+#include "FrameRecorder.h"
+
+#include "../Core/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
 namespace vxe {
+    Renderer::~Renderer() {
+        // the timer queries belong to our context
+        if (m_api)
+            Profiler::getInstance().setRenderAPI(nullptr);
+    }
+
     void Renderer::init(Window* window) {
         m_api = RenderAPI::create();
         m_api->init(window);
         m_window = window;
+
+        // without a window there is no default framebuffer to draw into
+        if (window->isHeadless())
+            m_target = Framebuffer::create(window->getWidth(), window->getHeight());
+
+        Profiler::getInstance().setRenderAPI(m_api.get());
     }
 
     void Renderer::beginFrame() {
+        VXE_PROFILE_SCOPE("Renderer::beginFrame");
+        VXE_PROFILE_GPU_SCOPE("clear");
+
+        glm::uvec2 output = getOutputSize();
+        glm::uvec2 size = getRenderSize();
+        m_offscreen = m_upscaleShader && (size != output || m_offscreenScene || m_keepHistory);
+
+        if (!m_keepHistory)
+            m_historyTarget = nullptr;
+        if (m_offscreen) {
+            // the history is kept until this frame was drawn, so the frame goes into the other target
+            size_t index = m_historyTarget == m_sceneTargets[0].get() ? 1 : 0;
+            m_sceneTarget = prepareSceneTarget(index, output);
+            m_sceneTarget->bind();
+        } else {
+            bindOutput();
+        }
+
+        m_api->setViewport(0, 0, size.x, size.y);
         m_api->clear();
+        m_renderSize = size;
+        m_flushed = false;
+        m_queueStats = RenderQueueStats();
     }
 
     void Renderer::submit(Renderable* object) {
-        m_renderQueue.push_back(object);
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_renderQueue.submit(object);
+    }
+
+    void Renderer::submit(Renderable* object, Shader* program, std::initializer_list<const ShaderStorageBuffer*> storageBuffers, uint16_t layer) {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_renderQueue.submit(object, program, storageBuffers, layer);
+    }
+
+    void Renderer::submit(RenderCommand command, uint16_t layer) {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_renderQueue.submit(std::move(command), layer);
+    }
+
+    void Renderer::submit(RenderCommandList& list) {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_renderQueue.append(list);
+    }
+
+    void Renderer::drawScene() {
+        RenderCommandList commands;
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            commands.append(m_renderQueue);
+        }
+        if (commands.empty()) return;
+
+        VXE_PROFILE_GPU_SCOPE("draw");
+        commands.sort();
+
+        // the cache knows what is still bound from the passes before and from the last frame
+        for (const RenderCommand& command : commands.getCommands()) {
+            if (command.program) {
+                bool bound = m_api->bindProgram(command.program);
+                m_queueStats.programBinds += bound;
+                m_queueStats.skippedBinds += !bound;
+                if (command.setUniforms)
+                    command.setUniforms(command.uniformContext, *command.program);
+            }
+            for (uint32_t i = 0; i < command.storageBufferCount; i++) {
+                bool bound = m_api->bindStorageBuffer(command.storageBuffers[i]);
+                m_queueStats.bufferBinds += bound;
+                m_queueStats.skippedBinds += !bound;
+            }
+            command.object->draw(m_api.get());
+        }
+        m_queueStats.commands += (uint32_t) commands.size();
+    }
+
+    void Renderer::flush() {
+        if (m_flushed) return;
+        m_flushed = true;
+
+        VXE_PROFILE_SCOPE("Renderer::flush");
+        drawScene();
+
+        m_historyTarget = m_keepHistory && m_offscreen ? m_sceneTarget : nullptr;
+        m_historySize = m_renderSize;
+
+        if (m_offscreen)
+            upscale();
     }
 
     void Renderer::endFrame() {
-        for (const auto& obj : m_renderQueue) {
-            obj->draw(m_api.get());
+        flush();
+
+        {
+            VXE_PROFILE_SCOPE("Renderer::endFrame");
+            if (m_recorder) {
+                VXE_PROFILE_GPU_SCOPE("capture");
+                glm::uvec2 output = getOutputSize();
+                m_recorder->capture(m_target.get(), output.x, output.y);
+            }
+            m_api->swapBuffer(m_window);
         }
-        m_renderQueue.clear();
-        m_api->swapBuffer(m_window);
+
+        // with vsync off this is when the frame was handed to the compositor, not when it hit the screen
+        m_window->getInput().onPresent();
+
+        Profiler::getInstance().endFrame();
+    }
+
+    void Renderer::setRenderScale(float scale) {
+        m_renderScale = std::clamp(scale, 0.1f, 1.0f);
+    }
+
+    glm::uvec2 Renderer::getOutputSize() const {
+        if (m_target)
+            return glm::uvec2(m_target->getWidth(), m_target->getHeight());
+        return glm::uvec2(m_window->getWidth(), m_window->getHeight());
+    }
+
+    glm::uvec2 Renderer::getRenderSize() const {
+        glm::uvec2 output = getOutputSize();
+        if (!m_upscaleShader || m_renderScale >= 1.0f) return output;
+
+        return glm::uvec2(
+            std::max(1u, (uint32_t) std::lround(output.x * m_renderScale)),
+            std::max(1u, (uint32_t) std::lround(output.y * m_renderScale)));
     }
 
     RenderAPI* Renderer::getAPI() {
         return m_api.get();
     }
-}
\ No newline at end of file
+
+    Framebuffer* Renderer::prepareSceneTarget(size_t index, glm::uvec2 size) {
+        // allocated at the output size, scaled frames only use its lower left corner
+        if (!m_sceneTargets[index])
+            m_sceneTargets[index] = Framebuffer::create(size.x, size.y, { TextureFormat::RGBA8, TextureFormat::R32F, TextureFormat::RGBA32F, TextureFormat::RGBA16F });
+        m_sceneTargets[index]->resize(size.x, size.y);
+        return m_sceneTargets[index].get();
+    }
+
+    void Renderer::bindOutput() {
+        if (m_target)
+            m_target->bind();
+        else if (m_sceneTarget)
+            m_sceneTarget->unbind();
+    }
+
+    void Renderer::upscale() {
+        VXE_PROFILE_GPU_SCOPE("upscale");
+
+        glm::uvec2 output = getOutputSize();
+        glm::uvec2 size = getRenderSize();
+
+        // the triangle covers every pixel, clearing only resets the depth it is tested against
+        bindOutput();
+        m_api->setViewport(0, 0, output.x, output.y);
+        m_api->clear();
+
+        if (!m_fullscreenVA)
+            m_fullscreenVA = VertexArray::create();
+
+        m_sceneTarget->bindColorAttachment(0, 0);
+        m_sceneTarget->bindColorAttachment(1, 1);
+        m_upscaleShader->bind();
+        m_upscaleShader->setUniform("sceneColor", 0);
+        m_upscaleShader->setUniform("sceneDistance", 1);
+        m_upscaleShader->setUniform("sourceSize", glm::vec2(size));
+        m_upscaleShader->setUniform("outputSize", glm::vec2(output));
+        m_api->drawVertexArray(m_fullscreenVA.get(), 3);
+    }
+}
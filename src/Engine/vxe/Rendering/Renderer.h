@@ -3,30 +3,114 @@
 
 #include <vector>
 #include <memory>
+#include <mutex>
 
+#include "graphics/Framebuffer.h"
 #include "graphics/RenderAPI.h"
 #include "graphics/Shader.h"
 #include "graphics/ShaderStorageBuffer.h"
 
+#include "RenderCommand.h"
 #include "Renderable.h"
 
 namespace vxe {
+    class FrameRecorder;
+
+    /// @brief What the draws of the current frame did, since beginFrame().
+    struct RenderQueueStats {
+        uint32_t commands = 0;
+        uint32_t programBinds = 0;
+        uint32_t bufferBinds = 0;
+        uint32_t skippedBinds = 0; // binds the state cache found redundant
+    };
+
     class Renderer {
         public:
             Renderer() = default;
-            ~Renderer() = default;
+            ~Renderer();
             
             void init(Window* window);
             
             void beginFrame();
+            /// @brief Draws object with whatever program and buffers are bound when the queue is drawn.
             void submit(Renderable* object);
+            /// @brief Draws object with program and storageBuffers bound, see RenderCommandList::submit().
+            void submit(Renderable* object, Shader* program, std::initializer_list<const ShaderStorageBuffer*> storageBuffers = {},
+                uint16_t layer = 0);
+            /// @brief Draws command, see RenderCommandList::submit().
+            void submit(RenderCommand command, uint16_t layer = 0);
+            /// @brief Takes over the commands of list, which is left empty. Unlike the other calls this one may
+            /// come from any thread, e.g. with a list each thread recorded on its own.
+            void submit(RenderCommandList& list);
+            /// @brief Sorts and draws the commands submitted so far, for passes that read the scene before it is upscaled.
+            void drawScene();
+            /// @brief Draws the submitted objects and upscales them into the output when rendering at a lower scale.
+            /// Called by endFrame() if it was not, call it before drawing overlays that should stay at full resolution.
+            void flush();
             void endFrame();
 
             RenderAPI* getAPI();
+
+            /// @brief The offscreen framebuffer frames are drawn into, null when drawing to the window.
+            Framebuffer* getRenderTarget() const { return m_target.get(); }
+            /// @brief Records every frame from the next endFrame() on, null stops recording. Not owned.
+            void setFrameRecorder(FrameRecorder* recorder) { m_recorder = recorder; }
+
+            /// @brief Program that upscales the scene, null always renders at the output size. Not owned.
+            /// It gets the scene as sceneColor (unit 0) and its hit distances as sceneDistance (unit 1),
+            /// fragment output location 1 of the scene programs, together with sourceSize and outputSize.
+            void setUpscaleShader(Shader* program) { m_upscaleShader = program; }
+            /// @brief Fraction of the output size the next frames are rendered at, between 0.1 and 1.
+            void setRenderScale(float scale);
+            float getRenderScale() const { return m_renderScale; }
+            /// @brief Size of the window or of the headless target.
+            glm::uvec2 getOutputSize() const;
+            /// @brief Size the submitted objects are drawn at.
+            glm::uvec2 getRenderSize() const;
+
+            /// @brief Draws the scene into getSceneTarget() even at full scale, for passes that write it as images.
+            /// Needs the upscale program, which then only copies the scene to the output.
+            void setOffscreenScene(bool enabled) { m_offscreenScene = enabled; }
+            /// @brief Color (RGBA8), hit distance (R32F), hit voxel (RGBA32F) and hit surface (RGBA16F) of the
+            /// frame being drawn, fragment output locations 0 to 3, in its lower left getRenderSize() pixels.
+            /// Null if the scene is drawn straight into the output.
+            Framebuffer* getSceneTarget() const { return m_offscreen ? m_sceneTarget : nullptr; }
+
+            /// @brief Keeps the scene target of the last drawn frame around as getHistoryTarget() while the
+            /// next one is drawn, which draws the scene offscreen like setOffscreenScene().
+            void setKeepHistory(bool enabled) { m_keepHistory = enabled; }
+            /// @brief The scene target of the last drawn frame, null if it was not kept. It keeps its size
+            /// when the output is resized.
+            Framebuffer* getHistoryTarget() const { return m_historyTarget; }
+            /// @brief Render size of the last drawn frame, the part of getHistoryTarget() that holds it.
+            glm::uvec2 getHistorySize() const { return m_historySize; }
+
+            const RenderQueueStats& getQueueStats() const { return m_queueStats; }
         private:
-            std::vector<Renderable*> m_renderQueue;
+            std::mutex m_queueMutex;
+            RenderCommandList m_renderQueue;
+            RenderQueueStats m_queueStats;
             std::unique_ptr<RenderAPI> m_api;
-            Window* m_window;
+            std::unique_ptr<Framebuffer> m_target;
+            FrameRecorder* m_recorder = nullptr;
+            Window* m_window = nullptr;
+
+            // scene at render scale, the second one holds the previous frame when it is kept
+            std::unique_ptr<Framebuffer> m_sceneTargets[2];
+            Framebuffer* m_sceneTarget = nullptr;
+            Framebuffer* m_historyTarget = nullptr;
+            glm::uvec2 m_renderSize{0}, m_historySize{0};
+            std::unique_ptr<VertexArray> m_fullscreenVA;
+            Shader* m_upscaleShader = nullptr;
+            float m_renderScale = 1.0f;
+            bool m_offscreenScene = false;
+            bool m_keepHistory = false;
+            bool m_offscreen = false;
+            bool m_flushed = true;
+
+            void bindOutput();
+            Framebuffer* prepareSceneTarget(size_t index, glm::uvec2 size);
+            void upscale();
     };
 }
 
@@ -0,0 +1,116 @@
+#include "ShaderVariants.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+namespace vxe {
+    ShaderVariants::ShaderVariants(std::string vertexPath, std::string fragmentPath, std::vector<std::string> features)
+        : m_vertexPath(std::move(vertexPath)), m_fragmentPath(std::move(fragmentPath)), m_features(std::move(features)) {
+        if (m_features.size() > MAX_FEATURES)
+            throw std::runtime_error("Too many shader features, the variant count doubles with every one.");
+        m_variants.resize(size_t(1) << m_features.size());
+    }
+
+    ShaderVariants::ShaderVariants(std::string computePath, std::vector<std::string> features)
+        : m_computePath(std::move(computePath)), m_features(std::move(features)) {
+        if (m_features.size() > MAX_FEATURES)
+            throw std::runtime_error("Too many shader features, the variant count doubles with every one.");
+        m_variants.resize(size_t(1) << m_features.size());
+    }
+
+    void ShaderVariants::define(std::string_view name, std::string_view value) {
+        for (auto& define : m_defines) {
+            if (define.first == name) {
+                define.second = value;
+                return;
+            }
+        }
+        m_defines.emplace_back(name, value);
+    }
+
+    void ShaderVariants::ignoreWhen(std::string_view feature, std::string_view other) {
+        m_rules.push_back({ getFeatureBitOrThrow(feature), getFeatureBitOrThrow(other), true });
+    }
+
+    void ShaderVariants::ignoreUnless(std::string_view feature, std::string_view other) {
+        m_rules.push_back({ getFeatureBitOrThrow(feature), getFeatureBitOrThrow(other), false });
+    }
+
+    void ShaderVariants::reset() {
+        std::fill(m_variants.begin(), m_variants.end(), nullptr);
+        m_compileTimeMs = 0.0;
+    }
+
+    Shader* ShaderVariants::get(uint32_t mask) {
+        mask &= uint32_t(m_variants.size() - 1);
+        for (const Rule& rule : m_rules) {
+            if (((mask & rule.other) != 0) == rule.whenEnabled) mask &= ~rule.feature;
+        }
+
+        if (!m_variants[mask])
+            m_variants[mask] = build(mask);
+        return m_variants[mask].get();
+    }
+
+    std::unique_ptr<Shader> ShaderVariants::build(uint32_t mask) {
+        auto shader = Shader::create();
+        if (!m_computePath.empty()) {
+            shader->compute(m_computePath);
+        } else {
+            shader->vertex(m_vertexPath);
+            shader->fragment(m_fragmentPath);
+        }
+
+        for (const auto& [name, value] : m_defines) {
+            shader->define(name, value);
+        }
+        std::string enabled;
+        for (size_t i = 0; i < m_features.size(); i++) {
+            bool on = (mask >> i) & 1;
+            shader->define(m_features[i], on ? "1" : "0");
+            if (on) enabled += (enabled.empty() ? "" : " ") + m_features[i];
+        }
+
+        shader->compile();
+        m_compileTimeMs += shader->getCompileTimeMs();
+        if (m_onBuild)
+            m_onBuild(*shader);
+
+        spdlog::info("Built variant '{}' [{}] in {:.1f} ms ({}).", m_computePath.empty() ? m_fragmentPath : m_computePath, enabled,
+            shader->getCompileTimeMs(), shader->isFromBinaryCache() ? "cached" : "compiled");
+        return shader;
+    }
+
+    uint32_t ShaderVariants::getFeatureBit(std::string_view feature) const {
+        for (size_t i = 0; i < m_features.size(); i++) {
+            if (m_features[i] == feature) return 1u << i;
+        }
+        return 0;
+    }
+
+    uint32_t ShaderVariants::getFeatureBitOrThrow(std::string_view feature) const {
+        uint32_t bit = getFeatureBit(feature);
+        if (bit == 0)
+            throw std::runtime_error("Unknown shader feature '" + std::string(feature) + "'.");
+        return bit;
+    }
+
+    size_t ShaderVariants::getBuiltCount() const {
+        size_t count = 0;
+        for (const auto& variant : m_variants) {
+            if (variant) count++;
+        }
+        return count;
+    }
+
+    bool ShaderVariants::isFromBinaryCache() const {
+        bool built = false;
+        for (const auto& variant : m_variants) {
+            if (variant && !variant->isFromBinaryCache()) return false;
+            built = built || variant;
+        }
+        return built;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef VXE_SHADER_VARIANTS_H
+#define VXE_SHADER_VARIANTS_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "graphics/Shader.h"
+
+namespace vxe {
+    /// @brief All permutations of a program over a set of on/off features.
+    ///
+    /// Feature i is bit i of a variant mask and is compiled in as `#define <name> 1`, or 0 when it is off,
+    /// so the shader can drop the code with `#if <name>` instead of branching on a uniform per pixel.
+    /// A variant is built the first time get() asks for it, the first frame after toggling a feature pays
+    /// for its compile (or its binary cache load). Masks that only differ in features declared to have no
+    /// effect share one program.
+    class ShaderVariants {
+        public:
+            static constexpr size_t MAX_FEATURES = 8;
+
+            ShaderVariants(std::string vertexPath, std::string fragmentPath, std::vector<std::string> features);
+            /// @brief Variants of a compute program.
+            ShaderVariants(std::string computePath, std::vector<std::string> features);
+
+            /// @brief Adds a define shared by all variants, variants built before it need a reset().
+            void define(std::string_view name, std::string_view value = "1");
+            /// @brief Declares that feature has no effect while other is enabled.
+            void ignoreWhen(std::string_view feature, std::string_view other);
+            /// @brief Declares that feature has no effect unless other is enabled.
+            void ignoreUnless(std::string_view feature, std::string_view other);
+            /// @brief Called with every variant right after it is built, for uniforms that never change.
+            void setOnBuild(std::function<void(Shader&)> onBuild) { m_onBuild = std::move(onBuild); }
+            /// @brief Drops the variants built so far, each one is built again when it is next used.
+            void reset();
+
+            /// @brief The variant with exactly the features in mask enabled, built on first use.
+            Shader* get(uint32_t mask);
+            /// @return the bit of the feature, 0 if there is no such feature
+            uint32_t getFeatureBit(std::string_view feature) const;
+
+            size_t getVariantCount() const { return m_variants.size(); }
+            /// @return how many variants have been built so far
+            size_t getBuiltCount() const;
+
+            double getCompileTimeMs() const { return m_compileTimeMs; }
+            /// @brief True if at least one variant was built and all of them were loaded from the program binary cache.
+            bool isFromBinaryCache() const;
+
+        private:
+            struct Rule {
+                uint32_t feature;
+                uint32_t other;
+                bool whenEnabled;
+            };
+
+            uint32_t getFeatureBitOrThrow(std::string_view feature) const;
+            std::unique_ptr<Shader> build(uint32_t mask);
+
+            std::string m_vertexPath, m_fragmentPath, m_computePath;
+            std::vector<std::string> m_features;
+            std::vector<std::pair<std::string, std::string>> m_defines;
+            std::vector<Rule> m_rules;
+            std::function<void(Shader&)> m_onBuild;
+            std::vector<std::unique_ptr<Shader>> m_variants; // indexed by mask, null until built
+            double m_compileTimeMs = 0.0;
+    };
+}
+
+#endif
@@ -6,6 +6,10 @@ vxe::VoxelGrid::VoxelGrid(const GridType type, const glm::ivec3 dimensions) {
     m_vao = VertexArray::create();
 }
 
+vxe::VoxelGrid::VoxelGrid(std::unique_ptr<Grid> grid) : m_grid(std::move(grid)) {
+    m_vao = VertexArray::create();
+}
+
 vxe::Grid* vxe::VoxelGrid::getGrid() const
 {
     return m_grid.get();
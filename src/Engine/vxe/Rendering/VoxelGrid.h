@@ -9,6 +9,7 @@ namespace vxe {
     class VoxelGrid : public Renderable {
         public:
             VoxelGrid(GridType type, glm::ivec3 dimensions);
+            VoxelGrid(std::unique_ptr<Grid> grid);
             ~VoxelGrid() = default;
 
             void bindVA();
@@ -1,25 +1,49 @@
+#include "FrameCapture.h"
+#include "Framebuffer.h"
 #include "IndexBuffer.h"
+#include "PixelQuery.h"
 #include "RenderAPI.h"
 #include "Shader.h"
 #include "ShaderStorageBuffer.h"
+#include "UniformBuffer.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
 
 #include <memory>
 
+#include "../../Platform/OpenGL/ogl_FrameCapture.h"
+#include "../../Platform/OpenGL/ogl_Framebuffer.h"
 #include "../../Platform/OpenGL/ogl_IndexBuffer.h"
+#include "../../Platform/OpenGL/ogl_PixelQuery.h"
+#include "../../Platform/OpenGL/ogl_ProgramCache.h"
 #include "../../Platform/OpenGL/ogl_RenderAPI.h"
 #include "../../Platform/OpenGL/ogl_Shader.h"
 #include "../../Platform/OpenGL/ogl_ShaderStorageBuffer.h"
+#include "../../Platform/OpenGL/ogl_UniformBuffer.h"
 #include "../../Platform/OpenGL/ogl_VertexArray.h"
 #include "../../Platform/OpenGL/ogl_VertexBuffer.h"
 
 namespace vxe {
+    std::unique_ptr<FrameCapture> FrameCapture::create(unsigned int slots) {
+        // TODO: add config to select the API
+        return std::make_unique<OGLFrameCapture>(slots);
+    }
+
+    std::unique_ptr<Framebuffer> Framebuffer::create(uint32_t width, uint32_t height, const std::vector<TextureFormat>& colorFormats) {
+        // TODO: add config to select the API
+        return std::make_unique<OGLFramebuffer>(width, height, colorFormats);
+    }
+
     std::unique_ptr<IndexBuffer> IndexBuffer::create(unsigned int* indices, size_t count) {
         // TODO: add config to select the API
         return std::make_unique<OGLIndexBuffer>(indices, count);
     }
 
+    std::unique_ptr<PixelQuery> PixelQuery::create(unsigned int slots) {
+        // TODO: add config to select the API
+        return std::make_unique<OGLPixelQuery>(slots);
+    }
+
     std::unique_ptr<RenderAPI> RenderAPI::create() {
         // TODO: add config to select the API
         return std::make_unique<OGLRenderAPI>();
@@ -30,11 +54,20 @@ namespace vxe {
         return std::make_unique<OGLShader>();
     }
 
+    void Shader::setBinaryCacheDirectory(const std::string& directory) {
+        OGLProgramCache::setDirectory(directory);
+    }
+
     std::unique_ptr<ShaderStorageBuffer> ShaderStorageBuffer::create(unsigned int index) {
         // TODO: add config to select the API
         return std::make_unique<OGLShaderStorageBuffer>(index);
     }
 
+    std::unique_ptr<UniformBuffer> UniformBuffer::create(unsigned int index, size_t size, unsigned int frames) {
+        // TODO: add config to select the API
+        return std::make_unique<OGLUniformBuffer>(index, size, frames);
+    }
+
     std::unique_ptr<VertexArray> VertexArray::create() {
         // TODO: add config to select the API
         return std::make_unique<OGLVertexArray>();
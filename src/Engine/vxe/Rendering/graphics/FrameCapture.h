@@ -0,0 +1,41 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Framebuffer.h"
+
+namespace vxe {
+    /// @brief A frame read back from the GPU, RGBA8 with the bottom row first.
+    struct CapturedFrame {
+        uint64_t index = 0;
+        uint32_t width = 0, height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    /// @brief Asynchronous readback of rendered frames.
+    ///
+    /// capture() only queues the copy on the GPU, the pixels are fetched by read() a few frames later
+    /// when the copy is done. Each capture occupies one of a fixed number of slots until it was read.
+    class FrameCapture {
+        public:
+            virtual ~FrameCapture() = default;
+
+            /// @brief Queues a copy of the color attachment of source, or of the window's back buffer if source is null.
+            /// @return false if every slot holds a frame that was not read yet.
+            virtual bool capture(const Framebuffer* source, uint32_t width, uint32_t height, uint64_t index) = 0;
+            /// @brief Copies out the oldest captured frame.
+            /// @param wait block until its copy is done instead of returning false
+            /// @return false if nothing was captured or the copy is still running.
+            virtual bool read(CapturedFrame& frame, bool wait) = 0;
+            /// @brief Captured frames that were not read yet.
+            virtual size_t getPendingCount() const = 0;
+
+            static std::unique_ptr<FrameCapture> create(unsigned int slots = 3);
+    };
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vxe {
+    enum class TextureFormat {
+        RGBA8,
+        RGBA16F,
+        RGBA32F,
+        R32F
+    };
+
+    enum class ImageAccess {
+        ReadOnly,
+        WriteOnly,
+        ReadWrite
+    };
+
+    /// @brief Offscreen render target with one or more color attachments and a depth attachment.
+    ///
+    /// Fragment shader output location i is written to color attachment i.
+    class Framebuffer {
+        public:
+            virtual ~Framebuffer() = default;
+
+            /// @brief Directs all following draws into this framebuffer.
+            virtual void bind() const = 0;
+            /// @brief Goes back to the default framebuffer of the window.
+            virtual void unbind() const = 0;
+
+            /// @brief Reallocates the attachments, their previous content is lost.
+            virtual void resize(uint32_t width, uint32_t height) = 0;
+
+            virtual uint32_t getWidth() const = 0;
+            virtual uint32_t getHeight() const = 0;
+            virtual unsigned int getColorAttachment(size_t index = 0) const = 0;
+            virtual size_t getColorAttachmentCount() const = 0;
+            /// @brief Binds a color attachment to a texture unit for sampling, with nearest filtering.
+            virtual void bindColorAttachment(size_t index, unsigned int unit) const = 0;
+            /// @brief Binds a color attachment to an image unit, for image loads and stores in compute programs.
+            /// The image format in the shader has to match the attachment's TextureFormat.
+            virtual void bindColorAttachmentImage(size_t index, unsigned int unit, ImageAccess access) const = 0;
+
+            static std::unique_ptr<Framebuffer> create(uint32_t width, uint32_t height,
+                const std::vector<TextureFormat>& colorFormats = { TextureFormat::RGBA8 });
+    };
+}
+
+#endif
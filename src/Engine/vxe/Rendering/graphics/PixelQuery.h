@@ -0,0 +1,36 @@
+#ifndef PIXEL_QUERY_H
+#define PIXEL_QUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Framebuffer.h"
+
+namespace vxe {
+    /// @brief Asynchronous readback of single pixels, e.g. to find what is under the cursor.
+    ///
+    /// request() only queues the copy of one pixel of every color attachment, read() fetches the values
+    /// once the GPU got there, usually a frame later, without waiting for the frames queued since.
+    class PixelQuery {
+        public:
+            virtual ~PixelQuery() = default;
+
+            /// @brief Queues a copy of the pixel at x, y (bottom row first) of every color attachment of source.
+            /// @return false if every slot holds a request that was not read yet.
+            virtual bool request(const Framebuffer* source, uint32_t x, uint32_t y) = 0;
+            /// @brief Copies out the oldest request, one RGBA value per color attachment. Channels the
+            /// attachment does not have are 0, alpha is 1.
+            /// @return false if nothing was requested or the copy is still running.
+            virtual bool read(std::vector<glm::vec4>& values) = 0;
+            /// @brief Requests that were not read yet.
+            virtual size_t getPendingCount() const = 0;
+
+            static std::unique_ptr<PixelQuery> create(unsigned int slots = 3);
+    };
+}
+
+#endif
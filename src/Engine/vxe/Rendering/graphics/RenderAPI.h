@@ -2,13 +2,25 @@
 #define RENDERAPI_H
 
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <memory>
 
+#include "Shader.h"
+#include "ShaderStorageBuffer.h"
 #include "VertexArray.h"
 #include "../../Core/Window.h"
 
 namespace vxe
 {
+    /// @brief What has to see the writes of earlier shader invocations, combined with |.
+    enum BarrierBits : uint32_t {
+        BARRIER_SHADER_STORAGE = 1 << 0,   // storage buffer reads and writes in shaders
+        BARRIER_SHADER_IMAGE = 1 << 1,     // image loads and stores
+        BARRIER_TEXTURE_FETCH = 1 << 2,    // sampling, e.g. a framebuffer attachment written as an image
+        BARRIER_BUFFER_UPDATE = 1 << 3,    // reading a buffer back on the CPU
+        BARRIER_FRAMEBUFFER = 1 << 4       // drawing into an attachment written as an image
+    };
+
     class RenderAPI {
         public:
             virtual void init(Window* window) = 0;
@@ -16,11 +28,34 @@ namespace vxe
             virtual void clear() = 0;
             virtual void drawVertexArray(const VertexArray* va, unsigned int count) = 0;
             virtual void drawElements(const VertexArray* va, unsigned int count) = 0;
+            /// @brief Runs the bound compute program with the given number of work groups.
+            virtual void dispatchCompute(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ = 1) = 0;
+            /// @brief Orders the writes of earlier draws and dispatches before the accesses in barriers.
+            virtual void memoryBarrier(uint32_t barriers) = 0;
+
+            // Binds that skip what is bound already. Shader::bind() and ShaderStorageBuffer::bindBase() go
+            // through the same cache, only GL calls made around the engine call for resetStateCache().
+            /// @return false if program was bound already and nothing was done
+            virtual bool bindProgram(const Shader* program) = 0;
+            /// @brief Binds buffer to its own binding index.
+            /// @return false if it was bound there already and nothing was done
+            virtual bool bindStorageBuffer(const ShaderStorageBuffer* buffer) = 0;
+            /// @brief Forgets what is bound, the next binds go through. For code that binds with GL calls of its own.
+            virtual void resetStateCache() = 0;
 
             virtual void setClearColor(const glm::vec4& color) = 0;
 
             virtual void swapBuffer(Window* window) = 0;
 
+            // GPU timer queries, only one can be running at a time
+            virtual unsigned int createTimerQuery() = 0;
+            virtual void deleteTimerQuery(unsigned int query) = 0;
+            virtual void beginTimerQuery(unsigned int query) = 0;
+            virtual void endTimerQuery() = 0;
+            /// @brief Reads the elapsed GPU time of a finished query without waiting for it.
+            /// @return false if the result is not available yet.
+            virtual bool getTimerQueryResult(unsigned int query, uint64_t& nanoseconds) = 0;
+
             static std::unique_ptr<RenderAPI> create();
     };
 }
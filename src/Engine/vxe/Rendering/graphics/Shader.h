@@ -2,6 +2,7 @@
 #define SHADER_H
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <glm/glm.hpp>
 
@@ -15,20 +16,38 @@ namespace vxe {
 
             virtual void vertex(const std::string& str, const bool isSrc = false) = 0;
             virtual void fragment(const std::string& str, const bool isSrc = false) = 0;
+            /// @brief Makes this a compute program, which has no other stages.
+            virtual void compute(const std::string& str, const bool isSrc = false) = 0;
 
+            /// @brief Adds a #define after the #version line of every stage, call before compile().
+            /// Defining a name again replaces its value.
+            virtual void define(std::string_view name, std::string_view value = "1") = 0;
             virtual void compile() = 0;
 
-            virtual void setUniform(const std::string& name, const int value) = 0;
-            virtual void setUniform(const std::string& name, const unsigned int value) = 0;
-            virtual void setUniform(const std::string& name, const float value) = 0;
-            virtual void setUniform(const std::string& name, const glm::vec2 value) = 0;
-            virtual void setUniform(const std::string& name, const glm::vec3 value) = 0;
-            virtual void setUniform(const std::string& name, const glm::vec4 value) = 0;
-            virtual void setUniform(const std::string& name, const glm::ivec2 value) = 0;
-            virtual void setUniform(const std::string& name, const glm::ivec3 value) = 0;
-            virtual void setUniform(const std::string& name, const glm::mat4 value) = 0;
+            virtual void setUniform(std::string_view name, const int value) = 0;
+            virtual void setUniform(std::string_view name, const unsigned int value) = 0;
+            virtual void setUniform(std::string_view name, const float value) = 0;
+            virtual void setUniform(std::string_view name, const glm::vec2 value) = 0;
+            virtual void setUniform(std::string_view name, const glm::vec3 value) = 0;
+            virtual void setUniform(std::string_view name, const glm::vec4 value) = 0;
+            virtual void setUniform(std::string_view name, const glm::ivec2 value) = 0;
+            virtual void setUniform(std::string_view name, const glm::ivec3 value) = 0;
+            virtual void setUniform(std::string_view name, const glm::mat4 value) = 0;
+            /// @brief Sets count elements of a uniform array, starting at the first one.
+            virtual void setUniform(std::string_view name, const glm::ivec3* values, size_t count) = 0;
+
+            /// @brief Location of a uniform in the default block, resolved when the program was linked.
+            /// @return -1 if the program has no such active uniform
+            virtual int getUniformLocation(std::string_view name) const = 0;
+
+            /// @brief Time compile() took, loading a cached binary or compiling and linking the sources.
+            virtual double getCompileTimeMs() const = 0;
+            /// @brief True if the last compile() linked the program from the on-disk binary cache.
+            virtual bool isFromBinaryCache() const = 0;
 
             static std::unique_ptr<Shader> create();
+            /// @brief Directory of the program binary cache, an empty path disables it. Defaults to "shader_cache".
+            static void setBinaryCacheDirectory(const std::string& directory);
     };
 }
 
@@ -0,0 +1,97 @@
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+namespace vxe {
+    static constexpr int MAX_INCLUDE_DEPTH = 16;
+
+    static std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            spdlog::error("Failed to open shader include: {0}", path.string());
+            throw std::runtime_error("Failed to open shader include.");
+        }
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    // the quoted path of an #include line, empty if the line is something else
+    static std::string parseInclude(const std::string& line) {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0) return {};
+
+        size_t open = line.find('"', start + 8);
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            spdlog::error("Malformed shader include: {0}", line);
+            throw std::runtime_error("Malformed shader include.");
+        }
+        return line.substr(open + 1, close - open - 1);
+    }
+
+    static void appendFile(PreprocessedShader& result, const std::string& source, size_t fileIndex, int depth) {
+        if (depth > MAX_INCLUDE_DEPTH)
+            throw std::runtime_error("Shader includes nested too deeply.");
+
+        std::istringstream lines(source);
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(lines, line)) {
+            lineNumber++;
+
+            std::string include = parseInclude(line);
+            if (include.empty()) {
+                result.source += line;
+                result.source += '\n';
+                continue;
+            }
+
+            std::filesystem::path path = (result.files[fileIndex].parent_path() / include).lexically_normal();
+            if (std::find(result.files.begin(), result.files.end(), path) != result.files.end()) {
+                result.source += '\n'; // already included, keeps the line count
+                continue;
+            }
+
+            size_t includeIndex = result.files.size();
+            result.files.push_back(path);
+
+            result.source += "#line 1 " + std::to_string(includeIndex) + '\n';
+            appendFile(result, readFile(path), includeIndex, depth + 1);
+            result.source += "#line " + std::to_string(lineNumber + 1) + ' ' + std::to_string(fileIndex) + '\n';
+        }
+    }
+
+    PreprocessedShader resolveShaderIncludes(const std::string& source, const std::filesystem::path& file) {
+        PreprocessedShader result;
+        result.files.push_back(file.lexically_normal());
+        result.source.reserve(source.size());
+
+        appendFile(result, source, 0, 0);
+        return result;
+    }
+
+    std::string injectShaderDefines(const std::string& source, const std::vector<std::pair<std::string, std::string>>& defines) {
+        if (defines.empty()) return source;
+
+        // #version has to stay the first directive, everything else may follow it
+        size_t version = source.find("#version");
+        size_t insertAt = version == std::string::npos ? 0 : source.find('\n', version);
+        insertAt = insertAt == std::string::npos ? source.size() : insertAt + 1;
+
+        int versionLine = version == std::string::npos ? 0 : (int) std::count(source.begin(), source.begin() + version, '\n') + 1;
+
+        std::string block;
+        for (const auto& [name, value] : defines) {
+            block += "#define " + name + ' ' + value + '\n';
+        }
+        block += "#line " + std::to_string(versionLine + 1) + " 0\n";
+
+        std::string result = source;
+        result.insert(insertAt, block);
+        return result;
+    }
+}
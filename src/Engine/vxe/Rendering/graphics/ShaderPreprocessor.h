@@ -0,0 +1,28 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vxe {
+    /// @brief Source of one shader stage with its includes resolved.
+    struct PreprocessedShader {
+        std::string source;
+        // files the source was assembled from, the index is the source string number of #line
+        std::vector<std::filesystem::path> files;
+    };
+
+    /// @brief Replaces every `#include "file"` line with the contents of that file.
+    ///
+    /// Paths are relative to the including file, source without a file resolves them relative to directory.
+    /// Each file is included at most once. #line directives keep compiler messages pointing at the
+    /// original file and line, with the file as the source string number.
+    PreprocessedShader resolveShaderIncludes(const std::string& source, const std::filesystem::path& file);
+
+    /// @brief Returns source with a #define for every entry inserted right after its #version directive.
+    std::string injectShaderDefines(const std::string& source, const std::vector<std::pair<std::string, std::string>>& defines);
+}
+
+#endif
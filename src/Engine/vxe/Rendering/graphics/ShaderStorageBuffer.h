@@ -1,6 +1,7 @@
 #ifndef SHADER_STORAGE_BUFFER
 #define SHADER_STORAGE_BUFFER
 
+#include <cstddef>
 #include <memory>
 
 namespace vxe {
@@ -12,6 +13,14 @@ namespace vxe {
             virtual void bindBase() const = 0;
             virtual void unbind() const = 0;
             virtual void setData(void* data, unsigned int size) = 0;
+            /// @brief Overwrites size bytes at offset, the data store must already be large enough.
+            virtual void updateData(const void* data, size_t offset, size_t size) = 0;
+            /// @brief Sets the whole data store to zero on the GPU.
+            virtual void clear() = 0;
+            /// @brief Reads back the first size bytes of the buffer. Stalls until the GPU is done writing it.
+            virtual void getData(void* data, unsigned int size) const = 0;
+            /// @brief Size of the data store in bytes, as allocated by the last setData().
+            virtual size_t getSize() const = 0;
 
             static std::unique_ptr<ShaderStorageBuffer> create(unsigned int index);
     };
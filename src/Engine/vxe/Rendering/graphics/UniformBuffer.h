@@ -0,0 +1,29 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+namespace vxe {
+    /// @brief Uniform block data that is rewritten every frame.
+    ///
+    /// Each setData() writes into the next of a few regions of the buffer and binds that region, so the
+    /// CPU never overwrites data a frame still in flight is reading.
+    class UniformBuffer {
+        public:
+            virtual ~UniformBuffer() = default;
+
+            /// @brief Copies size bytes into the next region and binds it to the binding point.
+            virtual void setData(const void* data, size_t size) = 0;
+            /// @brief Binds the current region again, e.g. after another buffer took the binding point.
+            virtual void bindBase() const = 0;
+            virtual size_t getSize() const = 0;
+
+            /// @param index the uniform block binding point
+            /// @param size the largest size setData() is called with
+            /// @param frames the number of regions, frames that may be in flight at once
+            static std::unique_ptr<UniformBuffer> create(unsigned int index, size_t size, unsigned int frames = 3);
+    };
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include "FlythroughBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+#include <vxe/Core/Profiler.h>
+
+namespace {
+    struct Summary {
+        size_t samples = 0;
+        double totalMs = 0.0;
+        double averageMs = 0.0;
+        double p50Ms = 0.0, p95Ms = 0.0, p99Ms = 0.0;
+        double worstMs = 0.0;
+        uint32_t worstFrame = 0;
+    };
+
+    // linear interpolation between the closest ranks, same as the VoxelBench reports
+    double percentile(const std::vector<double>& sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        double rank = p * (sorted.size() - 1);
+        size_t low = (size_t) std::floor(rank);
+        size_t high = std::min(low + 1, sorted.size() - 1);
+        return sorted[low] + (sorted[high] - sorted[low]) * (rank - low);
+    }
+
+    // times are in milliseconds, negative ones are frames without a measurement
+    Summary summarize(const std::vector<double>& times) {
+        Summary summary;
+        std::vector<double> sorted;
+        for (uint32_t frame = 0; frame < times.size(); frame++) {
+            if (times[frame] < 0.0) continue;
+
+            sorted.push_back(times[frame]);
+            summary.totalMs += times[frame];
+            if (times[frame] > summary.worstMs) {
+                summary.worstMs = times[frame];
+                summary.worstFrame = frame;
+            }
+        }
+        if (sorted.empty()) return summary;
+
+        std::sort(sorted.begin(), sorted.end());
+        summary.samples = sorted.size();
+        summary.averageMs = summary.totalMs / sorted.size();
+        summary.p50Ms = percentile(sorted, 0.50);
+        summary.p95Ms = percentile(sorted, 0.95);
+        summary.p99Ms = percentile(sorted, 0.99);
+        return summary;
+    }
+
+    void writeSummary(std::ofstream& out, const char* name, const Summary& summary) {
+        out << "  \"" << name << "\": {\"samples\": " << summary.samples << ", \"totalMs\": " << summary.totalMs
+            << ", \"averageMs\": " << summary.averageMs << ", \"p50Ms\": " << summary.p50Ms << ", \"p95Ms\": " << summary.p95Ms
+            << ", \"p99Ms\": " << summary.p99Ms << ", \"worstMs\": " << summary.worstMs << ", \"worstFrame\": " << summary.worstFrame << "},\n";
+    }
+
+    void writeTimes(std::ofstream& out, const char* name, const std::vector<double>& times, bool last) {
+        out << "  \"" << name << "\": [";
+        for (size_t i = 0; i < times.size(); i++) {
+            if (i > 0) out << ", ";
+            if (times[i] < 0.0) out << "null";
+            else out << times[i];
+        }
+        out << "]" << (last ? "\n" : ",\n");
+    }
+}
+
+FlythroughBenchmark::FlythroughBenchmark(CameraPath path, uint32_t frames, uint32_t warmupFrames)
+    : m_path(std::move(path)), m_frames(std::max(frames, 1u)), m_warmupFrames(warmupFrames) {
+    // every measured frame has to still be in the history when the report is written
+    vxe::Profiler& profiler = vxe::Profiler::getInstance();
+    profiler.setEnabled(true);
+    profiler.setHistorySize(std::max<size_t>(profiler.getHistorySize(), m_frames + COOLDOWN_FRAMES + 1));
+}
+
+void FlythroughBenchmark::update(Camera& camera) {
+    if (m_frame == m_warmupFrames)
+        m_firstProfilerFrame = vxe::Profiler::getInstance().getFrameIndex();
+
+    uint32_t measured = m_frame < m_warmupFrames ? 0 : std::min(m_frame - m_warmupFrames, m_frames - 1);
+    float t = m_frames > 1 ? (float) measured / (m_frames - 1) : 0.0f;
+    m_path.apply(camera, t);
+}
+
+bool FlythroughBenchmark::endFrame() {
+    if (!isFinished())
+        m_frame++;
+    return isFinished();
+}
+
+void FlythroughBenchmark::addTraversalStats(const TraversalStats& stats) {
+    if (m_frame < m_warmupFrames || m_frame >= m_warmupFrames + m_frames) return;
+
+    m_traversal.brickSteps += stats.brickSteps;
+    m_traversal.voxelSteps += stats.voxelSteps;
+    m_traversal.beamSteps += stats.beamSteps;
+    m_traversal.pixels += stats.pixels;
+    m_traversal.reprojectedPixels += stats.reprojectedPixels;
+    m_traversal.retracedPixels += stats.retracedPixels;
+}
+
+bool FlythroughBenchmark::writeReport(const std::string& path, const Info& info) const {
+    std::vector<double> cpuTimes(m_frames, -1.0), gpuTimes(m_frames, -1.0);
+    for (const auto& frame : vxe::Profiler::getInstance().getHistory()) {
+        if (frame.index < m_firstProfilerFrame || frame.index >= m_firstProfilerFrame + m_frames) continue;
+
+        size_t i = frame.index - m_firstProfilerFrame;
+        cpuTimes[i] = frame.duration / 1e6;
+        if (!frame.gpuZones.empty()) {
+            double gpuMs = 0.0;
+            for (const auto& zone : frame.gpuZones) gpuMs += zone.duration / 1e6;
+            gpuTimes[i] = gpuMs;
+        }
+    }
+
+    Summary cpu = summarize(cpuTimes);
+    Summary gpu = summarize(gpuTimes);
+
+    std::ofstream out(path);
+    if (!out) {
+        spdlog::error("Failed to open '{}' for the benchmark report.", path);
+        return false;
+    }
+
+    out.precision(4);
+    out << std::fixed;
+    out << "{\n  \"benchmark\": \"flythrough\",\n";
+    out << "  \"grid\": \"" << info.grid << "\",\n  \"features\": [";
+    for (size_t i = 0; i < info.features.size(); i++) {
+        out << (i > 0 ? ", " : "") << "\"" << info.features[i] << "\"";
+    }
+    out << "],\n";
+    out << "  \"width\": " << info.width << ",\n  \"height\": " << info.height << ",\n";
+    out << "  \"headless\": " << (info.headless ? "true" : "false") << ",\n";
+    out << "  \"renderScale\": " << info.renderScale << ",\n";
+    out << "  \"dynamicResolution\": " << (info.dynamicResolution ? "true" : "false") << ",\n";
+    out << "  \"viewDistance\": " << info.viewDistance << ",\n";
+    out << "  \"frames\": " << m_frames << ",\n  \"warmupFrames\": " << m_warmupFrames << ",\n";
+    writeSummary(out, "cpu", cpu);
+    writeSummary(out, "gpu", gpu);
+    if (m_traversal.pixels > 0) {
+        double pixels = (double) m_traversal.pixels;
+        out << "  \"traversal\": {\"pixels\": " << m_traversal.pixels << ", \"brickStepsPerPixel\": " << m_traversal.brickSteps / pixels
+            << ", \"voxelStepsPerPixel\": " << m_traversal.voxelSteps / pixels << ", \"beamStepsPerPixel\": " << m_traversal.beamSteps / pixels
+            << ", \"reprojectedFraction\": " << m_traversal.reprojectedPixels / pixels
+            << ", \"retracedFraction\": " << m_traversal.retracedPixels / pixels << "},\n";
+    }
+    writeTimes(out, "cpuTimesMs", cpuTimes, false);
+    writeTimes(out, "gpuTimesMs", gpuTimes, true);
+    out << "}\n";
+
+    spdlog::info("Benchmark: {} frames in {:.1f} ms. CPU p50 {:.3f} / p95 {:.3f} / p99 {:.3f} / worst {:.3f} ms (frame {}). GPU p50 {:.3f} / p95 {:.3f} / p99 {:.3f} / worst {:.3f} ms.",
+        cpu.samples, cpu.totalMs, cpu.p50Ms, cpu.p95Ms, cpu.p99Ms, cpu.worstMs, cpu.worstFrame, gpu.p50Ms, gpu.p95Ms, gpu.p99Ms, gpu.worstMs);
+    if (gpu.samples < m_frames)
+        spdlog::warn("Benchmark: {} of {} frames have no GPU time.", m_frames - gpu.samples, m_frames);
+    if (m_traversal.pixels > 0) {
+        double pixels = (double) m_traversal.pixels;
+        spdlog::info("Benchmark: {:.2f} brick steps, {:.2f} voxel steps and {:.3f} beam steps per pixel.",
+            m_traversal.brickSteps / pixels, m_traversal.voxelSteps / pixels, m_traversal.beamSteps / pixels);
+        if (m_traversal.reprojectedPixels > 0)
+            spdlog::info("Benchmark: {:.1f}% of the pixels started at the reprojected surface, {:.1f}% had to be traced again.",
+                100.0 * m_traversal.reprojectedPixels / pixels, 100.0 * m_traversal.retracedPixels / pixels);
+    }
+    spdlog::info("Wrote benchmark report to '{}'.", path);
+    return true;
+}
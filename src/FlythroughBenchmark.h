@@ -0,0 +1,65 @@
+#ifndef FLYTHROUGH_BENCHMARK_H
+#define FLYTHROUGH_BENCHMARK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Rendering/Camera.h"
+#include "Rendering/CameraPath.h"
+
+/// @brief Reproducible frame times from a scripted flight over the world.
+///
+/// The camera only depends on the frame number, never on the wall clock, so every run renders the same
+/// images. Warmup frames wait at the start of the path and are not measured, the cooldown frames at its
+/// end give the GPU timer queries of the last measured frames time to resolve.
+/// CPU time is the time between two Profiler frames, GPU time the sum of the frame's GPU zones.
+class FlythroughBenchmark {
+    public:
+        static constexpr uint32_t COOLDOWN_FRAMES = 8;
+        static constexpr float FRAME_TIME = 1.0f / 60.0f; // simulated time per frame
+
+        /// @brief Describes the run in the report.
+        struct Info {
+            std::string grid;
+            std::vector<std::string> features;
+            uint32_t width, height;
+            bool headless;
+            float renderScale;      // the largest scale with dynamic resolution
+            bool dynamicResolution;
+            float viewDistance = 0.0f; // of the orbit the camera took, 0 for the flythrough
+        };
+
+        /// @brief Counters of the raymarch traversal, see traversalStats in common/raymarch.glsl.
+        struct TraversalStats {
+            uint64_t brickSteps = 0, voxelSteps = 0, beamSteps = 0, pixels = 0;
+            uint64_t reprojectedPixels = 0; // rays that started at the previous frame's surface
+            uint64_t retracedPixels = 0;    // of those, rays that missed and were traced again from the start
+        };
+
+        FlythroughBenchmark(CameraPath path, uint32_t frames, uint32_t warmupFrames);
+
+        /// @brief Places the camera for the current frame, call before rendering it.
+        void update(Camera& camera);
+        /// @brief Call after the frame was presented.
+        /// @return true once every frame including the cooldown was rendered.
+        bool endFrame();
+        bool isFinished() const { return m_frame >= m_warmupFrames + m_frames + COOLDOWN_FRAMES; }
+        /// @brief Adds the traversal steps of the current frame, they are reported per pixel over the measured frames.
+        void addTraversalStats(const TraversalStats& stats);
+
+        /// @brief Simulated seconds since the start, use instead of the wall clock for anything animated.
+        float getTime() const { return m_frame * FRAME_TIME; }
+
+        /// @brief Writes the percentiles and per-frame times of the measured frames as JSON.
+        bool writeReport(const std::string& path, const Info& info) const;
+
+    private:
+        CameraPath m_path;
+        uint32_t m_frames, m_warmupFrames;
+        uint32_t m_frame = 0;
+        uint64_t m_firstProfilerFrame = 0;
+        TraversalStats m_traversal;
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "Camera.h"
 
+#include <cmath>
+
 Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch) : front(glm::vec3(0.0f, 0.0f, -1.0f)), movementSpeed(SPEED), mouseSensitivity(SENSITIVITY), zoom(ZOOM) {
     this->position = position;
     this->worldUp = up;
@@ -77,6 +79,19 @@ void Camera::processMouseScroll(float yoffset) {
     }
 }
 
+void Camera::lookAt(const glm::vec3& target) {
+    glm::vec3 direction = target - position;
+    if (glm::length(direction) < 1e-6f) {
+        return;
+    }
+    direction = glm::normalize(direction);
+
+    yaw = glm::degrees(std::atan2(direction.z, direction.x));
+    pitch = glm::clamp(glm::degrees(std::asin(direction.y)), -89.0f, 89.0f);
+
+    updateCameraVectors();
+}
+
 void Camera::updateCameraVectors() {
     glm::vec3 newFront;
     newFront.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
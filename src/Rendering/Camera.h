@@ -49,6 +49,9 @@ public:
     void processMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true);
 
     void processMouseScroll(float yoffset);
+
+    // turns the camera towards target without moving it
+    void lookAt(const glm::vec3& target);
 };
 
 #endif // CAMERA_H
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <glm/gtc/constants.hpp>
+
+static glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+CameraPath::CameraPath(std::vector<Key> keys) : keys(std::move(keys)) {
+    if (this->keys.size() < 2) {
+        throw std::runtime_error("A camera path needs at least two keys.");
+    }
+}
+
+void CameraPath::apply(Camera& camera, float t) const {
+    // the spline passes through every key, the segments are spent equal time in
+    float position = glm::clamp(t, 0.0f, 1.0f) * (keys.size() - 1);
+    size_t segment = std::min((size_t) position, keys.size() - 2);
+    float local = position - segment;
+
+    // the end keys are repeated so that the curve still starts and ends on them
+    const Key& k0 = keys[segment == 0 ? 0 : segment - 1];
+    const Key& k1 = keys[segment];
+    const Key& k2 = keys[segment + 1];
+    const Key& k3 = keys[std::min(segment + 2, keys.size() - 1)];
+
+    camera.position = catmullRom(k0.position, k1.position, k2.position, k3.position, local);
+    camera.lookAt(catmullRom(k0.target, k1.target, k2.target, k3.target, local));
+}
+
+CameraPath CameraPath::flythrough(const glm::vec3& worldSize) {
+    // in fractions of the world, the terrain surface is at most a quarter of the world high
+    const std::vector<Key> tour = {
+        { glm::vec3(0.15f, 0.30f, 0.15f), glm::vec3(0.50f, 0.15f, 0.50f) },
+        { glm::vec3(0.50f, 0.28f, 0.10f), glm::vec3(0.50f, 0.10f, 0.60f) },
+        { glm::vec3(0.85f, 0.35f, 0.20f), glm::vec3(0.40f, 0.10f, 0.50f) },
+        { glm::vec3(0.85f, 0.30f, 0.80f), glm::vec3(0.20f, 0.20f, 0.50f) },
+        { glm::vec3(0.45f, 0.60f, 0.90f), glm::vec3(0.50f, 0.00f, 0.40f) },
+        { glm::vec3(0.10f, 0.32f, 0.60f), glm::vec3(0.90f, 0.25f, 0.50f) },
+        { glm::vec3(0.30f, 0.28f, 0.35f), glm::vec3(0.60f, 0.20f, 0.20f) },
+    };
+
+    std::vector<Key> keys;
+    keys.reserve(tour.size());
+    for (const Key& key : tour) {
+        keys.push_back({ key.position * worldSize, key.target * worldSize });
+    }
+    return CameraPath(std::move(keys));
+}
+
+CameraPath CameraPath::orbit(const glm::vec3& center, float distance, float height) {
+    // eight segments are close enough to a circle, the last key closes it on the first
+    const int segments = 8;
+
+    std::vector<Key> keys;
+    keys.reserve(segments + 1);
+    for (int i = 0; i <= segments; i++) {
+        float angle = 2.0f * glm::pi<float>() * i / segments;
+        glm::vec3 offset(std::cos(angle) * distance, 0.0f, std::sin(angle) * distance);
+        keys.push_back({ glm::vec3(center.x, height, center.z) + offset, center });
+    }
+    return CameraPath(std::move(keys));
+}
@@ -0,0 +1,35 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+
+// A scripted camera flight: a Catmull-Rom spline through key positions, each with a point to look at.
+class CameraPath {
+public:
+    struct Key {
+        glm::vec3 position;
+        glm::vec3 target;
+    };
+
+    explicit CameraPath(std::vector<Key> keys);
+
+    // moves and turns the camera to where it is at t in [0, 1], t = 0 is the first key and t = 1 the last
+    void apply(Camera& camera, float t) const;
+
+    // tour over a world of the given size in voxels, covering close-ups over the terrain, views along
+    // the horizon and looking down from above
+    static CameraPath flythrough(const glm::vec3& worldSize);
+
+    // one circle at a fixed distance from center, looking at it the whole time, for measuring what a
+    // view distance costs
+    static CameraPath orbit(const glm::vec3& center, float distance, float height);
+
+private:
+    std::vector<Key> keys;
+};
+
+#endif // CAMERA_PATH_H
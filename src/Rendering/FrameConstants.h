@@ -0,0 +1,39 @@
+#ifndef FRAME_CONSTANTS_H
+#define FRAME_CONSTANTS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/// @brief Uniforms shared by all raymarch programs, uploaded once per frame.
+///
+/// Laid out by the std140 rules, must match assets/shader/common/frame_constants.glsl.
+/// A vec3 takes 16 bytes unless a scalar follows it, so the members are ordered to fill those gaps.
+struct FrameConstants {
+    static constexpr unsigned int BINDING = 0;
+
+    glm::mat4 invViewProj;
+    glm::vec3 cameraPos;
+    float time;
+    glm::vec3 lightPos;
+    float voxelScale;
+    glm::vec3 lightColor;
+    float lightIntensity;
+    glm::vec2 resolution;
+    float pixelAngle;       // world-space size of a pixel at unit distance
+    uint32_t frameIndex;    // counts up every frame, picks the pixels that skip reprojection
+    glm::mat4 prevViewProj; // of the frame in the history target
+    glm::vec2 prevResolution; // render size of that frame, 0 without a history
+    int32_t padding1[2];    // blocks are padded to a multiple of 16 bytes
+};
+
+static_assert(offsetof(FrameConstants, cameraPos) == 64, "FrameConstants does not match std140");
+static_assert(offsetof(FrameConstants, lightPos) == 80, "FrameConstants does not match std140");
+static_assert(offsetof(FrameConstants, lightColor) == 96, "FrameConstants does not match std140");
+static_assert(offsetof(FrameConstants, resolution) == 112, "FrameConstants does not match std140");
+static_assert(offsetof(FrameConstants, prevViewProj) == 128, "FrameConstants does not match std140");
+static_assert(offsetof(FrameConstants, prevResolution) == 192, "FrameConstants does not match std140");
+static_assert(sizeof(FrameConstants) == 208, "FrameConstants does not match std140");
+
+#endif